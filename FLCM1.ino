@@ -45,6 +45,19 @@
 #include "mcp25625_can.h"     // CAN control
 #include "FLCM1_IO.h"         // screen, flash, settings, SW, beep
 #include "FL_melody.h"        // for piezo buzzer
+#include "FL_canring.h"       // CAN frame ring buffer
+#include "FL_timebase.h"      // microsecond timebase for frame timestamps
+#include "FL_swfstats.h"       // per-SWF running statistics
+#include "FL_idtable.h"        // per-ID traffic table
+#include "FL_busload.h"        // bus load estimator
+#include "FL_trace.h"          // per-ID trace view
+#include "FL_linefmt.h"        // fixed buffer line formatter
+#include "FL_msgfmt.h"         // monitor line format of a CAN frame
+#include "FL_tftline.h"        // DMA line renderer for the monitor
+#include "FL_rulevm.h"         // compound comparator rules
+#include "FL_pwmout.h"         // PWM/frequency comparator outputs
+#include "FL_swfplan.h"         // SWF extraction plan
+#include "FL_comparator.h"      // comparator step, critical CO fast path
 
 // SPI sercom port settings
 #define TFT_MISO    PA16
@@ -110,6 +123,8 @@ Adafruit_ILI9341 tft = Adafruit_ILI9341(&tftSPI, PIN_TFT_DC, PIN_TFT_CS);
 Display disp = Display(&tft, &setMan, 240, 320, 20, 20);
                 // Adafruit_ILI9341* tft, int width, int height, int titleH, int listItemH
 #define INITLOGOTIME    500   // in ms
+#define TRACEREFRESHPERIOD  50  // in ms (20Hz) trace表示の描画周期
+TraceView trace(&tft, ILI9341_WHITE, BACKGROUNDCOLOR);
 
 // ***** Touch SPI definitions
 #define PIN_TOUCH_CS    PA23
@@ -128,27 +143,37 @@ Display disp = Display(&tft, &setMan, 240, 320, 20, 20);
 #define CAN_2515
 #define PIN_MCP_CS      PA07
 #define CAN_INT         PB09
+#define MCP_RX_DMA      1     // 1:RXバッファをDMAで読出 0:CPUのbyte転送で読出
+#if MCP_RX_DMA
+#define CAN_INT_MODE    LOW   // DMA読出中は割込禁止にするのでレベル検出で取りこぼさない
+#else
+#define CAN_INT_MODE    FALLING
+#endif
+#define CAN_EIC_MASK    EIC_INTENSET_EXTINT(1ul << digitalPinToInterrupt(CAN_INT))
 mcp25625_can CAN(PIN_MCP_CS); // Make CAN object and Set CS pin
-volatile int8_t canrxIntFlag = 0;
+CanFrameRing canRing;         // ISR -> loop CAN frame ring
 canSoftwareFilteredValueSet canFiltVal;  // CAN software filtered value set
+canSoftwareFilterPlanSet swfPlan;        // compiled CAN software filter
 
 #define CANIDDIGIT3     3     // in Hex
-#define CANIDDIGIT8     8     // in Hex
 #define HEXDIGIT3       "%03X"
 #define HEXDIGIT8       "%08X"
-
-// ***** CAN definitions
-// CAN isr
-void MCP25625_ISR() {
-  canrxIntFlag = 1;
-}
+#define MONITOR_TIMESTAMP 0   // 1: モニター表示の各行先頭に受信時刻[ms]を付ける
+#define MONITOR_DELTA_HL  1   // 1: 変化表示モードで変化したbyteを強調色で表示する
+#define CANLOG_SERIAL   0     // 1: 受信フレームを受信時刻付きでSerialへ出力
 
 // ***** SD  SPI definitions
 #define PIN_SD_CS       PB08
 
 // ***** AUX SPI definitions
 #define PIN_AUX_CS      PA13
-byte buf_aux[MAX_CHAR_IN_MESSAGE];
+#define AUX_TIMESTAMP   0     // 1: AUX出力の先頭に受信時刻[us]を付加 (byte orderはAOSBOに従う)
+#if AUX_TIMESTAMP
+#define AUXTSLEN        4     // timestamp byte length
+#else
+#define AUXTSLEN        0
+#endif
+byte buf_aux[AUXTSLEN + MAX_CHAR_IN_MESSAGE];
 
 // ***** Comparator Output definitions
 #define PIN_CO0         PA11
@@ -157,6 +182,58 @@ byte buf_aux[MAX_CHAR_IN_MESSAGE];
 #define PIN_CO3         PA08
 #define PIN_COCOUNT     (4) // The number of CO
 const int outputPorts_CO[PIN_COCOUNT] = {PIN_CO0, PIN_CO1, PIN_CO2, PIN_CO3};
+#if PIN_COCOUNT > COOUTMAX
+#error "PIN_COCOUNT must be COOUTMAX or less"
+#endif
+// 出力状態 (critical COはCAN受信割込からも書く) latencyMaxは'r'でクリア
+comparatorOutputState coOut = {{-1, -1, -1, -1}, {0}, {0}, {0}};
+// Comparator plan (設定変更時にcompileComparators()で作成, plan.portはcoPlan.port[]のindex)
+struct comparatorPlanSet{
+  comparatorPlan plan[PIN_COCOUNT];   // 有効なCOだけをSWF番号順に詰めて格納
+  uint8_t count;
+  uint8_t first[SWFCOUNT];            // 0:このSWFを見ているCOなし n:plan[n-1]から同じSWFのplanが続く
+  PortGroup* port[COPORTMAX];
+  uint8_t portCount;
+  uint8_t ruleFirst;                  // 0:複合条件のCOなし n:plan[n-1]から最後までruleのplan
+};
+comparatorPlanSet coPlan;
+// 複合条件 (DeviceSettings.coRuleのテキストをcompileComparators()でbytecodeにする)
+#define CORULESWF       0xFF  // comparatorPlan.swfNum: 複合条件
+#define RULEBENCHLOOPS  1000
+#if SWFCOUNT > RULESWFMAX
+#error "SWFCOUNT must be RULESWFMAX or less"
+#endif
+RuleProgram coRule[PIN_COCOUNT];
+swfMask_t coSwfSeen;                      // 一度でも値を抽出したSWF
+// critical CO (COCR=1) はcoPlanに入れず、CAN受信割込でevalCriticalComparators()が判定する
+struct criticalComparatorSet{
+  criticalComparator crit[PIN_COCOUNT];
+  volatile uint8_t count;
+};
+criticalComparatorSet coCrit;             // ISRが使う。loopからの書換えは割込禁止中に行う
+volatile uint32_t critIsrMax = 0;         // fast pathの最大実行時間 [us] 'r'でクリア
+volatile uint32_t critIsrCount = 0;       // fast pathでIDが一致したフレーム数
+void evalCriticalComparators(const canMessageSet &msg);   // CAN受信割込から呼ぶ (定義はSWFの後)
+// PWM/frequency CO (COOT != COOT_DIGITAL) はcoPlanに入れず、SWFの値をTCCのduty/周波数にする
+// COUSFのSWFが抽出される毎にbuffer registerを書くだけで、波形はTCCが作る
+struct pwmOutputPlan{
+  int64_t base;         // COTRS: 0% (0Hz)
+  int64_t top;          // COTRS + COSP: 100% (COFS)
+  uint32_t span;        // COSP
+  uint32_t fullFreq;    // COFS [Hz]
+  int8_t ch;            // PwmOutputのchannel
+  uint8_t outType;      // COOT_PWM/COOT_FREQ
+  uint8_t coNum;
+  uint8_t swfNum;       // COUSF (複合条件は使わない)
+  bool invert;          // COPOL
+};
+struct pwmOutputPlanSet{
+  pwmOutputPlan plan[PIN_COCOUNT];
+  uint8_t count;
+  swfMask_t swfs;       // planのあるSWF
+};
+pwmOutputPlanSet coPwm;
+PwmOutput pwmOut;
 
 // ***** SW definitions
 #define PIN_SWA         PB23 // Digital Output
@@ -196,6 +273,35 @@ MelodyPlayer mplay(PIN_PZ);
 #define ERRDETPERIOD    100    // in ms
 uint8_t mcp_error = 0;
 
+// ***** Diagnostics definitions
+#define DIAGDISPPERIOD  500     // in ms
+#define DIAGCMD_DUMP    'd'     // Serial command: dump counters
+#define DIAGCMD_RESET   'r'     // Serial command: reset counters and SWF statistics
+#define DIAGCMD_STATS   's'     // Serial command: toggle SWF statistics streaming
+#define DIAGCMD_IDS     'i'     // Serial command: dump ID traffic table
+#define DIAGCMD_COCLR   'c'     // Serial command: release latched/toggled CO outputs
+#define DIAGCMD_RULE    'R'     // Serial command: "R<co> <rule>" + LF set CO rule ("R<co>" clears)
+#define DIAGCMD_RULES   'L'     // Serial command: list CO rules
+#define DIAGCMD_BENCH   'b'     // Serial command: measure CO rule evaluation time
+#define DIAGCMD_CRITBENCH 'w'   // Serial command: measure critical CO worst case ISR time
+#define STATSTREAMPERIOD 1000   // in ms
+// 受信経路の段毎の取りこぼし/処理数 (ring側の数はcanRingが持つ)
+struct rxDiagCounters{
+  uint32_t rx0Ovr;    // MCP RXB0 overrun (EFLG RX0OVR) ERRDETPERIOD毎に1回まで数える
+  uint32_t rx1Ovr;    // MCP RXB1 overrun (EFLG RX1OVR)
+  uint32_t dispDrop;  // 表示停止中に表示しなかった行数 (描画が追いつかず捨てた行数はdispが持つ)
+  uint32_t auxDrop;   // AUX DMA送信中で送れなかった数
+  uint32_t coEval;    // comparator評価回数
+};
+rxDiagCounters diagCnt;
+SignalStats swfStats[SWFCOUNT];   // SWF毎の逐次統計
+int statSwf = 0;                  // SWF STAT pageで表示中のSWF番号
+bool fStatStream = false;         // SerialへSWF統計を周期出力する
+CanIdTable idTable;               // CAN ID毎の受信状況
+eIdSortKey idSortKey = IDSORT_COUNT;  // ID TRAFFIC pageの並び順
+int idTop = 0;                    // ID TRAFFIC pageの先頭に表示する順位
+BusLoadMeter busLoad;             // bus load/frames per second
+
 // ***** DEBUG definitions
 volatile bool error = false;
 unsigned char PID_INPUT;
@@ -204,35 +310,52 @@ unsigned char getPid    = 0;
 // ***** DMA definitions
 #define DATA_LENGTH 16
 #define TRANSFER_LENGTH 8
+#define MCPRXDMA_LENGTH (MCP_RXBUF_RAWLEN + 1)  // instruction + SIDH..D7
 Adafruit_ZeroDMA auxDMA;
 DmacDescriptor *auxDMA_dsc;
+Adafruit_ZeroDMA mcpsdTxDMA, mcpsdRxDMA;
+Adafruit_ZeroDMA tftDMA;
 
 uint8_t tftDMA_srcmem[DATA_LENGTH];
 //uint8_t touchDMA_srcmem[DATA_LENGTH];
 uint8_t mcpsdDMA_srcmem[DATA_LENGTH];
+uint8_t mcpsdDMA_dstmem[DATA_LENGTH];
 uint8_t auxDMA_srcmem[DATA_LENGTH];
 volatile bool tftDMA_done = true;
 //volatile bool touchDMA_done = true;
 volatile bool mcpsdDMA_done = true;
+volatile byte mcpRxFilhit = 0;      // DMA読出中のRXバッファのfilter hit
+volatile uint32_t mcpRxTime = 0;    // DMA読出中のRXバッファの受信時刻 [us]
 volatile bool auxDMA_done = true;
+// CSは最後のbyteのシフトアウト後にTftLineRenderer::wait()が上げる
 void tftdma_callback([[maybe_unused]] Adafruit_ZeroDMA *dma) {
-  // CS disabled (more faster descriptyon than digitalWrite)
-  digitalPinToPort(PIN_TFT_CS)->OUTSET.reg = digitalPinToBitMask(PIN_TFT_CS);
-  auxDMA_done = true;
+  tftDMA_done = true;
 }
+#define TFT_LINE_DMA    1     // 1:モニター表示の1行をline buffer + DMAで描く 0:Adafruit_GFXのprintln
+TftLineRenderer tftLine(&tft, &tftDMA, SERCOM1, &tftDMA_done);   // tftSPI = sercom1
 void mcpsddma_callback([[maybe_unused]] Adafruit_ZeroDMA *dma) {
   // CS disabled (more faster descriptyon than digitalWrite)
   if((digitalPinToPort(PIN_MCP_CS)->OUT.reg & digitalPinToBitMask(PIN_MCP_CS)) == 0){
-    digitalPinToPort(PIN_MCP_CS)->OUTSET.reg = digitalPinToBitMask(PIN_MCP_CS);
+    digitalPinToPort(PIN_MCP_CS)->OUTSET.reg = digitalPinToBitMask(PIN_MCP_CS);  // RXnIF is cleared
+    // 読み出したRXバッファをringへ。commit後のslotはloopが読むので、critical COは手元のcopyで判定する
+    canMessageSet msg;
+    CAN.parseRxBuffer(&mcpsdDMA_dstmem[1], &msg);
+    msg.filhit = mcpRxFilhit;
+    msg.timestamp = mcpRxTime;
+    *canRing.reserve() = msg;
+    canRing.commit();
+    mcpsdDMA_done = true;
+    mcpsdSPI.endTransaction();    // CAN割込許可、次のフレームがあれば再度MCP25625_ISR
+    evalCriticalComparators(msg); // ring満杯で読み捨てたフレームも判定する
   }
   else if((digitalPinToPort(PIN_SD_CS)->OUT.reg & digitalPinToBitMask(PIN_SD_CS)) == 0){
     digitalPinToPort(PIN_SD_CS)->OUTSET.reg = digitalPinToBitMask(PIN_SD_CS);
+    mcpsdDMA_done = true;
   }
   else{
     error = true;
     return;
   }
-  auxDMA_done = true;
 }
 void auxdma_callback([[maybe_unused]] Adafruit_ZeroDMA *dma) {
   // CS disabled (more faster descriptyon than digitalWrite)
@@ -240,12 +363,79 @@ void auxdma_callback([[maybe_unused]] Adafruit_ZeroDMA *dma) {
   auxDMA_done = true;
 }
 
+// ***** CAN RX definitions
+#define MCPRXBUFCOUNT   2     // RXB0, RXB1
+volatile bool mcpRxHeld = false;    // loop側がMCPを使用中
+
+#if MCP_RX_DMA
+// READ RX BUFFER 1回分(14byte)をDMAで送受信する。完了はmcpsddma_callback
+void startMcpRxDMA(byte instruction){
+  mcpsdDMA_srcmem[0] = instruction;
+  mcpsdDMA_done = false;
+  mcpsdSPI.beginTransaction(MCP25625_SPI_SETTINGS);   // DMA完了までCAN割込禁止
+  digitalPinToPort(PIN_MCP_CS)->OUTCLR.reg = digitalPinToBitMask(PIN_MCP_CS);
+  mcpsdRxDMA.startJob();
+  mcpsdTxDMA.startJob();
+}
+#endif
+
+// CAN isr
+// MCP_RX_DMA 1: Lowレベル割込。RXバッファ1個分のDMA読出を開始し、残りは完了後の再割込で読む
+// MCP_RX_DMA 0: MCPのRXバッファが空になるまでringへ吸い上げる。空にしないとINTがLowのままで次の立下りが来ない
+// どちらもRX STATUS 1回で受信順に読むバッファを決める (RXF2-5のRXB1直行はRX STATUS毎の変化で順序を追う)
+// 受信時刻はISR入口で取る。2フレーム目以降は先のフレームの読出待ちの分だけ遅れた時刻になる
+// loop側のMCPアクセスはmcpsdSPI.usingInterrupt()によりトランザクション中この割込が禁止される
+void MCP25625_ISR() {
+  uint32_t now = timebaseNow();
+#if MCP_RX_DMA
+  if(mcpRxHeld){                        // releaseMcpRx()で再開
+    EIC->INTENCLR.reg = CAN_EIC_MASK;
+    return;
+  }
+  byte filhit;
+  byte instruction = CAN.selectRxBuffer(CAN.readRxStatus(), &filhit);
+  if(instruction != 0){
+    mcpRxFilhit = filhit;
+    mcpRxTime = now;
+    startMcpRxDMA(instruction);
+  }
+#else
+  canMessageSet batch[MCPRXBUFCOUNT];
+  byte n;
+  while ((n = CAN.readMsgBatch(batch, MCPRXBUFCOUNT)) > 0){
+    for(byte i = 0; i < n; i++){
+      batch[i].timestamp = now;
+      *canRing.reserve() = batch[i];
+      canRing.commit();
+      evalCriticalComparators(batch[i]);
+    }
+  }
+#endif
+}
+
+// loop側でMCPにアクセスする前後に呼ぶ。DMA読出中のSPIバスに割り込まないようにする
+void holdMcpRx(){
+  mcpRxHeld = true;
+#if MCP_RX_DMA
+  while(!mcpsdDMA_done);                // 実行中のDMA読出の完了待ち
+#endif
+}
+void releaseMcpRx(){
+  mcpRxHeld = false;
+#if MCP_RX_DMA
+  EIC->INTENSET.reg = CAN_EIC_MASK;     // RX待ちがあればLowレベル割込で再開
+#endif
+}
+
 // ***** Interval timer definitions
 IntervalTimer swDetTimer(SWDETPERIOD);      // push switches,touch detection timer
 IntervalTimer adDetTimer(ADDETPERIOD);      // A/D detection timer
 IntervalTimer pushDelay(PUSHDELAYTIME);     // push switches
 IntervalTimer touchDelay(TOUCHDELAYTIME);   // touch detection
 IntervalTimer errDetTimer(ERRDETPERIOD);    // error detection
+IntervalTimer diagDispTimer(DIAGDISPPERIOD); // diagnostics page refresh
+IntervalTimer statStreamTimer(STATSTREAMPERIOD); // SWF statistics streaming
+IntervalTimer traceTimer(TRACEREFRESHPERIOD); // trace view refresh
 
 
 // **************************************************************************************
@@ -421,22 +611,51 @@ void auxSend(uint8_t *buf, uint8_t len){
   }
   else{
     error = true;
+    diagCnt.auxDrop++;
     DEBUG_PRINTLN("auxSend ERROR");
   }
 }
 
-void auxSend_filtered(int64_t value, uint8_t len){
+// copying value to dst with the AOSBO byte order
+void auxPackValue(uint8_t *dst, int64_t value, uint8_t len, bool byteOrder){
+  for(int i = 0; i < len; i++){
+    if(byteOrder) dst[i] = (value >> i * 8) & 0x0ff;// little endian to send out
+    else dst[len - 1 - i] = (value >> i * 8) & 0x0ff;// big endian to send out
+  }
+}
+
+// send a received CAN msg (HWF output)
+void auxSend_frame(canMessageSet &msgSet){
+#if AUX_TIMESTAMP
+  if(auxDMA_done){
+    bool byteOrder = setMan.getSettingValue(AOSET, DS_AOSBO_POS);
+    auxPackValue(buf_aux, msgSet.timestamp, AUXTSLEN, byteOrder);
+    memcpy(&buf_aux[AUXTSLEN], msgSet.buf, msgSet.len);
+    auxSend(buf_aux, AUXTSLEN + msgSet.len);  // send out buf to aux output
+  }
+  else{
+    error = true;
+    diagCnt.auxDrop++;
+    DEBUG_PRINTLN("auxSend_frame ERROR");
+  }
+#else
+  auxSend(msgSet.buf, msgSet.len);
+#endif
+}
+
+void auxSend_filtered(int64_t value, uint8_t len, [[maybe_unused]] uint32_t timestamp){
   if(auxDMA_done){
     bool byteOrder = setMan.getSettingValue(AOSET, DS_AOSBO_POS);
     // copying data to the DMA transmission source_memory
-    for(int i = 0; i < len; i++){
-      if(byteOrder) buf_aux[i] = (value >> i * 8) & 0x0ff;// little endian to send out
-      else buf_aux[len - 1 - i] = (value >> i * 8) & 0x0ff;// big endian to send out
-    }
-    auxSend(buf_aux, len);  // send out buf to aux output
+#if AUX_TIMESTAMP
+    auxPackValue(buf_aux, timestamp, AUXTSLEN, byteOrder);
+#endif
+    auxPackValue(&buf_aux[AUXTSLEN], value, len, byteOrder);
+    auxSend(buf_aux, AUXTSLEN + len);  // send out buf to aux output
   }
   else{
     error = true;
+    diagCnt.auxDrop++;
     DEBUG_PRINTLN("auxSend_filtered ERROR");
   }
 }
@@ -457,15 +676,363 @@ void outputCOwithPolarity(int coNum, bool lowHigh){
   }
 }
 
-void calcComparaterOut(int64_t value, int swfNum){
-  for (int coNum = 0; coNum < PIN_COCOUNT; coNum++){
-    if(setMan.getSettingValue(COSW, coNum) == true && setMan.getSettingValue(COUSF, coNum) == swfNum){
-      int64_t trs = setMan.getSettingAnyvalue(COTRS, coNum);
-      DEBUG2_PRINT("trs, CO value=");DEBUG2_PRINT(trs);DEBUG2_PRINT(", ");DEBUG2_PRINTLN(value);
-      if(value >= trs) outputCOwithPolarity(coNum, HIGH);
-      else outputCOwithPolarity(coNum, LOW);
+// COの設定からSWF毎のcomparator planを作る。設定が変わった時に呼ぶ
+// COの設定をplanに入れる (判定に使うSWFとportは呼出側で決める)
+void fillComparatorPlan(comparatorPlan &plan, int coNum){
+  plan.threshold = (int64_t)setMan.getSettingAnyvalue(COTRS, coNum);
+  int64_t hys = (uint32_t)setMan.getSettingValue(COHY, coNum);
+  plan.thresholdOff = (plan.threshold < INT64_MIN + hys) ? INT64_MIN : plan.threshold - hys;
+  plan.onDelay = (uint32_t)setMan.getSettingValue(COTN, coNum) * 1000;
+  plan.offDelay = (uint32_t)setMan.getSettingValue(COTF, coNum) * 1000;
+  plan.latchMode = setMan.getSettingValue(COLM, coNum);
+  plan.cond = plan.stable = plan.pending = plan.out = false;
+  plan.since = 0;
+  plan.pinMask = digitalPinToBitMask(outputPorts_CO[coNum]);
+  plan.polMask = setMan.getSettingValue(COPOL, coNum) ? plan.pinMask : 0;
+  plan.coNum = coNum;
+}
+
+// critical COを作る。COUSFが無効なSWFならfalse
+bool fillCriticalComparator(criticalComparator &crit, int coNum){
+  uint8_t swfNum = setMan.getSettingValue(COUSF, coNum);
+  int k = 0;
+  while(k < swfPlan.count && swfPlan.plan[k].swfNum != swfNum) k++;
+  if(k == swfPlan.count) return false;
+  crit.swf = swfPlan.plan[k];
+  fillComparatorPlan(crit.co, coNum);
+  crit.co.swfNum = swfNum;
+  crit.co.inputs = SWFMASKBIT(swfNum);
+  crit.co.port = 0;
+  crit.outSet = &digitalPinToPort(outputPorts_CO[coNum])->OUTSET.reg;
+  crit.outClr = &digitalPinToPort(outputPorts_CO[coNum])->OUTCLR.reg;
+  return true;
+}
+
+// PWM/frequency COのplanをsetに追加する (TCCにはまだつながない)
+// COSPが0 / frequencyが2本目なら使わずにSerialに理由を出してfalse
+bool fillPwmOutputPlan(pwmOutputPlanSet &set, int coNum){
+  pwmOutputPlan &plan = set.plan[set.count];
+  plan.base = (int64_t)setMan.getSettingAnyvalue(COTRS, coNum);
+  plan.span = (uint32_t)setMan.getSettingValue(COSP, coNum);
+  plan.fullFreq = (uint16_t)setMan.getSettingValue(COFS, coNum);
+  plan.outType = setMan.getSettingValue(COOT, coNum);
+  plan.coNum = coNum;
+  plan.swfNum = setMan.getSettingValue(COUSF, coNum);
+  plan.invert = setMan.getSettingValue(COPOL, coNum);
+  plan.ch = -1;
+  if(plan.span == 0){
+    Serial.print("co");Serial.print(coNum);Serial.println(" pwm error: COSP is 0");
+    return false;
+  }
+  plan.top = (plan.base > INT64_MAX - (int64_t)plan.span) ? INT64_MAX : plan.base + plan.span;
+  if(plan.outType == COOT_FREQ){            // TCC1の周期は1つ
+    for(int i = 0; i < set.count; i++){
+      if(set.plan[i].outType != COOT_FREQ) continue;
+      Serial.print("co");Serial.print(coNum);Serial.print(" freq error: co");Serial.print(set.plan[i].coNum);
+      Serial.println(" uses the frequency output");
+      return false;
     }
   }
+  set.swfs |= SWFMASKBIT(plan.swfNum);
+  set.count++;
+  return true;
+}
+
+// PWM COの構成 (CO番号, 出力種類, 極性) が同じならTCCを止めずに値だけ入れ替える
+// 違えば前のpinをGPIOに戻し、全channelをattach()してからTCCを1回だけstartする
+void applyPwmOutputPlan(pwmOutputPlanSet &build){
+  bool same = (build.count == coPwm.count);
+  for(int i = 0; same && i < build.count; i++){
+    same = build.plan[i].coNum == coPwm.plan[i].coNum && build.plan[i].outType == coPwm.plan[i].outType &&
+           build.plan[i].invert == coPwm.plan[i].invert;
+  }
+  if(same){
+    for(int i = 0; i < build.count; i++) build.plan[i].ch = coPwm.plan[i].ch;
+    coPwm = build;
+    return;
+  }
+  for(int i = 0; i < coPwm.count; i++){
+    int coNum = coPwm.plan[i].coNum;
+    pinMode(outputPorts_CO[coNum], OUTPUT);
+    outputCOwithPolarity(coNum, LOW);
+    coOut.state[coNum] = -1;
+  }
+  pwmOut.reset();
+  coPwm.count = 0;
+  coPwm.swfs = 0;
+  for(int i = 0; i < build.count; i++){
+    pwmOutputPlan &plan = build.plan[i];
+    plan.ch = pwmOut.attach(outputPorts_CO[plan.coNum], (plan.outType == COOT_FREQ) ? PWMOUT_FREQ : PWMOUT_DUTY,
+                            plan.invert);
+    if(plan.ch < 0){
+      DEBUG_PRINT("Error: PWM CO ");DEBUG_PRINTLN(plan.coNum);
+      continue;
+    }
+    coPwm.plan[coPwm.count++] = plan;
+    coPwm.swfs |= SWFMASKBIT(plan.swfNum);
+  }
+  pwmOut.start();
+}
+
+// compileSoftwareFilter()の後に呼ぶ (critical COはswfPlanをコピーする)
+// 設定(rule, critical COはSWFも)が変わらなかったCOは前のplanの状態を引き継ぐので、
+// menuを抜けてもlatchは保持され、delayの計時も続く
+void compileComparators(){
+  char rule[CORULESIZE];
+  static criticalComparatorSet critBuild;   // 割込禁止区間を短くするため別に作ってからコピー
+  pwmOutputPlanSet pwmBuild;                // 今のTCC構成と比べてから入れ替える
+  comparatorPlan prev[PIN_COCOUNT];         // 状態を引き継ぐ元
+  uint8_t prevCount = coPlan.count;
+  uint8_t ruleSame = 0;                     // bit n: COnのruleのbytecodeが前と同じ
+  memcpy(prev, coPlan.plan, sizeof(prev));
+  critBuild.count = 0;
+  pwmBuild.count = 0;
+  pwmBuild.swfs = 0;
+  coPlan.count = 0;
+  coPlan.portCount = 0;
+  coPlan.ruleFirst = 0;
+  memset(coPlan.first, 0, sizeof(coPlan.first));
+  swfMask_t swfEnabled = 0;                 // 無効になったSWFは未受信に戻す
+  for(int k = 0; k < swfPlan.count; k++) swfEnabled |= SWFMASKBIT(swfPlan.plan[k].swfNum);
+  coSwfSeen &= swfEnabled;
+  for(int coNum = 0; coNum < PIN_COCOUNT; coNum++){
+    // ruleはOFFのCOでもcompileしてエラーをSerialで確認できるようにする
+    setMan.getCoRule(coNum, rule, sizeof(rule));
+    RuleProgram prevRule = coRule[coNum];
+    if(coRule[coNum].compile(rule, SWFCOUNT) != 0){
+      DEBUG_PRINT("Error: CO rule ");DEBUG_PRINTLN(coNum);
+    }
+    if(coRule[coNum].isSameCode(prevRule)) ruleSame |= 1 << coNum;
+    if(setMan.getSettingValue(COSW, coNum) == false) continue;
+    if(setMan.getSettingValue(COOT, coNum) != COOT_DIGITAL){
+      fillPwmOutputPlan(pwmBuild, coNum);
+      continue;
+    }
+    if(setMan.getSettingValue(COCR, coNum)){
+      if(!fillCriticalComparator(critBuild.crit[critBuild.count], coNum)){
+        DEBUG_PRINT("Error: critical CO SWF ");DEBUG_PRINTLN(coNum);
+        continue;
+      }
+      critBuild.count = critBuild.count + 1;
+      continue;
+    }
+    comparatorPlan &plan = coPlan.plan[coPlan.count++];
+    fillComparatorPlan(plan, coNum);
+    if(coRule[coNum].isValid()){            // 複合条件はSWF番号の代わりにCORULESWF
+      plan.swfNum = CORULESWF;
+      plan.inputs = coRule[coNum].getInputs();
+    }
+    else{
+      plan.swfNum = setMan.getSettingValue(COUSF, coNum);
+      plan.inputs = SWFMASKBIT(plan.swfNum);
+    }
+    for(int k = 0; k < prevCount; k++){
+      if(comparatorSameConfig(plan, prev[k]) && (plan.swfNum != CORULESWF || (ruleSame & (1 << coNum)))){
+        comparatorCopyState(plan, prev[k]);
+      }
+    }
+    PortGroup* port = digitalPinToPort(outputPorts_CO[coNum]);
+    uint8_t p = 0;
+    while(p < coPlan.portCount && coPlan.port[p] != port) p++;
+    if(p == coPlan.portCount) coPlan.port[coPlan.portCount++] = port;
+    plan.port = p;
+  }
+  // 同じSWFのplanを連続させる (insertion sort, CO番号順は維持) ruleのplanは最後に並ぶ
+  for(int i = 1; i < coPlan.count; i++){
+    comparatorPlan tmp = coPlan.plan[i];
+    int j = i - 1;
+    for(; j >= 0 && coPlan.plan[j].swfNum > tmp.swfNum; j--) coPlan.plan[j + 1] = coPlan.plan[j];
+    coPlan.plan[j + 1] = tmp;
+  }
+  for(int i = coPlan.count - 1; i >= 0; i--){
+    if(coPlan.plan[i].swfNum < SWFCOUNT) coPlan.first[coPlan.plan[i].swfNum] = i + 1;
+    else coPlan.ruleFirst = i + 1;
+  }
+  applyPwmOutputPlan(pwmBuild);
+  noInterrupts();                           // critical COの状態はISRが更新するので割込禁止中に引き継ぐ
+  for(int i = 0; i < critBuild.count; i++){
+    for(int k = 0; k < coCrit.count; k++){
+      if(criticalComparatorSameConfig(critBuild.crit[i], coCrit.crit[k])){
+        comparatorCopyState(critBuild.crit[i].co, coCrit.crit[k].co);
+      }
+    }
+  }
+  memcpy(&coCrit, &critBuild, sizeof(coCrit));
+  interrupts();
+}
+
+// latch/toggleで保持している出力をinactiveに戻す
+void releaseComparatorLatches(){
+  for(int i = 0; i < coPlan.count; i++){
+    comparatorPlan &plan = coPlan.plan[i];
+    if(plan.latchMode == COLM_LEVEL) continue;
+    plan.out = false;
+    coOut.state[plan.coNum] = false;
+    outputCOwithPolarity(plan.coNum, LOW);
+  }
+  noInterrupts();
+  for(int i = 0; i < coCrit.count; i++){
+    comparatorPlan &plan = coCrit.crit[i].co;
+    if(plan.latchMode == COLM_LEVEL) continue;
+    plan.out = false;
+    coOut.state[plan.coNum] = false;
+    uint32_t inactive = plan.polMask;                   // COPOL適用後のLOW
+    *coCrit.crit[i].outClr = plan.pinMask & ~inactive;
+    *coCrit.crit[i].outSet = inactive;
+  }
+  interrupts();
+}
+
+// PORT group毎にOUTSET/OUTCLRを1回ずつ書き、出力が変化したCOの遅延を記録する
+void writeComparatorPorts(const uint32_t *set, const uint32_t *clr, uint8_t changed, uint32_t timestamp){
+  for(int p = 0; p < coPlan.portCount; p++){
+    if(set[p]) coPlan.port[p]->OUTSET.reg = set[p];
+    if(clr[p]) coPlan.port[p]->OUTCLR.reg = clr[p];
+  }
+  if(changed == 0) return;
+  uint32_t latency = timebaseNow() - timestamp;
+  for(int coNum = 0; coNum < PIN_COCOUNT; coNum++){
+    if(changed & (1 << coNum)) comparatorRecordChange(coOut, coNum, timestamp, latency);
+  }
+}
+
+// PWM/frequency CO: value を [COTRS, COTRS + COSP] で0-100%にしてTCCのbuffer registerに書く
+void calcPwmOut(int64_t value, int swfNum){
+  for(int i = 0; i < coPwm.count; i++){
+    pwmOutputPlan &plan = coPwm.plan[i];
+    if(plan.swfNum != swfNum) continue;
+    uint32_t x;                             // 0..span
+    if(value <= plan.base) x = 0;
+    else if(value >= plan.top) x = plan.span;
+    else x = (uint32_t)(value - plan.base);
+    if(plan.outType == COOT_FREQ) pwmOut.setFrequency(plan.ch, (uint64_t)x * plan.fullFreq / plan.span);
+    else pwmOut.setDuty(plan.ch, x, plan.span);
+    diagCnt.coEval++;
+  }
+}
+
+// timestamp: 判定元フレームの受信時刻。出力が変化した時に受信からの遅延を記録する
+// settingsは読まずcoPlanだけで判定し、PORT group毎にOUTSET/OUTCLRを1回ずつ書く
+void calcComparaterOut(int64_t value, int swfNum, uint32_t timestamp){
+  if(coPwm.swfs & SWFMASKBIT(swfNum)) calcPwmOut(value, swfNum);
+  uint8_t first = coPlan.first[swfNum];
+  if(first == 0) return;                    // このSWFを見ているCOなし
+  uint32_t set[COPORTMAX] = {0, 0}, clr[COPORTMAX] = {0, 0};
+  uint8_t changed = 0;                      // bit n: COnの出力が変化
+  int i = first - 1;
+  for(; i < coPlan.count && coPlan.plan[i].swfNum == swfNum; i++){
+    comparatorPlan &plan = coPlan.plan[i];
+    changed |= stepComparator(plan, comparatorCond(plan, value), timestamp, set, clr, coOut);
+  }
+  writeComparatorPorts(set, clr, changed, timestamp);
+  diagCnt.coEval += i - (first - 1);
+}
+
+// 複合条件のCOを評価する。updated: このフレームで値が更新されたSWF
+// 入力のSWFがどれも更新されていないruleは評価しない。一度も受信していないSWFを参照するruleは不成立
+void calcComparaterRules(swfMask_t updated, uint32_t timestamp){
+  coSwfSeen |= updated;
+  if(coPlan.ruleFirst == 0) return;         // ruleのCOなし
+  uint32_t set[COPORTMAX] = {0, 0}, clr[COPORTMAX] = {0, 0};
+  uint8_t changed = 0;
+  bool fEval = false;
+  for(int i = coPlan.ruleFirst - 1; i < coPlan.count; i++){
+    comparatorPlan &plan = coPlan.plan[i];
+    if((plan.inputs & updated) == 0) continue;
+    bool cond = (plan.inputs & ~coSwfSeen) == 0 && coRule[plan.coNum].eval(canFiltVal.value);
+    changed |= stepComparator(plan, cond, timestamp, set, clr, coOut);
+    diagCnt.coEval++;
+    fEval = true;
+  }
+  if(fEval) writeComparatorPorts(set, clr, changed, timestamp);
+}
+
+// 全ruleを1フレームで評価する最悪の場合の時間を実機で測る (値はcanFiltValの現在値)
+// VMは短絡評価しないので、実行時間は値に依らずbytecode長で決まる
+void benchComparatorRules(){
+  uint32_t worst = 0, total = 0;
+  volatile bool sink = false;
+  for(int n = 0; n < RULEBENCHLOOPS; n++){
+    uint32_t t0 = timebaseNow();
+    for(int coNum = 0; coNum < PIN_COCOUNT; coNum++){
+      if(coRule[coNum].isValid()) sink = coRule[coNum].eval(canFiltVal.value);
+    }
+    uint32_t t = timebaseNow() - t0;
+    total += t;
+    if(t > worst) worst = t;
+  }
+  (void)sink;
+  for(int coNum = 0; coNum < PIN_COCOUNT; coNum++){
+    Serial.print("co");Serial.print(coNum);Serial.print("_rule_bytes=");Serial.println(coRule[coNum].getCodeLength());
+  }
+  Serial.print("rule_eval_avg_us=");Serial.println((float)total / RULEBENCHLOOPS, 2);
+  Serial.print("rule_eval_max_us=");Serial.println(worst);
+}
+
+// critical COの最悪実行時間を実機で測る
+// PIN_COCOUNT個のcritical COが全て同じIDに一致し、mux判定 -> 48bit signed抽出 -> scaling (64bit乗算と
+// overflow判定の経路) -> 毎フレーム出力が変化 (latency記録) する最悪の経路をISRと同じ関数で通す
+// PORTの代わりにRAM上のダミーに書き、出力状態も別に持つのでCO出力と'd'の値は変わらない
+// 1回毎に割込禁止にしてISRと同じ条件で測る
+#define CRITBENCHLOOPS  1000
+void benchCriticalComparators(){
+  static criticalComparator bench[PIN_COCOUNT];
+  static comparatorOutputState benchOut;
+  static volatile uint32_t dummyReg;
+  SoftwareFilter swf;
+  memset(&swf, 0, sizeof(swf));
+  swf.canID = 0x7FF;
+  swf.onoff = 1;
+  swf.sign = 1;
+  swf.byteOrder = SWFBO_MOTOROLA;
+  swf.startByte = 2;                        // byte2 bit7 - byte7 bit0 (48bit)
+  swf.startBit = 7;
+  swf.endByte = 7;
+  swf.endBit = 0;
+  swf.factorMul = 65535;                    // scaleShift <= 32
+  swf.factorDiv = 3;
+  swf.offset = -40;
+  swf.muxEndByte = 0;                       // byte0
+  swf.muxEndBit = 0;
+  swf.muxLen = 8;
+  swf.muxValue = 0x5A;
+  uint8_t len;
+  for(int i = 0; i < PIN_COCOUNT; i++){
+    criticalComparator &crit = bench[i];
+    compileSwfPlan(crit.swf, swf, 0, &len);
+    memset(&crit.co, 0, sizeof(crit.co));   // threshold 0, delayなし, COLM_LEVEL
+    crit.co.latchMode = COLM_LEVEL;
+    crit.co.pinMask = digitalPinToBitMask(outputPorts_CO[i]);
+    crit.co.coNum = i;
+    crit.outSet = &dummyReg;
+    crit.outClr = &dummyReg;
+  }
+  // 2^47 - 1 と -2^47 を交互に入れて毎フレーム条件を反転させる
+  canMessageSet msg[2];
+  memset(msg, 0, sizeof(msg));
+  for(int m = 0; m < 2; m++){
+    msg[m].id = swf.canID;
+    msg[m].len = 8;
+    msg[m].buf[0] = 0x5A;
+    msg[m].buf[2] = m ? 0x80 : 0x7F;
+    for(int b = 3; b < 8; b++) msg[m].buf[b] = m ? 0x00 : 0xFF;
+  }
+  uint32_t worst = 0, total = 0;
+  for(int n = 0; n < CRITBENCHLOOPS; n++){
+    canMessageSet &m = msg[n & 1];
+    noInterrupts();
+    m.timestamp = timebaseNow();
+    uint32_t t0 = timebaseNow();
+    runCriticalComparators(bench, PIN_COCOUNT, m, benchOut);
+    uint32_t t = timebaseNow() - t0;
+    interrupts();
+    total += t;
+    if(t > worst) worst = t;
+  }
+  Serial.print("crit_wcet_cos=");Serial.println(PIN_COCOUNT);
+  Serial.print("crit_wcet_avg_us=");Serial.println((float)total / CRITBENCHLOOPS, 2);
+  Serial.print("crit_wcet_max_us=");Serial.println(worst);
+  Serial.print("crit_wcet_model_us=");Serial.println(CRITWCETUS(PIN_COCOUNT));
 }
 
 
@@ -519,6 +1086,7 @@ void touchDet(int &touched, int &tx, int &ty){
 void setCANspeed(){
   // read and limit speed map
   uint32_t speedset = CANspeedMap[setMan.getSettingValue(CANSPEED, 0)];
+  busLoad.setBitrate(CANbitrateMap[setMan.getSettingValue(CANSPEED, 0)]);
   // init can bus
   while (CAN_OK != CAN.begin_noSPIset(speedset)) {
     DEBUG_PRINTLN("CAN init fail, retry...");
@@ -527,10 +1095,14 @@ void setCANspeed(){
   DEBUG_PRINTLN("CAN init ok!");
 }
 
-void setMaskFilter() {
+// hwfDiff: 書き直すMask/Filter CANDIFF_HWF(i)。全て1回のconfig mode中に書き込む
+void setMaskFilter(uint16_t hwfDiff) {
   bool ext;
   int32_t value;
+  if((hwfDiff & CANDIFF_HWFALL) == 0) return;
+  if(CAN.beginConfig() != MCP25625_OK) DEBUG_PRINTLN("CAN config mode fail");
   for(int i = 0; i < CANMFCOUNT; i++){
+    if((hwfDiff & CANDIFF_HWF(i)) == 0) continue;
     // read Mask/Filter value from memory
     value = setMan.getSettingValue(DS_HWF, i);
     if(!setMan.isValidSetting(value, DS_HWF, i)) value = canMFtable[i].defaultValue;
@@ -539,96 +1111,465 @@ void setMaskFilter() {
     // write Mask/FilterValue to MCP
     if(canMFtable[i].fMaskFilter){                    // write filter value
       ext = setMan.getSettingValue(HWFFL, canMFtable[i].num);
-      CAN.init_Filt(canMFtable[i].num, ext, value);
+      CAN.writeFilt(canMFtable[i].num, ext, value);
     }
-    else CAN.init_Mask(canMFtable[i].num, 0, value);  // write mask value
+    else CAN.writeMask(canMFtable[i].num, 0, value);  // write mask value
   }
+  if(CAN.endConfig() != MCP25625_OK) DEBUG_PRINTLN("CAN normal mode fail");
 }
 
-// Out: &msgSet: CAN message
-void getCanMsg(canMessageSet &msgSet){
-  // read CAN msg
-  CAN.readMsgBufID(&msgSet.id, &msgSet.ext, &msgSet.len, msgSet.buf);
-  if(msgSet.len > MAX_CHAR_IN_MESSAGE) msgSet.len = MAX_CHAR_IN_MESSAGE;  // limitation of len
+// 変更のあったCAN設定だけMCPに書き込む。戻り値 true:MCPの設定を変更した
+bool applyCanSettings(){
+  uint16_t diff = setMan.diffCanSettings();
+  DEBUG2_PRINT("CAN settings diff= ");DEBUG2_PRINTLN(diff);
+  if(diff & CANDIFF_SPEED) setCANspeed();   // resetからやり直し
+  setMaskFilter(diff);
+  setMan.markCanSettingsApplied();
+  return diff != 0;
 }
 
-// make a string for display 1 line
-void formatMsg1line(canMessageSet &msgSet, String &canString){
-  // IDをフォーマット
-  char hexStr[CANIDDIGIT8 + 1];   // 桁数+null文字分
-  sprintf(hexStr, HEXDIGIT8, msgSet.id);
-  // Data列を文字列に変換
-  canString = String(hexStr) + " Msg: ";
-  for (int i = 0; i < msgSet.len; i++) canString += String(msgSet.buf[i], HEX) + " ";
+#if CANLOG_SERIAL
+// 1 frame log to Serial: "timestamp[us] id len data..."
+void logMsgSerial(canMessageSet &msgSet){
+  char logStr[14 + CANIDDIGIT8 + 4 + MAX_CHAR_IN_MESSAGE * 3 + 1];
+  int pos = sprintf(logStr, "%lu " HEXDIGIT8 " %u", (unsigned long)msgSet.timestamp,
+                    (unsigned int)msgSet.id, (unsigned int)msgSet.len);
+  for (int i = 0; i < msgSet.len; i++) pos += sprintf(&logStr[pos], " %02X", msgSet.buf[i]);
+  Serial.println(logStr);
 }
+#endif
 
-// make a filtered string for display 1 line
-void formatMsg1line_filtered(canMessageSet &msgSet, String &canString, int swf_num){
-  // 数値をフォーマット
-  char hexStr[CANIDDIGIT8 + 1];   // ID変換 桁数+null文字分
-  sprintf(hexStr, HEXDIGIT8, msgSet.id);
-  // 文字列に変換
-  canString = "0x" + String(hexStr) + " SWF" + String(swf_num, HEX) + ": ";
-  if(canFiltVal.len[swf_num] <= 1) canString += String((uint8_t)canFiltVal.value[swf_num], HEX);
-  else if(canFiltVal.len[swf_num] <= 2) canString += String((uint16_t)canFiltVal.value[swf_num], HEX);
-  else if(canFiltVal.len[swf_num] <= 4) canString += String((uint32_t)canFiltVal.value[swf_num], HEX);
-  else{
-    canString += String((uint32_t)(canFiltVal.value[swf_num] >> 32), HEX);
-    canString += String((uint32_t)canFiltVal.value[swf_num], HEX);
+// CAN ID hash
+static inline uint8_t swfIdHash(uint32_t id){
+  return (uint8_t)((id * 2654435761UL) >> 24) & SWFIDHASHMASK;
+}
+
+// CAN IDに該当するplanの先頭 0:なし n:plan[n-1]
+static inline uint8_t swfLookup(uint32_t id){
+  for(uint8_t h = swfIdHash(id), n = 0; n < SWFIDHASHSIZE; h = (h + 1) & SWFIDHASHMASK, n++){
+    uint8_t index = swfPlan.hashIndex[h];
+    if(index == 0) return 0;            // empty slot -> not found
+    if(swfPlan.hashId[h] == id) return index;
   }
+  return 0;
 }
 
-// bit列抽出 BigEndian Out: &len,&result
-// CAN msg: [byte0][byte1]...[byte7]   [byteX]: [bit7][bit6]...[bit0]
-// startBit of startByte must be left or same pos from endbit of endByte
-void extractBits(const uint8_t* data, bool sign, uint8_t startByte, uint8_t startBit, uint8_t endByte,
-                  uint8_t endBit, int64_t &result) {
-  // calc sign
-  bool negative = false;   // true: signed and negative, false: positive
-  if(sign && ((data[startByte] >> startBit) & 0x1)) negative = true;
-  // extract
-  int64_t temp_res = 0;
-  for (uint8_t byteIndex = startByte; byteIndex <= endByte; ++byteIndex) {
-    if(byteIndex == startByte){       // calc startByte
-      uint8_t mask = (uint8_t)(((uint16_t)1 << (startBit + 1)) - 1);
-      if(negative) temp_res = (int8_t)(data[startByte] | ~mask);
-      else temp_res = data[startByte] & mask;
-      // when startByte == endByte
-      if(byteIndex == endByte) temp_res = temp_res >> endBit;
-    }
-    else if(byteIndex == endByte){    // calc endByte
-      temp_res = temp_res << (8 - endBit) | data[endByte] >> endBit;
-    }                                 // calc mid bytes
-    else temp_res = temp_res << 8 | data[byteIndex];
+// ID -> plan dispatch indexを作る。planはID順に並んでいること
+static void buildSwfDispatch(){
+  memset(swfPlan.hashIndex, 0, sizeof(swfPlan.hashIndex));
+  for(uint8_t i = 0; i < swfPlan.count; i++){
+    uint32_t id = swfPlan.plan[i].id;
+    if(i > 0 && swfPlan.plan[i - 1].id == id) continue;   // 同じIDは先頭だけ登録
+    uint8_t h = swfIdHash(id);
+    while(swfPlan.hashIndex[h] != 0) h = (h + 1) & SWFIDHASHMASK;  // SIZE > countなので必ず空きがある
+    swfPlan.hashId[h] = id;
+    swfPlan.hashIndex[h] = i + 1;
   }
-  result = temp_res;
-  DEBUG2_PRINT("extractBits result= ");DEBUG2_PRINTLN(result);
 }
 
-// calc SWF byte length
-void calcLen(){
-  uint8_t dummy;
-  for(int i = 0; i < MUTABLEOBJMAX; i++){   // repeat i for SWF0-7
-    extractLen(&setMan, i, &canFiltVal.len[i], &dummy);
+// SWFの設定からbit列抽出planとID dispatch indexを作る。設定が変わった時に呼ぶ
+// Start(MSB)はEnd(LSB)より上位のbit位置であること
+void compileSoftwareFilter(){
+  swfPlan.count = 0;
+  canFiltVal.fIsScaled = 0;
+  for(int i = 0; i < SWFCOUNT; i++){        // repeat i for all SWFs
+    canFiltVal.len[i] = 0;
+    if(setMan.getSettingValue(SWFSW, i) == false) continue;  // off
+    const SoftwareFilter &swf = setMan.getSoftwareFilter(i);
+    canSoftwareFilterPlan &plan = swfPlan.plan[swfPlan.count];
+    if(!compileSwfPlan(plan, swf, i, &canFiltVal.len[i])){  // 位置/mux位置エラー このSWFは無効
+      DEBUG_PRINT("Error: SWF position ");DEBUG_PRINTLN(i);
+      canFiltVal.len[i] = 0;
+      continue;
+    }
+    swfPlan.count++;
+    if(plan.scaled) canFiltVal.fIsScaled |= SWFMASKBIT(i);
+    DEBUG2_PRINT("SWF plan num,shift,len= ");DEBUG2_PRINT(i);DEBUG2_PRINT(", ");
+    DEBUG2_PRINT(plan.shift);DEBUG2_PRINT(", ");DEBUG2_PRINTLN(canFiltVal.len[i]);
+  }
+  // 同じIDのplanを連続させる (insertion sort, SWF番号順は維持)
+  for(int i = 1; i < swfPlan.count; i++){
+    canSoftwareFilterPlan tmp = swfPlan.plan[i];
+    int j = i - 1;
+    for(; j >= 0 && swfPlan.plan[j].id > tmp.id; j--) swfPlan.plan[j + 1] = swfPlan.plan[j];
+    swfPlan.plan[j + 1] = tmp;
   }
+  buildSwfDispatch();
 }
 
 // CAN software filtering
 void applySoftwareFilter(canMessageSet &msgSet){
-  canFiltVal.fIsFiltered.byte = 0;          // filterに引っかかったフラグ初期化
-  for(int i = 0; i < MUTABLEOBJMAX; i++){   // repeat i for SWF0-7
-    if(setMan.getSettingValue(SWFSW, i) != false && msgSet.id == (uint32_t)setMan.getSettingValue(SWFID, i)
-        && canFiltVal.len[i] != 0){
-      // filterに引っかかったフラグON
-      canFiltVal.fIsFiltered.byte |= (1 << i);
-      // データ切出準備
-      bool sign = setMan.getSettingValue(SWFSU, i);
-      uint8_t startByte = setMan.getSettingValue(SWFSB, i);
-      uint8_t startBit = setMan.getSettingValue(SWFSI, i);
-      uint8_t endByte = setMan.getSettingValue(SWFEB, i);
-      uint8_t endBit = setMan.getSettingValue(SWFEI, i);
-      // データ切出＆データ保存
-      extractBits(msgSet.buf, sign, startByte, startBit, endByte, endBit, canFiltVal.value[i]);
+  canFiltVal.fIsFiltered = 0;               // filterに引っかかったフラグ初期化
+  uint8_t first = swfLookup(msgSet.id);
+  if(first == 0) return;                    // このIDを見ているSWFなし
+  uint64_t data[2];
+  data[SWFBO_INTEL] = loadMsgData64(msgSet.buf);              // Intel: そのまま
+  data[SWFBO_MOTOROLA] = __builtin_bswap64(data[SWFBO_INTEL]); // Motorola: byte swap
+  // 同じIDのSWFは同じmux fieldを使うことが多いので、切り出したmux値を使い回す
+  uint32_t muxKey = 0;                      // 0:未抽出 else intel | shift | mask
+  uint16_t muxSel = 0;
+  for(int i = first - 1; i < swfPlan.count && swfPlan.plan[i].id == msgSet.id; i++){  // 該当するSWFだけ
+    const canSoftwareFilterPlan &plan = swfPlan.plan[i];
+    if(plan.muxMask != 0){                  // multiplexed signal
+      uint32_t key = ((uint32_t)plan.muxMask << 16) | ((uint32_t)plan.muxShift << 8) | plan.intel;
+      if(key != muxKey){
+        muxSel = (data[plan.intel] >> plan.muxShift) & plan.muxMask;
+        muxKey = key;
+      }
+      if(muxSel != plan.muxValue) continue; // mux値が違うframeは抽出しない
+    }
+    // filterに引っかかったフラグON
+    canFiltVal.fIsFiltered |= SWFMASKBIT(plan.swfNum);
+    // データ切出＆データ保存
+    canFiltVal.value[plan.swfNum] = extractSwfValue(plan, data);
+  }
+}
+
+// Critical comparator (ISR fast path) *******************************************************************
+// CAN受信割込の中で1フレーム毎に呼ぶ (MCP_RX_DMA 1: DMA完了callback, 0: MCP25625_ISR)
+// ringへのcommitとSPIの解放の後に呼ぶ。割込の中なので、次のフレームの読出はこの判定が終わってから始まる
+// critical COのID一致 -> mux判定 -> 抽出 -> scaling -> hysteresis/delay/output mode -> PORT書込 はFL_comparator
+// ringもloop()も経由しないので、表示の描画中でも受信割込から数十us以内にピンが変わる
+// 最悪の経路 (全COが同じID, mux一致, 48bit signed + scaling, 毎フレーム出力変化) の64bit演算数の上限は
+// tests/test_comparatorで確認し、cycle数の見積りはCRITWCETUS(PIN_COCOUNT) (4 COで47us)
+// 'w'のcrit_wcet_max_usはこのtreeではまだ実機で測っていない (見積りはM0+のcycle数の仮定による)
+// 運用中の実測の最大値は'd'のcrit_isr_max_us (timebaseNow()の1us分解能)
+void evalCriticalComparators(const canMessageSet &msg){
+  uint8_t count = coCrit.count;
+  if(count == 0) return;
+  uint32_t t0 = timebaseNow();
+  if(!runCriticalComparators(coCrit.crit, count, msg, coOut)) return;
+  uint32_t t = timebaseNow() - t0;
+  critIsrCount = critIsrCount + 1;
+  if(t > critIsrMax) critIsrMax = t;
+}
+
+// ring内のCAN msgを処理する (1回の呼出では開始時点の未読数まで)
+// fDisplay false: モニター表示以外のページ中。表示はせずAUX/CO出力だけ続ける
+void processRxFrames(bool fDisplay){
+  canMessageSet msgSet;                     // CAN messages
+  LineFormatter line;                       // CAN string for display 1line (stack)
+  monitorScrollType scrollType = disp.getMonitorScrollType();
+  for(uint16_t n = canRing.count(); n > 0; n--){
+    if(!canRing.pop(msgSet)) break;                 // get CAN message from ring
+    uint16_t changed = idTable.update(msgSet);     // 同じIDの前回から変化したbyte
+    busLoad.addFrame(msgSet);
+#if CANLOG_SERIAL
+    logMsgSerial(msgSet);                         // log CAN message with timestamp
+#endif
+    // output HardWareFiltered one line with 8bytes
+    if(scrollType.fMonitorDispSw_.bit.hwfDisp){
+      if(fDisplay && scrollType.fMonitorTraceSw_){
+        trace.update(msgSet);                       // traceはRAM上の行を更新するだけ (描画はrender())
+      }
+      else if(fDisplay && !scrollType.fMonitorDeltaSw_){
+        formatMsg1line(msgSet, line, 0, MONITOR_TIMESTAMP);   // format CAN message to 1line
+        if(!disp.postLine(line.c_str(), line.length())) diagCnt.dispDrop++;   // display formatted CAN string
+      }
+      else if(fDisplay && changed != 0){            // 変化表示モードでは変化したframeだけ表示
+#if MONITOR_DELTA_HL
+        uint64_t hlChars = formatMsg1line(msgSet, line, changed & ~IDCHG_NEW, MONITOR_TIMESTAMP);
+#else
+        uint64_t hlChars = formatMsg1line(msgSet, line, 0, MONITOR_TIMESTAMP);
+#endif
+        if(!disp.postLine(line.c_str(), line.length(), ILI9341_WHITE, hlChars)) diagCnt.dispDrop++;
+      }
+      if(setMan.getSettingValue(AOSET, DS_AOHSW_POS)){
+        auxSend_frame(msgSet);                      // send CAN msg to AUX SPI output
+      }
+    }
+    // output SoftWareFiltered some lines with some bytes
+    applySoftwareFilter(msgSet);
+    if(canFiltVal.fIsFiltered != 0){              // Filtered by the Software filter
+      DEBUG_PRINT("Value is Filtered");
+      swfMask_t filtered = canFiltVal.fIsFiltered;
+      while(filtered != 0){                       // 引っかかったSWFだけ SWF番号順に処理
+        int swfNum = __builtin_ctzll(filtered);
+        filtered &= filtered - 1;
+        if(fDisplay && scrollType.fMonitorDispSw_.bit.swfDisp && !scrollType.fMonitorTraceSw_){
+          formatMsg1line_filtered(msgSet, line, swfNum, canFiltVal.value[swfNum], canFiltVal.len[swfNum],
+                                  (canFiltVal.fIsScaled >> swfNum) & 1, MONITOR_TIMESTAMP);  // format CAN message to 1line
+          if(!disp.postLine(line.c_str(), line.length(), ILI9341_YELLOW)) diagCnt.dispDrop++; // display formatted CAN string
+        }
+        if(setMan.getSettingValue(AOSET, DS_AOSSW_POS)){
+          auxSend_filtered(canFiltVal.value[swfNum], canFiltVal.len[swfNum], msgSet.timestamp);   // send CAN msg to AUX SPI output
+        }
+        calcComparaterOut(canFiltVal.value[swfNum], swfNum, msgSet.timestamp);
+        swfStats[swfNum].update(canFiltVal.value[swfNum], msgSet.timestamp);
+      }
+      calcComparaterRules(canFiltVal.fIsFiltered, msgSet.timestamp);
+    }
+  }
+}
+
+// Diagnostics functions *********************************************************************************
+void resetDiagCounters(){
+  memset(&diagCnt, 0, sizeof(diagCnt));
+  noInterrupts();                           // critical COのISRと競合しない
+  for(int coNum = 0; coNum < PIN_COCOUNT; coNum++){
+    coOut.latency[coNum] = 0;
+    coOut.latencyMax[coNum] = 0;
+  }
+  critIsrMax = 0;
+  critIsrCount = 0;
+  interrupts();
+  canRing.resetCounters();
+  disp.resetLineQueueCounters();
+}
+
+// 1行INFOLINECHARS文字以内
+void drawDiagPage(){
+  char line[INFOLINECHARS + 1];
+  snprintf(line, sizeof(line), "RX frame %10lu", (unsigned long)canRing.getPushedCount());
+  disp.setInfoLine(0, line);
+  snprintf(line, sizeof(line), "MCP OVR0 %10lu", (unsigned long)diagCnt.rx0Ovr);
+  disp.setInfoLine(1, line);
+  snprintf(line, sizeof(line), "MCP OVR1 %10lu", (unsigned long)diagCnt.rx1Ovr);
+  disp.setInfoLine(2, line);
+  snprintf(line, sizeof(line), "Ring OVF %10lu", (unsigned long)canRing.getOverflowCount());
+  disp.setInfoLine(3, line);
+  snprintf(line, sizeof(line), "Ring max %6u/%3u", canRing.getHighWater(), CANRINGSIZE);
+  disp.setInfoLine(4, line);
+  // 表示しなかった行 = 停止中 + queue満杯 (内訳はSerialの'd')
+  snprintf(line, sizeof(line), "Disp drp %10lu", (unsigned long)(diagCnt.dispDrop + disp.getLineDropCount()));
+  disp.setInfoLine(5, line);
+  snprintf(line, sizeof(line), "AUX drp  %10lu", (unsigned long)diagCnt.auxDrop);
+  disp.setInfoLine(6, line);
+  snprintf(line, sizeof(line), "CO eval  %10lu", (unsigned long)diagCnt.coEval);
+  disp.setInfoLine(7, line);
+}
+
+void resetSwfStats(){
+  for(int i = 0; i < SWFCOUNT; i++) swfStats[i].reset();
+}
+
+// int32に収まれば10進、収まらなければ16桁の16進 (最大16文字)
+void formatStatValue(char *buf, size_t size, int64_t value){
+  if(value >= INT32_MIN && value <= INT32_MAX){
+    snprintf(buf, size, "%ld", (long)value);
+  }
+  else{
+    snprintf(buf, size, "%08lX%08lX", (unsigned long)((uint64_t)value >> 32), (unsigned long)((uint64_t)value & 0xFFFFFFFF));
+  }
+}
+
+// SWF STAT pageで表示するSWFをstep(-1/+1)だけ動かす 有効なSWFがあればそれだけを巡回する
+void stepStatSwf(int step){
+  for(int i = 0; i < SWFCOUNT; i++){
+    statSwf = (statSwf + step + SWFCOUNT) % SWFCOUNT;
+    if(setMan.getSettingValue(SWFSW, statSwf)) return;
+  }
+}
+
+// doubleを小数点以下decimals桁の文字列にする (Stringを作らない)
+const char* fixedStr(LineFormatter &f, double value, uint8_t decimals){
+  f.clear();
+  f.putFixed(value, decimals);
+  return f.c_str();
+}
+
+// 1行INFOLINECHARS文字以内
+void drawStatPage(){
+  char line[INFOLINECHARS + 1];
+  char val[17];
+  LineFormatter num;
+  SignalStats &st = swfStats[statSwf];
+  snprintf(line, sizeof(line), "SWF%-2X %3s n=%7lu", statSwf,
+           setMan.getSettingValue(SWFSW, statSwf) ? "ON" : "OFF", (unsigned long)st.getCount());
+  disp.setInfoLine(0, line);
+  if(st.getCount() == 0){
+    disp.setInfoLine(1, "no sample");
+    for(int i = 2; i < 8; i++) disp.setInfoLine(i, "");
+    return;
+  }
+  formatStatValue(val, sizeof(val), st.getMin());
+  snprintf(line, sizeof(line), "min%16s", val);
+  disp.setInfoLine(1, line);
+  formatStatValue(val, sizeof(val), st.getMax());
+  snprintf(line, sizeof(line), "max%16s", val);
+  disp.setInfoLine(2, line);
+  snprintf(line, sizeof(line), "avg%16s", fixedStr(num, st.getMean(), 2));
+  disp.setInfoLine(3, line);
+  double var = st.getVariance();
+  snprintf(line, sizeof(line), "var%16s", fixedStr(num, var, 2));
+  disp.setInfoLine(4, line);
+  snprintf(line, sizeof(line), "sd %16s", fixedStr(num, sqrt(var), 2));
+  disp.setInfoLine(5, line);
+  snprintf(line, sizeof(line), "rate%13sHz", fixedStr(num, st.getRate(), 2));
+  disp.setInfoLine(6, line);
+  formatStatValue(val, sizeof(val), canFiltVal.value[statSwf]);
+  snprintf(line, sizeof(line), "now%16s", val);
+  disp.setInfoLine(7, line);
+}
+
+// サンプルのあるSWFだけ1行ずつ出力する
+void dumpSwfStats(){
+  char val[17];
+  for(int i = 0; i < SWFCOUNT; i++){
+    SignalStats &st = swfStats[i];
+    if(st.getCount() == 0) continue;
+    Serial.print("swf=");   Serial.print(i, HEX);
+    Serial.print(" n=");    Serial.print(st.getCount());
+    formatStatValue(val, sizeof(val), st.getMin());
+    Serial.print(" min=");  Serial.print(val);
+    formatStatValue(val, sizeof(val), st.getMax());
+    Serial.print(" max=");  Serial.print(val);
+    Serial.print(" mean="); Serial.print(st.getMean(), 3);
+    Serial.print(" var=");  Serial.print(st.getVariance(), 3);
+    Serial.print(" rate="); Serial.println(st.getRate(), 2);
+  }
+}
+
+// ID TRAFFIC page 1行目は並び順と使用数、2-8行目に1IDずつ
+#define IDPAGELINES 7
+const char* const idSortName[IDSORTMAX] = {"count", "rate", "ID"};
+void drawIdPage(){
+  char line[INFOLINECHARS + 1];
+  LineFormatter num;
+  uint8_t order[IDTABLESIZE];
+  uint8_t used = idTable.sort(order, idSortKey);
+  snprintf(line, sizeof(line), "by %-5s %3u/%3u", idSortName[idSortKey], used, IDTABLESIZE);
+  disp.setInfoLine(0, line);
+  for(int i = 0; i < IDPAGELINES; i++){
+    int rank = idTop + i;
+    if(rank >= used){
+      disp.setInfoLine(i + 1, "");
+      continue;
+    }
+    const canIdEntry &e = idTable.getEntry(order[rank]);
+    if(idSortKey == IDSORT_COUNT){
+      snprintf(line, sizeof(line), "%8lX %8lu %u", (unsigned long)(e.key & ~IDKEY_EXT), (unsigned long)e.count, e.dlc);
+    }
+    else{
+      snprintf(line, sizeof(line), "%8lX %6sHz %u", (unsigned long)(e.key & ~IDKEY_EXT),
+               fixedStr(num, CanIdTable::getRate(e), 1), e.dlc);
+    }
+    disp.setInfoLine(i + 1, line);
+  }
+}
+
+// 受信数の多い順に全IDを出力する
+void dumpIdTable(){
+  uint8_t order[IDTABLESIZE];
+  uint8_t used = idTable.sort(order, IDSORT_COUNT);
+  Serial.print("ids=");     Serial.print(used);
+  Serial.print(" evicted=");Serial.println(idTable.getEvictedCount());
+  for(int i = 0; i < used; i++){
+    const canIdEntry &e = idTable.getEntry(order[i]);
+    Serial.print("id=");    Serial.print(e.key & ~IDKEY_EXT, HEX);
+    Serial.print(e.key & IDKEY_EXT ? " ext" : " std");
+    Serial.print(" n=");    Serial.print(e.count);
+    Serial.print(" per=");  Serial.print(e.ewmaPeriod);
+    Serial.print(" min=");  Serial.print(e.minPeriod);
+    Serial.print(" max=");  Serial.print(e.maxPeriod);
+    Serial.print(" dlc=");  Serial.print(e.dlc);
+    Serial.print(" data=");
+    for(int b = 0; b < e.dlc && b < 8; b++){
+      if(e.data[b] < 0x10) Serial.print('0');
+      Serial.print(e.data[b], HEX);
+    }
+    Serial.println();
+  }
+}
+
+void dumpDiagCounters(){
+  Serial.print("t_us=");      Serial.println(timebaseNow());
+  Serial.print("rx_frames="); Serial.println(canRing.getPushedCount());
+  Serial.print("mcp_rx0ovr=");Serial.println(diagCnt.rx0Ovr);
+  Serial.print("mcp_rx1ovr=");Serial.println(diagCnt.rx1Ovr);
+  Serial.print("ring_ovf=");  Serial.println(canRing.getOverflowCount());
+  Serial.print("ring_max=");  Serial.println(canRing.getHighWater());
+  Serial.print("disp_drop="); Serial.println(diagCnt.dispDrop);
+  Serial.print("disp_qdrop=");Serial.println(disp.getLineDropCount());
+  Serial.print("disp_qmax="); Serial.println(disp.getLineQueueHighWater());
+  Serial.print("aux_drop=");  Serial.println(diagCnt.auxDrop);
+  Serial.print("co_eval=");   Serial.println(diagCnt.coEval);
+  Serial.print("co_pwm_wr="); Serial.println(pwmOut.getWriteCount());
+  for(int coNum = 0; coNum < PIN_COCOUNT; coNum++){   // 受信から出力変化までの時間 最後/最大
+    Serial.print("co");Serial.print(coNum);Serial.print("_lat_us=");
+    Serial.print(coOut.latency[coNum]);Serial.print('/');Serial.println(coOut.latencyMax[coNum]);
+  }
+  Serial.print("crit_isr_runs=");Serial.println(critIsrCount);
+  Serial.print("crit_isr_max_us=");Serial.println(critIsrMax);
+  Serial.print("bus_load_pm=");Serial.println(busLoad.getLoadPermille());
+  Serial.print("fps=");       Serial.println(busLoad.getFps());
+  Serial.print("drop_ps=");   Serial.println(busLoad.getDropPerSec());
+}
+
+// bus load in the status line
+// 取りこぼし(ring overflow + MCP RX overrun)も区間毎に数える。overrunは回数なので下限値
+void drawBusLoad(){
+  char text[13];
+  busLoad.update(timebaseNow(), canRing.getOverflowCount() + diagCnt.rx0Ovr + diagCnt.rx1Ovr);
+  snprintf(text, sizeof(text), "%3u%%%6lu/s", (busLoad.getLoadPermille() + 5) / 10, (unsigned long)busLoad.getFps());
+  disp.drawBusLoad(text, busLoad.getDropPerSec() != 0);
+}
+
+// CO rules
+void listComparatorRules(){
+  char rule[CORULESIZE];
+  for(int coNum = 0; coNum < PIN_COCOUNT; coNum++){
+    setMan.getCoRule(coNum, rule, sizeof(rule));
+    Serial.print('R');Serial.print(coNum);Serial.print(' ');Serial.print(rule);
+    Serial.print("  ; ");Serial.print(coRule[coNum].getCodeLength());Serial.println(" bytes");
+  }
+}
+
+// "<co> <rule>" ruleが空ならCOはusingSwf/threshouldに戻る
+void setComparatorRule(char *line){
+  if(line[0] < '0' || line[0] >= '0' + PIN_COCOUNT){
+    Serial.println("rule error: CO number");
+    return;
+  }
+  int coNum = line[0] - '0';
+  const char *text = line + 1;
+  while(*text == ' ') text++;
+  if(strlen(text) > CORULESIZE - 1){
+    Serial.println("rule error: too long");
+    return;
+  }
+  RuleProgram test;
+  int err = test.compile(text, SWFCOUNT);
+  if(err != 0){
+    Serial.print("rule error at ");Serial.println(err);
+    return;
+  }
+  setMan.setCoRule(coNum, text);
+  compileComparators();
+  if(!setMan.isTempSaved()) setMan.saveDeviceSettings(SLP_TEMP);   // 電源を切っても残す
+  Serial.print("rule ok: ");Serial.print(test.getCodeLength());Serial.println(" bytes");
+}
+
+// Serial command
+// 1文字のコマンドの他、DIAGCMD_RULEはLF/CRまでを1行として受け取る
+void serialCommand(){
+  static char ruleLine[CORULESIZE + 3];     // "<co> <rule>" 長すぎる行はsetComparatorRule()で弾く
+  static int ruleLen = -1;                  // -1:1文字コマンド待ち
+  while(Serial.available() > 0){
+    int c = Serial.read();
+    if(ruleLen >= 0){
+      if(c == '\n' || c == '\r'){
+        ruleLine[ruleLen] = '\0';
+        ruleLen = -1;
+        setComparatorRule(ruleLine);
+      }
+      else if(ruleLen < (int)sizeof(ruleLine) - 1) ruleLine[ruleLen++] = c;
+      continue;
+    }
+    switch(c){
+      case DIAGCMD_RULE:  ruleLen = 0; break;
+      case DIAGCMD_RULES: listComparatorRules(); break;
+      case DIAGCMD_BENCH: benchComparatorRules(); break;
+      case DIAGCMD_CRITBENCH: benchCriticalComparators(); break;
+      case DIAGCMD_DUMP:  dumpDiagCounters(); break;
+      case DIAGCMD_RESET: resetDiagCounters(); resetSwfStats(); Serial.println("diag reset"); break;
+      case DIAGCMD_IDS:   dumpIdTable(); break;
+      case DIAGCMD_COCLR: releaseComparatorLatches(); Serial.println("co released"); break;
+      case DIAGCMD_STATS:
+        fStatStream = !fStatStream;
+        Serial.println(fStatStream ? "stat stream on" : "stat stream off");
+        break;
+      default: break;
     }
   }
 }
@@ -718,6 +1659,33 @@ void setup() {
     DMA_BEAT_SIZE_BYTE, true, false);
     // bytes/hword/words, increment source addr?, increment dest addr?
   auxDMA.setCallback(auxdma_callback);
+#if TFT_LINE_DMA
+  tftDMA.setTrigger(SERCOM1_DMAC_ID_TX);
+  tftDMA.setAction(DMA_TRIGGER_ACTON_BEAT);
+  if(tftDMA.allocate() == DMA_STATUS_OK){
+    tftDMA.addDescriptor(
+      tftLine.getBuffer(), (void *)(&SERCOM1->SPI.DATA.reg), tftLine.getBufferBytes(),
+      DMA_BEAT_SIZE_BYTE, true, false);
+    tftDMA.setCallback(tftdma_callback);
+    disp.setLineRenderer(&tftLine);
+    trace.setLineRenderer(&tftLine);
+  }
+#endif
+#if MCP_RX_DMA
+  mcpsdTxDMA.setTrigger(SERCOM0_DMAC_ID_TX);
+  mcpsdTxDMA.setAction(DMA_TRIGGER_ACTON_BEAT);
+  mcpsdTxDMA.allocate();
+  mcpsdTxDMA.addDescriptor(
+    mcpsdDMA_srcmem, (void *)(&SERCOM0->SPI.DATA.reg), MCPRXDMA_LENGTH,
+    DMA_BEAT_SIZE_BYTE, true, false);
+  mcpsdRxDMA.setTrigger(SERCOM0_DMAC_ID_RX);
+  mcpsdRxDMA.setAction(DMA_TRIGGER_ACTON_BEAT);
+  mcpsdRxDMA.allocate();
+  mcpsdRxDMA.addDescriptor(
+    (void *)(&SERCOM0->SPI.DATA.reg), mcpsdDMA_dstmem, MCPRXDMA_LENGTH,
+    DMA_BEAT_SIZE_BYTE, false, true);
+  mcpsdRxDMA.setCallback(mcpsddma_callback);  // RX完了 = 14byte送受信完了
+#endif
 
   // Device Settings load from TEMP
   setMan.loadDeviceSettings(SLP_TEMP);
@@ -745,11 +1713,15 @@ void setup() {
   disp.showInitialScreen();
   
   // CAN init
-  attachInterrupt(digitalPinToInterrupt(CAN_INT), MCP25625_ISR, FALLING); // interrupt init
+  timebaseBegin();      // 受信時刻用 us timebase
+  pwmOut.begin();       // PWM/frequency CO (timebaseのGCLKを使う)
   CAN.setSPI(&mcpsdSPI);
-  setCANspeed();        // デバイス設定値のcanspeedにセット
-  setMaskFilter();      // set mcp mask and filter
-  calcLen();            // calc SWF byte length
+  mcpsdSPI.usingInterrupt(digitalPinToInterrupt(CAN_INT));  // mask CAN isr while using mcpsdSPI
+  applyCanSettings();   // デバイス設定値のcanspeed, mask and filterにセット
+  canRing.clear();
+  attachInterrupt(digitalPinToInterrupt(CAN_INT), MCP25625_ISR, CAN_INT_MODE); // interrupt init
+  compileSoftwareFilter(); // calc SWF extraction plan
+  compileComparators();    // calc CO evaluation plan
   Serial.println("Setup fin!");
 
   // display init2
@@ -774,8 +1746,6 @@ void setup() {
 // Main                                                                                 *
 // **************************************************************************************
 void loop(void) {
-  canMessageSet msgSet;                     // CAN messages
-  String canString;                         // CAN string for display 1line
   uint16_t pushedSw = 0, longPushedSw = 0;  // push switches
   int touchX, touchY, touched =0;           // touch detection position and power
   long vCan_mV = 0;                         // CAN Vcc Voltage [mV]
@@ -790,11 +1760,13 @@ void loop(void) {
   if(adDetTimer.isExpired()){
     // read the value from A/D:
     vCan_mV = (analogRead(PIN_VCAN) * adScaleFactor >> ADSFSHIFTBITS);
-    int integerPart = vCan_mV / 10;
-    int decimalPart = vCan_mV % 10;
-    String result = String(integerPart) + "." + String(decimalPart);
-    disp.drawCANvoltage(result);
-    DEBUG2_PRINT("SF= ");DEBUG2_PRINT(adScaleFactor);DEBUG2_PRINT(", Vcan[mV] = ");DEBUG2_PRINTLN(result);
+    LineFormatter result;
+    result.putDec((uint32_t)(vCan_mV / 10));
+    result.put('.');
+    result.putDec((uint32_t)(vCan_mV % 10));
+    disp.drawCANvoltage(result.c_str());
+    drawBusLoad();
+    DEBUG2_PRINT("SF= ");DEBUG2_PRINT(adScaleFactor);DEBUG2_PRINT(", Vcan[mV] = ");DEBUG2_PRINTLN(result.c_str());
   }
 
   // display
@@ -812,48 +1784,60 @@ void loop(void) {
       // 表示ページを更新
       disp.changePage();                      // 表示ページを更新
       // 設定値の処理
-      setMan.saveDeviceSettings(SLP_TEMP);    // currentDeviceSettingsの設定をflashのtemp領域に保存
+      if(!setMan.isTempSaved()) setMan.saveDeviceSettings(SLP_TEMP);  // 変更があればflashのtemp領域に保存
       mplay.start(&melody4);                  // ビープ
-      setCANspeed();                          // デバイス設定値のcanspeedにセット
-      setMaskFilter();                        // set mcp mask and filter
-      calcLen();                              // calc SWF byte length
+      holdMcpRx();
+      if(applyCanSettings()){                 // 変更のあったCAN設定だけMCPに書込
+        canRing.clear();                      // 前の設定で受信したフレームを破棄
+      }
+      releaseMcpRx();
+      compileSoftwareFilter();                // calc SWF extraction plan
+      compileComparators();                   // calc CO evaluation plan
       disp.reMappingSw();                     // reMapping Switches
     }
     else disp.changePage();                   // 表示ページを更新
   }
   else if(disp.isMonitorMode()){     // モニターモード時の処理
-    // CAN割込があった時はmsgを取得して出力
-    if(canrxIntFlag){
-      canrxIntFlag = 0;
-      // get and display CAN data
-      while (CAN.checkReceive() == CAN_MSGAVAIL){     // get CAN msg until empty
-        // get CAN message
-        getCanMsg(msgSet);                            // get and format CAN message
-        // output HardWareFiltered one line with 8bytes
-        if(disp.getMonitorScrollType().fMonitorDispSw_.bit.hwfDisp){
-          formatMsg1line(msgSet, canString);          // format CAN message to 1line
-          disp.postLine(canString);                   // display formatted CAN string
-          if(setMan.getSettingValue(AOSET, DS_AOHSW_POS)){
-            auxSend(msgSet.buf, msgSet.len);            // send CAN msg to AUX SPI output
-          }
+    monitorScrollType scrollType = disp.getMonitorScrollType();
+    if(disp.getTraceStartRequest()) trace.clear();
+    processRxFrames(true);           // ringに溜まったmsgを出力 (表示行はqueueに積むだけ)
+    disp.renderLine();               // 1 loopで描くのは1行まで (DMA転送中なら次のloopで)
+    // traceは一定周期で変化した行を描くpassを始め、1 loopで1行ずつ描く (停止中は描かない)
+    if(scrollType.fMonitorTraceSw_ && scrollType.fMonitorScrollSw_ &&
+       (trace.isRenderPending() || traceTimer.isExpired())){
+      trace.render();                // line DMAの転送中はtrace側で次のloopまで待つ
+    }
+  }
+  else if(disp.isInfoMode()){        // Info画面時の処理
+    processRxFrames(false);          // 表示以外の出力は続ける
+    if(disp.getCurrentPage() == DGRX && diagDispTimer.isExpired()){
+      if(disp.getInfoResetRequest()) resetDiagCounters();
+      drawDiagPage();
+    }
+    else if(disp.getCurrentPage() == DGSTAT){
+      int step = disp.getInfoStepRequest();
+      if(step != 0 || diagDispTimer.isExpired()){
+        if(disp.getInfoResetRequest()) resetSwfStats();
+        if(step != 0) stepStatSwf(step);
+        drawStatPage();
+      }
+    }
+    else if(disp.getCurrentPage() == DGID){
+      int step = disp.getInfoStepRequest();
+      bool fMode = disp.getInfoModeRequest();
+      if(step != 0 || fMode || diagDispTimer.isExpired()){
+        if(disp.getInfoResetRequest()){
+          idTable.clear();
+          idTop = 0;
         }
-        // output SoftWareFiltered some lines with some bytes
-        applySoftwareFilter(msgSet);
-        if(canFiltVal.fIsFiltered.byte != 0){         // Filtered by the Software filter
-          DEBUG_PRINT("Value is Filtered");
-          for(int swfNum = 0; swfNum < MUTABLEOBJMAX; swfNum++){
-            if((canFiltVal.fIsFiltered.byte >> swfNum) & 1){
-              formatMsg1line_filtered(msgSet, canString, swfNum);  // format CAN message to 1line
-              if(disp.getMonitorScrollType().fMonitorDispSw_.bit.swfDisp){
-                disp.postLine(canString, ILI9341_YELLOW);             // display formatted CAN string
-              }
-              if(setMan.getSettingValue(AOSET, DS_AOSSW_POS)){
-                auxSend_filtered(canFiltVal.value[swfNum], canFiltVal.len[swfNum]);   // send CAN msg to AUX SPI output
-              }
-              calcComparaterOut(canFiltVal.value[swfNum], swfNum);
-            }
-          }
+        if(fMode){
+          idSortKey = (eIdSortKey)((idSortKey + 1) % IDSORTMAX);
+          idTop = 0;
         }
+        idTop += step * IDPAGELINES;
+        if(idTop >= idTable.getUsed()) idTop = 0;
+        else if(idTop < 0) idTop = ((idTable.getUsed() - 1) / IDPAGELINES) * IDPAGELINES;
+        drawIdPage();
       }
     }
   }
@@ -863,10 +1847,19 @@ void loop(void) {
   
   // Periodic routine for Melody Player
   mplay.update();
+
+  // Serial command (diagnostics dump)
+  serialCommand();
+  if(fStatStream && statStreamTimer.isExpired()) dumpSwfStats();
   
   // Error detecting every ERRDETPERIOD
   if(errDetTimer.isExpired()){
-    if(CAN.checkError(&mcp_error)){
+    holdMcpRx();
+    byte eflgRes = CAN.checkError(&mcp_error);
+    releaseMcpRx();
+    if(mcp_error & MCP_EFLG_RX0OVR) diagCnt.rx0Ovr++;
+    if(mcp_error & MCP_EFLG_RX1OVR) diagCnt.rx1Ovr++;
+    if(eflgRes){
       // notice the MCP error
       digitalWrite(PIN_ERROR, HIGH);                                // error LED on
       Serial.print("MCP error! code= ");Serial.println(mcp_error);  // error message
@@ -29,15 +29,37 @@
 // **************************************************************************************************************
 
 //FLASHに読み書き格納する 要FlashStorageライブラリ
-FlashStorage(device_settings_flash_0, DeviceSettings);
-FlashStorage(device_settings_flash_1, DeviceSettings);
-FlashStorage(device_settings_flash_2, DeviceSettings);
-FlashStorage(device_settings_flash_3, DeviceSettings);
-FlashStorage(device_settings_flash_4, DeviceSettings);
-FlashStorage(device_settings_flash_5, DeviceSettings);
-FlashStorage(device_settings_flash_6, DeviceSettings);
-FlashStorage(device_settings_flash_7, DeviceSettings);
-FlashStorage(device_settings_flash_temp, DeviceSettings);
+FlashStorage(device_settings_flash_0, DeviceSettingsSlot);
+FlashStorage(device_settings_flash_1, DeviceSettingsSlot);
+FlashStorage(device_settings_flash_2, DeviceSettingsSlot);
+FlashStorage(device_settings_flash_3, DeviceSettingsSlot);
+FlashStorage(device_settings_flash_4, DeviceSettingsSlot);
+FlashStorage(device_settings_flash_5, DeviceSettingsSlot);
+FlashStorage(device_settings_flash_6, DeviceSettingsSlot);
+FlashStorage(device_settings_flash_7, DeviceSettingsSlot);
+FlashStorage(device_settings_flash_temp, DeviceSettingsSlot);
+// eSaveLoadPos順
+static FlashStorageClass<DeviceSettingsSlot>* const deviceSettingsFlash[SLP_MAX] = {
+  &device_settings_flash_0, &device_settings_flash_1, &device_settings_flash_2, &device_settings_flash_3,
+  &device_settings_flash_4, &device_settings_flash_5, &device_settings_flash_6, &device_settings_flash_7,
+  &device_settings_flash_temp
+};
+
+// CRC-32 (IEEE 802.3, 4bit table)
+static uint32_t calcCrc32(const void* data, size_t len){
+  static const uint32_t table[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+  };
+  const uint8_t* p = (const uint8_t*)data;
+  uint32_t crc = 0xFFFFFFFF;
+  while(len--){
+    crc ^= *p++;
+    crc = (crc >> 4) ^ table[crc & 0x0F];
+    crc = (crc >> 4) ^ table[crc & 0x0F];
+  }
+  return ~crc;
+}
 
 
 // **************************************************************************************************************
@@ -45,7 +67,25 @@ FlashStorage(device_settings_flash_temp, DeviceSettings);
 // **************************************************************************************************************
 // 以下eDeviceSettingRegTypeとDeviceSettingsとセットで変更すること
 // 設定記憶域操作クラスの定義
-SettingsManager::SettingsManager(){};
+SettingsManager::SettingsManager(){
+  setDefaultDeviceSettings();
+};
+
+// 現在設定値をdefault値にする (0以外のdefaultを持つものだけ個別に設定)
+void SettingsManager::setDefaultDeviceSettings(){
+  memset(&currentDeviceSetting_, 0, sizeof(DeviceSettings));
+  currentDeviceSetting_.canSpeed = CANSPEEDDEFAULT;
+  for(int i = 0; i < HWFMENUCOUNT; i++) currentDeviceSetting_.hwf[i] = canMFtable[i].defaultValue;
+  for(int i = 0; i < SWFMENUCOUNT; i++){
+    currentDeviceSetting_.swf[i].factorMul = 1;
+    currentDeviceSetting_.swf[i].factorDiv = 1;
+  }
+  for(int i = 0; i < COMENUCOUNT; i++){
+    currentDeviceSetting_.co[i].latchMode = COLM_LEVEL;
+    currentDeviceSetting_.co[i].outType = COOT_DIGITAL;
+  }
+}
+
 
 // 設定値の呼び出し
 int32_t SettingsManager::getSettingValue(eDeviceSettingRegType regType, int regIndex){
@@ -54,6 +94,7 @@ int32_t SettingsManager::getSettingValue(eDeviceSettingRegType regType, int regI
     case HWFFL:     return currentDeviceSetting_.hwffl[regIndex];
     case SWFSW:     return currentDeviceSetting_.swf[regIndex].onoff;
     case SWFSU:     return currentDeviceSetting_.swf[regIndex].sign;
+    case SWFBO:     return currentDeviceSetting_.swf[regIndex].byteOrder;
     case COSW:      return currentDeviceSetting_.co[regIndex].onoff;
     case COPOL:     return currentDeviceSetting_.co[regIndex].pol;
     case AOSET:     return currentDeviceSetting_.ao[regIndex];
@@ -65,7 +106,22 @@ int32_t SettingsManager::getSettingValue(eDeviceSettingRegType regType, int regI
     case SWFSI:     return currentDeviceSetting_.swf[regIndex].startBit;
     case SWFEB:     return currentDeviceSetting_.swf[regIndex].endByte;
     case SWFEI:     return currentDeviceSetting_.swf[regIndex].endBit;
+    case SWFFM:     return currentDeviceSetting_.swf[regIndex].factorMul;
+    case SWFFD:     return currentDeviceSetting_.swf[regIndex].factorDiv;
+    case SWFOF:     return currentDeviceSetting_.swf[regIndex].offset;
+    case SWFML:     return currentDeviceSetting_.swf[regIndex].muxLen;
+    case SWFMB:     return currentDeviceSetting_.swf[regIndex].muxEndByte;
+    case SWFMI:     return currentDeviceSetting_.swf[regIndex].muxEndBit;
+    case SWFMV:     return currentDeviceSetting_.swf[regIndex].muxValue;
     case COUSF:     return currentDeviceSetting_.co[regIndex].usingSwf;
+    case COLM:      return currentDeviceSetting_.co[regIndex].latchMode;
+    case COCR:      return currentDeviceSetting_.co[regIndex].critical;
+    case COHY:      return currentDeviceSetting_.co[regIndex].hysteresis;
+    case COTN:      return currentDeviceSetting_.co[regIndex].onDelay;
+    case COTF:      return currentDeviceSetting_.co[regIndex].offDelay;
+    case COOT:      return currentDeviceSetting_.co[regIndex].outType;
+    case COSP:      return currentDeviceSetting_.co[regIndex].span;
+    case COFS:      return currentDeviceSetting_.co[regIndex].fullFreq;
     //case COTRS:     return currentDeviceSetting_.co[regIndex].threshould;// move to the different return method
     default: DEBUG_PRINT("Error: getSettingValue regType=");DEBUG_PRINTLN(regType); return ERROR_GENERAL; // エラー
   }
@@ -77,16 +133,22 @@ uint64_t SettingsManager::getSettingAnyvalue(eDeviceSettingRegType regType, int
   }
 }
 
+const SoftwareFilter& SettingsManager::getSoftwareFilter(int swfIndex){
+  return currentDeviceSetting_.swf[swfIndex];
+}
+
 // 設定値の範囲内チェック for used other than the any value(COTRS)
 bool SettingsManager::isValidSetting(int32_t value, eDeviceSettingRegType regType, int pageIndex){
   switch(regType){
-    case CANSPEED:
+    case CANSPEED: case COLM: case COOT:
       if(value >= 0 && value < getButtonCount(pageIndex)) return true;
       break;
-    case HWFFL: case SWFSW: case SWFSU: case COSW: case COPOL: case AOSET: case DS_OPSM:
+    case HWFFL: case SWFSW: case SWFSU: case SWFBO: case COSW: case COPOL: case COCR: case AOSET: case DS_OPSM:
       if(value == 0 || value == 1) return true;
       break;
-    case DS_HWF: case SWFID: case SWFSB: case SWFSI: case SWFEB: case SWFEI: case COUSF: case COTRS:
+    case DS_HWF: case SWFID: case SWFSB: case SWFSI: case SWFEB: case SWFEI: case SWFFM: case SWFFD: case SWFOF:
+    case SWFML: case SWFMB: case SWFMI: case SWFMV: case COUSF: case COTRS: case COHY: case COTN: case COTF:
+    case COSP: case COFS:
       // ANY値の場合この関数を呼べないため無条件にfalse
       if(!getValueIsAny(pageIndex) && value >= getValueMin(pageIndex) && value <= getValueMax(pageIndex)) return true;
       break;
@@ -104,6 +166,7 @@ void SettingsManager::setSettingValue(int32_t value, eDeviceSettingRegType regTy
       case HWFFL:    currentDeviceSetting_.hwffl[regIndex] = value;         break;
       case SWFSW:    currentDeviceSetting_.swf[regIndex].onoff = value;     break;
       case SWFSU:    currentDeviceSetting_.swf[regIndex].sign = value;      break;
+      case SWFBO:    currentDeviceSetting_.swf[regIndex].byteOrder = value; break;
       case COSW:     currentDeviceSetting_.co[regIndex].onoff = value;      break;
       case COPOL:    currentDeviceSetting_.co[regIndex].pol = value;        break;
       case AOSET:    currentDeviceSetting_.ao[regIndex] = value;            break;
@@ -114,7 +177,22 @@ void SettingsManager::setSettingValue(int32_t value, eDeviceSettingRegType regTy
       case SWFSI:    currentDeviceSetting_.swf[regIndex].startBit = value;  break;
       case SWFEB:    currentDeviceSetting_.swf[regIndex].endByte = value;   break;
       case SWFEI:    currentDeviceSetting_.swf[regIndex].endBit = value;    break;
+      case SWFFM:    currentDeviceSetting_.swf[regIndex].factorMul = value; break;
+      case SWFFD:    currentDeviceSetting_.swf[regIndex].factorDiv = value; break;
+      case SWFOF:    currentDeviceSetting_.swf[regIndex].offset = value;    break;
+      case SWFML:    currentDeviceSetting_.swf[regIndex].muxLen = value;    break;
+      case SWFMB:    currentDeviceSetting_.swf[regIndex].muxEndByte = value; break;
+      case SWFMI:    currentDeviceSetting_.swf[regIndex].muxEndBit = value; break;
+      case SWFMV:    currentDeviceSetting_.swf[regIndex].muxValue = value;  break;
       case COUSF:    currentDeviceSetting_.co[regIndex].usingSwf = value;   break;
+      case COLM:     currentDeviceSetting_.co[regIndex].latchMode = value;  break;
+      case COCR:     currentDeviceSetting_.co[regIndex].critical = value;   break;
+      case COHY:     currentDeviceSetting_.co[regIndex].hysteresis = value; break;
+      case COTN:     currentDeviceSetting_.co[regIndex].onDelay = value;    break;
+      case COTF:     currentDeviceSetting_.co[regIndex].offDelay = value;   break;
+      case COOT:     currentDeviceSetting_.co[regIndex].outType = value;    break;
+      case COSP:     currentDeviceSetting_.co[regIndex].span = value;       break;
+      case COFS:     currentDeviceSetting_.co[regIndex].fullFreq = value;   break;
       //case COTRS:    currentDeviceSetting_.co[regIndex].threshould = value; break;// move to the overload method
       default: DEBUG_PRINTLN("Error: setSettingValue regType");     break;
     }
@@ -128,68 +206,112 @@ void SettingsManager::setSettingValue(uint64_t value, eDeviceSettingRegType regT
   }
 }
 
+// CO複合条件のテキスト (flashから読んだ値はNUL終端されていないことがある)
+void SettingsManager::getCoRule(int coNum, char* buf, size_t size){
+  if(size == 0) return;
+  size_t n = 0;
+  if(coNum >= 0 && coNum < COMENUCOUNT){
+    const char* rule = currentDeviceSetting_.coRule[coNum];
+    while(n < size - 1 && n < CORULESIZE && rule[n] != '\0'){
+      buf[n] = rule[n];
+      n++;
+    }
+  }
+  buf[n] = '\0';
+}
+void SettingsManager::setCoRule(int coNum, const char* rule){
+  if(coNum < 0 || coNum >= COMENUCOUNT) return;
+  memset(currentDeviceSetting_.coRule[coNum], 0, CORULESIZE);
+  strncpy(currentDeviceSetting_.coRule[coNum], rule, CORULESIZE - 1);
+}
+
 // 現在設定値をFlash領域にsave
 void SettingsManager::saveDeviceSettings(int pos){
-  switch((eSaveLoadPos)pos){
-    case SLP_SL0: device_settings_flash_0.write(currentDeviceSetting_); break;
-    case SLP_SL1: device_settings_flash_1.write(currentDeviceSetting_); break;
-    case SLP_SL2: device_settings_flash_2.write(currentDeviceSetting_); break;
-    case SLP_SL3: device_settings_flash_3.write(currentDeviceSetting_); break;
-    case SLP_SL4: device_settings_flash_4.write(currentDeviceSetting_); break;
-    case SLP_SL5: device_settings_flash_5.write(currentDeviceSetting_); break;
-    case SLP_SL6: device_settings_flash_6.write(currentDeviceSetting_); break;
-    case SLP_SL7: device_settings_flash_7.write(currentDeviceSetting_); break;
-    case SLP_TEMP: device_settings_flash_temp.write(currentDeviceSetting_); break;
-    default: DEBUG_PRINTLN("Error: saveDeviceSettings pos");           return;
+  if(pos < 0 || pos >= SLP_MAX){
+    DEBUG_PRINTLN("Error: saveDeviceSettings pos");
+    return;
+  }
+  slot_.crc = calcSlotCrc();
+  deviceSettingsFlash[pos]->write(slot_);
+  if(pos == SLP_TEMP){
+    tempCrc_ = slot_.crc;
+    fTempValid_ = true;
   }
   DEBUG2_PRINTLN("DeviceSettings SAVED!!");
 }
 
 // 現在設定値をFlash領域からload
-void SettingsManager::loadDeviceSettings(int pos){
-  switch((eSaveLoadPos)pos){
-    case SLP_SL0: currentDeviceSetting_ = device_settings_flash_0.read(); break;
-    case SLP_SL1: currentDeviceSetting_ = device_settings_flash_1.read(); break;
-    case SLP_SL2: currentDeviceSetting_ = device_settings_flash_2.read(); break;
-    case SLP_SL3: currentDeviceSetting_ = device_settings_flash_3.read(); break;
-    case SLP_SL4: currentDeviceSetting_ = device_settings_flash_4.read(); break;
-    case SLP_SL5: currentDeviceSetting_ = device_settings_flash_5.read(); break;
-    case SLP_SL6: currentDeviceSetting_ = device_settings_flash_6.read(); break;
-    case SLP_SL7: currentDeviceSetting_ = device_settings_flash_7.read(); break;
-    case SLP_TEMP: currentDeviceSetting_ = device_settings_flash_temp.read(); break;
-    default: DEBUG_PRINTLN("Error: loadDeviceSettings pos");             return;
+// layout version, 大きさ, CRCのどれかが合わなければ (消去済み, 古い形式, 書込中の電源断) default値にする
+bool SettingsManager::loadDeviceSettings(int pos){
+  if(pos < 0 || pos >= SLP_MAX){
+    DEBUG_PRINTLN("Error: loadDeviceSettings pos");
+    return false;
+  }
+  if(pos == SLP_TEMP) fTempValid_ = false;
+  deviceSettingsFlash[pos]->read(&slot_);
+  bool valid = slot_.layout == DSLAYOUTVERSION && slot_.size == sizeof(DeviceSettings) &&
+               slot_.crc == calcCrc32(&slot_, offsetof(DeviceSettingsSlot, crc));
+  if(!valid){
+    DEBUG_PRINTLN("DeviceSettings invalid, set defaults");
+    setDefaultDeviceSettings();
+    return false;
+  }
+  if(pos == SLP_TEMP){
+    tempCrc_ = slot_.crc;
+    fTempValid_ = true;
   }
   DEBUG2_PRINTLN("DeviceSettings LOADED!!");
+  return true;
+}
+
+// slot_のlayout/sizeを埋めてCRCを計算 (settings, layout, size)
+uint32_t SettingsManager::calcSlotCrc(){
+  slot_.layout = DSLAYOUTVERSION;
+  slot_.size = sizeof(DeviceSettings);
+  return calcCrc32(&slot_, offsetof(DeviceSettingsSlot, crc));
+}
+
+// 現在設定値がflashのtemp領域と同じか (同じなら書込不要)
+// 設定のcopyは持たず、temp領域に書いた/から読んだ時のCRCと比べる
+bool SettingsManager::isTempSaved(){
+  return fTempValid_ && calcSlotCrc() == tempCrc_;
+}
+
+// MCPに書込済みのCAN設定との差分
+// CAN speedを変える時はMCPをresetするのでMask/Filterも全て書き直す
+uint16_t SettingsManager::diffCanSettings(){
+  if(!fCanApplied_) return CANDIFF_SPEED | CANDIFF_HWFALL;
+  if(currentDeviceSetting_.canSpeed != appliedCanSpeed_) return CANDIFF_SPEED | CANDIFF_HWFALL;
+  uint16_t diff = 0;
+  for(int i = 0; i < HWFMENUCOUNT; i++){
+    if(currentDeviceSetting_.hwf[i] != appliedHwf_[i]) diff |= CANDIFF_HWF(i);
+    else if(canMFtable[i].fMaskFilter &&    // filterはID lengthの変更も書き直す
+            currentDeviceSetting_.hwffl[canMFtable[i].num] != appliedHwffl_[canMFtable[i].num]){
+      diff |= CANDIFF_HWF(i);
+    }
+  }
+  return diff;
+}
+
+// 現在設定値をMCPに書込済みとして記録
+void SettingsManager::markCanSettingsApplied(){
+  appliedCanSpeed_ = currentDeviceSetting_.canSpeed;
+  memcpy(appliedHwffl_, currentDeviceSetting_.hwffl, sizeof(appliedHwffl_));
+  memcpy(appliedHwf_, currentDeviceSetting_.hwf, sizeof(appliedHwf_));
+  fCanApplied_ = true;
 }
 
 // bit列抽出用設定のLengthをあらかじめ計算
-// startBit of startByte must be left or same pos from endbit of endByte
+// Start(MSB)はEnd(LSB)より上位のbit位置であること
 void extractLen(SettingsManager *setMan, uint8_t swfIndex, uint8_t *byteLen, uint8_t *bitLen) {
-  uint8_t startByte = setMan->getSettingValue(SWFSB, swfIndex);
-  uint8_t startBit = setMan->getSettingValue(SWFSI, swfIndex);
-  uint8_t endByte = setMan->getSettingValue(SWFEB, swfIndex);
-  uint8_t endBit = setMan->getSettingValue(SWFEI, swfIndex);
-
-  // エラーチェック
-  if (startByte > 7 || endByte > 7 || startBit > 7 || endBit > 7 || (startByte > endByte) || 
-      (startByte == endByte && startBit < endBit)){
+  if (!swfFieldLen(setMan->getSoftwareFilter(swfIndex), byteLen, bitLen)){
     DEBUG_PRINTLN("Error: extractSettings");
-    return;     // error
   }
-  // calc len
-  uint8_t bytl, bitl;
-  if(startByte == endByte){
-    bytl = 1;
-    bitl = startBit - endBit + 1;
-  }
-  else{
-    bytl = ((1 + startBit + 8 - endBit + 8 * (endByte - startByte - 1)) - 1 >> 3) + 1;
-    if(bytl > 4) bytl = 8;
-    else if (bytl > 2) bytl = 4;
-    bitl = startBit + 1 + (endByte - startByte - 1) * 8 + 8 - endBit;
-  }
-  *byteLen = bytl;
-  *bitLen = bitl;
+}
+
+// SWFのfactor/offsetが物理値変換をするか
+bool isScaledSwf(SettingsManager *setMan, uint8_t swfIndex) {
+  return swfIsScaled(setMan->getSoftwareFilter(swfIndex));
 }
 
 
@@ -245,6 +367,7 @@ void IntervalTimer::setDuration(unsigned int newDuration) {
 // Screen Objects *********************************************************************************
 // Common buttons
 const boxObjectInfo boxOI_back = {{180,16,227,47}, 2, ALIGN_CENTER};
+const boxObjectInfo boxOI_swfBank = {{108,16,167,47}, 2, ALIGN_CENTER};   // SWF list page bank change
 const boxObjectColor boxOC_default = {ILI9341_WHITE, ILI9341_BLACK, ILI9341_WHITE, ILI9341_BLACK};
 const boxObjectInfo boxOI_cancel = {{24,240,107,271}, 2, ALIGN_CENTER};
 const boxObjectColor boxOC_cancel = {ILI9341_WHITE, ILI9341_RED, ILI9341_WHITE, ILI9341_BLACK};
@@ -255,10 +378,18 @@ const boxObjectInfo boxOI_notice = {{0,240,239,271}, 4, ALIGN_CENTER};
 const boxObjectColor boxOC_notice = {ILI9341_BLACK, ILI9341_BLACK, ILI9341_PINK, ILI9341_BLACK};
 const boxObjectInfo boxOI_noticeSmall = {{0,304,239,319}, 2, ALIGN_CENTER};
 const boxObjectColor boxOC_noticeSmall = {ILI9341_BLACK, ILI9341_BLACK, ILI9341_PINK, ILI9341_BLACK};
+// Info line
+const boxObjectColor boxOC_info = {ILI9341_BLACK, ILI9341_BLACK, ILI9341_WHITE, ILI9341_BLACK};
 // CAN voltage obj
 const boxObjectInfo boxOI_canVolgate = {{114,0,137,7}, 1, ALIGN_RIGHT};
 const boxObjectColor boxOC_textOnly = {
   STATUSLINE_BACKGROUNDCOLOR, STATUSLINE_BACKGROUNDCOLOR, STATUSLINE_TEXTCOLOR, STATUSLINE_BACKGROUNDCOLOR};
+// caption obj (status lineの先頭)
+const boxObjectInfo boxOI_caption = {{0,0,35,7}, 1, ALIGN_LEFT};
+// bus load obj
+const boxObjectInfo boxOI_busLoad = {{36,0,107,7}, 1, ALIGN_RIGHT};
+const boxObjectColor boxOC_textAlert = {
+  STATUSLINE_BACKGROUNDCOLOR, STATUSLINE_BACKGROUNDCOLOR, ILI9341_RED, STATUSLINE_BACKGROUNDCOLOR};
 // icons
 const boxObjectInfo boxOI_iconHF = {{150,0,161,7}, 1, ALIGN_CENTER};
 const boxObjectInfo boxOI_iconHD = {{162,0,173,7}, 1, ALIGN_CENTER};
@@ -365,7 +496,7 @@ const char* LavelEndBitPos = "EndBit Position";
 const char* LavelOnOff = "ON/OFF";
 const char* LavelByteCount = "Byte Count";
 const char* LavelByteOrder = "Byte Order";
-const char* LavelUsingSwfNo = "Using SWF No. 0-7";
+const char* LavelUsingSwfNo = "Using SWF No. 0-3F";
 const char* LavelThreshould = "Threshould Value";
 const char* LavelOutputPolarity = "Output Polarity";
 const char* LavelSaveToMemory = "Save to Memory";
@@ -391,6 +522,17 @@ const char* LavelSoftwareFilter6 = "SoftwareFilter6";
 const char* LavelSoftwareFilter7 = "SoftwareFilter7";
 const char* LavelBigEndian = "BIG endian";
 const char* LavelLittleEndian = "LITTLE endian";
+const char* LavelMotorola = "Motorola(BIG)";
+const char* LavelIntel = "Intel(LITTLE)";
+const char* LavelValueFormat = "Value Format";
+const char* LavelMultiplexor = "Multiplexor";
+const char* LavelMuxLength = "Mux bitLen 0:off";
+const char* LavelMuxEndByte = "Mux EndByte Pos";
+const char* LavelMuxEndBit = "Mux EndBit Pos";
+const char* LavelMuxValue = "Mux value";
+const char* LavelFactorMul = "Factor numerator";
+const char* LavelFactorDiv = "Factor denominator";
+const char* LavelOffset = "Offset (signed)";
 const char* LavelCo0 = "CO0";
 const char* LavelCo1 = "CO1";
 const char* LavelCo2 = "CO2";
@@ -402,6 +544,22 @@ const char* LavelCompareOut3 = "CompareOut3";
 const char* LavelActive = "Active(Low)";
 const char* LavelInactive = "Inactive(HighZ)";
 const char* LavelIfSwfmsg = "If SWFmsg >= TRS";
+const char* LavelCondition = "Condition";
+const char* LavelHysteresis = "Hysteresis";
+const char* LavelOnDelay = "On delay [ms]";
+const char* LavelOffDelay = "Off delay [ms]";
+const char* LavelOutputMode = "Output Mode";
+const char* LavelLevel = "Level";
+const char* LavelLatch = "Latch";
+const char* LavelToggle = "Toggle";
+const char* LavelCritical = "Critical (ISR)";
+const char* LavelPwmOut = "PWM/Freq Out";
+const char* LavelOutputType = "Output Type";
+const char* LavelDigital = "Digital";
+const char* LavelPwmDuty = "PWM duty";
+const char* LavelFrequency = "Frequency";
+const char* LavelSpan = "Span (TRS+SP=100%)";
+const char* LavelFullFreq = "Full scale [Hz]";
 const char* LavelAuxSpi = "AUX SPI";
 const char* LavelNo = "NO";
 const char* LavelYes = "Yes";
@@ -432,14 +590,16 @@ const char* LavelStandard = "Standard 11bits";
 const char* LavelExtended = "Extended 29bits";
 const char* LavelOption = "Option";
 const char* LavelSwapCE = "Swap C-E SWs";
+const char* LavelDiagnostics = "Diagnostics";
 
 
 // ページの情報 enum ePageと１対１対応
 // List page type *******************************
 const pageInfo_list8 pageList8[] = {
   // MENU_TOP
-  {7, INMONITOR, {CAN_SPEED, HWF, SWF, CO, AO, SL, OP}, 
-   {"CAN speed", "HardWareFilter", "SoftWareFilter", "CompareOutput", "AuxSPIOutput", LavelSaveLoad, "Option"},
+  {8, INMONITOR, {CAN_SPEED, HWF, SWF, CO, AO, SL, OP, DG}, 
+   {"CAN speed", "HardWareFilter", "SoftWareFilter", "CompareOutput", "AuxSPIOutput", LavelSaveLoad, "Option",
+    LavelDiagnostics},
     "SETTINGS","TOP MENU"},
   // HWF
   {8, MENU_TOP, {HWF0, HWFF0, HWFF1, HWF3, HWFF2, HWFF3, HWFF4, HWFF5}, 
@@ -463,6 +623,8 @@ const pageInfo_list8 pageList8[] = {
    ,"SL","Save/Load Setting"},
   // OP
   {1, MENU_TOP, {OPSMCE}, {LavelSwapCE}, LavelOption, "Option Settings"},
+  // DG
+  {3, MENU_TOP, {DGRX, DGSTAT, DGID}, {"RX counters", "SWF statistics", "ID traffic"}, "DIAG", LavelDiagnostics},
   // HWFF0-F5
   {2, HWF, {HWFF0L, HWF1}, {LavelIDlength, LavelFilterValue}, LavelHwfFilter0, "Hardware Filter0"},
   {2, HWF, {HWFF1L, HWF2}, {LavelIDlength, LavelFilterValue}, LavelHwfFilter1, "Hardware Filter1"},
@@ -471,53 +633,145 @@ const pageInfo_list8 pageList8[] = {
   {2, HWF, {HWFF4L, HWF6}, {LavelIDlength, LavelFilterValue}, LavelHwfFilter4, "Hardware Filter4"},
   {2, HWF, {HWFF5L, HWF7}, {LavelIDlength, LavelFilterValue}, LavelHwfFilter5, "Hardware Filter5"},
   // SWF0
-  {7, SWF, {SWF0SW, SWF0ID, SWF0SB, SWF0SI, SWF0EB, SWF0EI, SWF0SU}, 
-   {LavelOnOff, LavelCanId, LavelStartBytePos, LavelStartBitPos, LavelEndBytePos, LavelEndBitPos, LavelSignedUnsigned}
+  {8, SWF, {SWF0SW, SWF0ID, SWF0SB, SWF0SI, SWF0EB, SWF0EI, SWF0SC, SWF0MX}, 
+   {LavelOnOff, LavelCanId, LavelStartBytePos, LavelStartBitPos, LavelEndBytePos, LavelEndBitPos, LavelValueFormat,
+    LavelMultiplexor}
    ,LavelSwf0,LavelSoftwareFilter0},
   // SWF1
-  {7, SWF, {SWF1SW, SWF1ID, SWF1SB, SWF1SI, SWF1EB, SWF1EI, SWF1SU}, 
-   {LavelOnOff, LavelCanId, LavelStartBytePos, LavelStartBitPos, LavelEndBytePos, LavelEndBitPos, LavelSignedUnsigned}
+  {8, SWF, {SWF1SW, SWF1ID, SWF1SB, SWF1SI, SWF1EB, SWF1EI, SWF1SC, SWF1MX}, 
+   {LavelOnOff, LavelCanId, LavelStartBytePos, LavelStartBitPos, LavelEndBytePos, LavelEndBitPos, LavelValueFormat,
+    LavelMultiplexor}
    ,LavelSwf1,LavelSoftwareFilter1},
   // SWF2
-  {7, SWF, {SWF2SW, SWF2ID, SWF2SB, SWF2SI, SWF2EB, SWF2EI, SWF2SU}, 
-   {LavelOnOff, LavelCanId, LavelStartBytePos, LavelStartBitPos, LavelEndBytePos, LavelEndBitPos, LavelSignedUnsigned}
+  {8, SWF, {SWF2SW, SWF2ID, SWF2SB, SWF2SI, SWF2EB, SWF2EI, SWF2SC, SWF2MX}, 
+   {LavelOnOff, LavelCanId, LavelStartBytePos, LavelStartBitPos, LavelEndBytePos, LavelEndBitPos, LavelValueFormat,
+    LavelMultiplexor}
    ,LavelSwf2,LavelSoftwareFilter2},
   // SWF3
-  {7, SWF, {SWF3SW, SWF3ID, SWF3SB, SWF3SI, SWF3EB, SWF3EI, SWF3SU}, 
-   {LavelOnOff, LavelCanId, LavelStartBytePos, LavelStartBitPos, LavelEndBytePos, LavelEndBitPos, LavelSignedUnsigned}
+  {8, SWF, {SWF3SW, SWF3ID, SWF3SB, SWF3SI, SWF3EB, SWF3EI, SWF3SC, SWF3MX}, 
+   {LavelOnOff, LavelCanId, LavelStartBytePos, LavelStartBitPos, LavelEndBytePos, LavelEndBitPos, LavelValueFormat,
+    LavelMultiplexor}
    ,LavelSwf3,LavelSoftwareFilter3},
   // SWF4
-  {7, SWF, {SWF4SW, SWF4ID, SWF4SB, SWF4SI, SWF4EB, SWF4EI, SWF4SU}, 
-   {LavelOnOff, LavelCanId, LavelStartBytePos, LavelStartBitPos, LavelEndBytePos, LavelEndBitPos, LavelSignedUnsigned}
+  {8, SWF, {SWF4SW, SWF4ID, SWF4SB, SWF4SI, SWF4EB, SWF4EI, SWF4SC, SWF4MX}, 
+   {LavelOnOff, LavelCanId, LavelStartBytePos, LavelStartBitPos, LavelEndBytePos, LavelEndBitPos, LavelValueFormat,
+    LavelMultiplexor}
    ,LavelSwf4,LavelSoftwareFilter4},
   // SWF5
-  {7, SWF, {SWF5SW, SWF5ID, SWF5SB, SWF5SI, SWF5EB, SWF5EI, SWF5SU}, 
-   {LavelOnOff, LavelCanId, LavelStartBytePos, LavelStartBitPos, LavelEndBytePos, LavelEndBitPos, LavelSignedUnsigned}
+  {8, SWF, {SWF5SW, SWF5ID, SWF5SB, SWF5SI, SWF5EB, SWF5EI, SWF5SC, SWF5MX}, 
+   {LavelOnOff, LavelCanId, LavelStartBytePos, LavelStartBitPos, LavelEndBytePos, LavelEndBitPos, LavelValueFormat,
+    LavelMultiplexor}
    ,LavelSwf5,LavelSoftwareFilter5},
   // SWF6
-  {7, SWF, {SWF6SW, SWF6ID, SWF6SB, SWF6SI, SWF6EB, SWF6EI, SWF6SU}, 
-   {LavelOnOff, LavelCanId, LavelStartBytePos, LavelStartBitPos, LavelEndBytePos, LavelEndBitPos, LavelSignedUnsigned}
+  {8, SWF, {SWF6SW, SWF6ID, SWF6SB, SWF6SI, SWF6EB, SWF6EI, SWF6SC, SWF6MX}, 
+   {LavelOnOff, LavelCanId, LavelStartBytePos, LavelStartBitPos, LavelEndBytePos, LavelEndBitPos, LavelValueFormat,
+    LavelMultiplexor}
    ,LavelSwf6,LavelSoftwareFilter6},
   // SWF7
-  {7, SWF, {SWF7SW, SWF7ID, SWF7SB, SWF7SI, SWF7EB, SWF7EI, SWF7SU}, 
-   {LavelOnOff, LavelCanId, LavelStartBytePos, LavelStartBitPos, LavelEndBytePos, LavelEndBitPos, LavelSignedUnsigned}
+  {8, SWF, {SWF7SW, SWF7ID, SWF7SB, SWF7SI, SWF7EB, SWF7EI, SWF7SC, SWF7MX}, 
+   {LavelOnOff, LavelCanId, LavelStartBytePos, LavelStartBitPos, LavelEndBytePos, LavelEndBitPos, LavelValueFormat,
+    LavelMultiplexor}
    ,LavelSwf7,LavelSoftwareFilter7},
+  // SWF0SC
+  {5, SWF0, {SWF0SU, SWF0BO, SWF0FM, SWF0FD, SWF0OF},
+   {LavelSignedUnsigned, LavelByteOrder, LavelFactorMul, LavelFactorDiv, LavelOffset}
+   ,LavelSwf0,LavelValueFormat},
+  // SWF1SC
+  {5, SWF1, {SWF1SU, SWF1BO, SWF1FM, SWF1FD, SWF1OF},
+   {LavelSignedUnsigned, LavelByteOrder, LavelFactorMul, LavelFactorDiv, LavelOffset}
+   ,LavelSwf1,LavelValueFormat},
+  // SWF2SC
+  {5, SWF2, {SWF2SU, SWF2BO, SWF2FM, SWF2FD, SWF2OF},
+   {LavelSignedUnsigned, LavelByteOrder, LavelFactorMul, LavelFactorDiv, LavelOffset}
+   ,LavelSwf2,LavelValueFormat},
+  // SWF3SC
+  {5, SWF3, {SWF3SU, SWF3BO, SWF3FM, SWF3FD, SWF3OF},
+   {LavelSignedUnsigned, LavelByteOrder, LavelFactorMul, LavelFactorDiv, LavelOffset}
+   ,LavelSwf3,LavelValueFormat},
+  // SWF4SC
+  {5, SWF4, {SWF4SU, SWF4BO, SWF4FM, SWF4FD, SWF4OF},
+   {LavelSignedUnsigned, LavelByteOrder, LavelFactorMul, LavelFactorDiv, LavelOffset}
+   ,LavelSwf4,LavelValueFormat},
+  // SWF5SC
+  {5, SWF5, {SWF5SU, SWF5BO, SWF5FM, SWF5FD, SWF5OF},
+   {LavelSignedUnsigned, LavelByteOrder, LavelFactorMul, LavelFactorDiv, LavelOffset}
+   ,LavelSwf5,LavelValueFormat},
+  // SWF6SC
+  {5, SWF6, {SWF6SU, SWF6BO, SWF6FM, SWF6FD, SWF6OF},
+   {LavelSignedUnsigned, LavelByteOrder, LavelFactorMul, LavelFactorDiv, LavelOffset}
+   ,LavelSwf6,LavelValueFormat},
+  // SWF7SC
+  {5, SWF7, {SWF7SU, SWF7BO, SWF7FM, SWF7FD, SWF7OF},
+   {LavelSignedUnsigned, LavelByteOrder, LavelFactorMul, LavelFactorDiv, LavelOffset}
+   ,LavelSwf7,LavelValueFormat},
+  // SWF0MX
+  {4, SWF0, {SWF0ML, SWF0MB, SWF0MI, SWF0MV}, {LavelMuxLength, LavelMuxEndByte, LavelMuxEndBit, LavelMuxValue}
+   ,LavelSwf0,LavelMultiplexor},
+  // SWF1MX
+  {4, SWF1, {SWF1ML, SWF1MB, SWF1MI, SWF1MV}, {LavelMuxLength, LavelMuxEndByte, LavelMuxEndBit, LavelMuxValue}
+   ,LavelSwf1,LavelMultiplexor},
+  // SWF2MX
+  {4, SWF2, {SWF2ML, SWF2MB, SWF2MI, SWF2MV}, {LavelMuxLength, LavelMuxEndByte, LavelMuxEndBit, LavelMuxValue}
+   ,LavelSwf2,LavelMultiplexor},
+  // SWF3MX
+  {4, SWF3, {SWF3ML, SWF3MB, SWF3MI, SWF3MV}, {LavelMuxLength, LavelMuxEndByte, LavelMuxEndBit, LavelMuxValue}
+   ,LavelSwf3,LavelMultiplexor},
+  // SWF4MX
+  {4, SWF4, {SWF4ML, SWF4MB, SWF4MI, SWF4MV}, {LavelMuxLength, LavelMuxEndByte, LavelMuxEndBit, LavelMuxValue}
+   ,LavelSwf4,LavelMultiplexor},
+  // SWF5MX
+  {4, SWF5, {SWF5ML, SWF5MB, SWF5MI, SWF5MV}, {LavelMuxLength, LavelMuxEndByte, LavelMuxEndBit, LavelMuxValue}
+   ,LavelSwf5,LavelMultiplexor},
+  // SWF6MX
+  {4, SWF6, {SWF6ML, SWF6MB, SWF6MI, SWF6MV}, {LavelMuxLength, LavelMuxEndByte, LavelMuxEndBit, LavelMuxValue}
+   ,LavelSwf6,LavelMultiplexor},
+  // SWF7MX
+  {4, SWF7, {SWF7ML, SWF7MB, SWF7MI, SWF7MV}, {LavelMuxLength, LavelMuxEndByte, LavelMuxEndBit, LavelMuxValue}
+   ,LavelSwf7,LavelMultiplexor},
   // CO0
-  {4, CO, {CO0SW, CO0USF, CO0TRS, CO0POL}, 
-   {LavelOnOff, LavelUsingSwfNo, LavelThreshould, LavelOutputPolarity}
+  {6, CO, {CO0SW, CO0USF, CO0TRS, CO0POL, CO0CN, CO0PW}, 
+   {LavelOnOff, LavelUsingSwfNo, LavelThreshould, LavelOutputPolarity, LavelCondition, LavelPwmOut}
    ,LavelCo0,LavelCompareOut0},
   // CO1
-  {4, CO, {CO1SW, CO1USF, CO1TRS, CO1POL}, 
-   {LavelOnOff, LavelUsingSwfNo, LavelThreshould, LavelOutputPolarity}
+  {6, CO, {CO1SW, CO1USF, CO1TRS, CO1POL, CO1CN, CO1PW}, 
+   {LavelOnOff, LavelUsingSwfNo, LavelThreshould, LavelOutputPolarity, LavelCondition, LavelPwmOut}
    ,LavelCo1,LavelCompareOut1},
   // CO2
-  {4, CO, {CO2SW, CO2USF, CO2TRS, CO2POL}, 
-   {LavelOnOff, LavelUsingSwfNo, LavelThreshould, LavelOutputPolarity}
+  {6, CO, {CO2SW, CO2USF, CO2TRS, CO2POL, CO2CN, CO2PW}, 
+   {LavelOnOff, LavelUsingSwfNo, LavelThreshould, LavelOutputPolarity, LavelCondition, LavelPwmOut}
    ,LavelCo2,LavelCompareOut2},
   // CO3
-  {4, CO, {CO3SW, CO3USF, CO3TRS, CO3POL}, 
-   {LavelOnOff, LavelUsingSwfNo, LavelThreshould, LavelOutputPolarity}
+  {6, CO, {CO3SW, CO3USF, CO3TRS, CO3POL, CO3CN, CO3PW}, 
+   {LavelOnOff, LavelUsingSwfNo, LavelThreshould, LavelOutputPolarity, LavelCondition, LavelPwmOut}
    ,LavelCo3,LavelCompareOut3},
+  // CO0CN
+  {5, CO0, {CO0HY, CO0TN, CO0TF, CO0LM, CO0CR},
+   {LavelHysteresis, LavelOnDelay, LavelOffDelay, LavelOutputMode, LavelCritical}
+   ,LavelCo0,LavelCondition},
+  // CO1CN
+  {5, CO1, {CO1HY, CO1TN, CO1TF, CO1LM, CO1CR},
+   {LavelHysteresis, LavelOnDelay, LavelOffDelay, LavelOutputMode, LavelCritical}
+   ,LavelCo1,LavelCondition},
+  // CO2CN
+  {5, CO2, {CO2HY, CO2TN, CO2TF, CO2LM, CO2CR},
+   {LavelHysteresis, LavelOnDelay, LavelOffDelay, LavelOutputMode, LavelCritical}
+   ,LavelCo2,LavelCondition},
+  // CO3CN
+  {5, CO3, {CO3HY, CO3TN, CO3TF, CO3LM, CO3CR},
+   {LavelHysteresis, LavelOnDelay, LavelOffDelay, LavelOutputMode, LavelCritical}
+   ,LavelCo3,LavelCondition},
+  // CO0PW
+  {3, CO0, {CO0OT, CO0SP, CO0FS}, {LavelOutputType, LavelSpan, LavelFullFreq}
+   ,LavelCo0,LavelPwmOut},
+  // CO1PW
+  {3, CO1, {CO1OT, CO1SP, CO1FS}, {LavelOutputType, LavelSpan, LavelFullFreq}
+   ,LavelCo1,LavelPwmOut},
+  // CO2PW
+  {3, CO2, {CO2OT, CO2SP, CO2FS}, {LavelOutputType, LavelSpan, LavelFullFreq}
+   ,LavelCo2,LavelPwmOut},
+  // CO3PW
+  {3, CO3, {CO3OT, CO3SP, CO3FS}, {LavelOutputType, LavelSpan, LavelFullFreq}
+   ,LavelCo3,LavelPwmOut},
   // SL0
   {2, SL, {SL0SV, SL0LD}, {LavelSaveToMemory, LavelLoadFromMemory},LavelSl0,LavelSaveLoad},
   // SL1
@@ -560,14 +814,23 @@ const pageInfo_button8 pageButton8[] = {
   {2, SWF6, {LavelOff, LavelOn},LavelSwf6,LavelSoftwareFilter6},
   {2, SWF7, {LavelOff, LavelOn},LavelSwf7,LavelSoftwareFilter7}, 
   // SWFxSU
-  {2, SWF0, {LavelUnsigned, LavelSigned},LavelSwf0,LavelSignedUnsigned},
-  {2, SWF1, {LavelUnsigned, LavelSigned},LavelSwf1,LavelSignedUnsigned},
-  {2, SWF2, {LavelUnsigned, LavelSigned},LavelSwf2,LavelSignedUnsigned},
-  {2, SWF3, {LavelUnsigned, LavelSigned},LavelSwf3,LavelSignedUnsigned},
-  {2, SWF4, {LavelUnsigned, LavelSigned},LavelSwf4,LavelSignedUnsigned},
-  {2, SWF5, {LavelUnsigned, LavelSigned},LavelSwf5,LavelSignedUnsigned},
-  {2, SWF6, {LavelUnsigned, LavelSigned},LavelSwf6,LavelSignedUnsigned},
-  {2, SWF7, {LavelUnsigned, LavelSigned},LavelSwf7,LavelSignedUnsigned},
+  {2, SWF0SC, {LavelUnsigned, LavelSigned},LavelSwf0,LavelSignedUnsigned},
+  {2, SWF1SC, {LavelUnsigned, LavelSigned},LavelSwf1,LavelSignedUnsigned},
+  {2, SWF2SC, {LavelUnsigned, LavelSigned},LavelSwf2,LavelSignedUnsigned},
+  {2, SWF3SC, {LavelUnsigned, LavelSigned},LavelSwf3,LavelSignedUnsigned},
+  {2, SWF4SC, {LavelUnsigned, LavelSigned},LavelSwf4,LavelSignedUnsigned},
+  {2, SWF5SC, {LavelUnsigned, LavelSigned},LavelSwf5,LavelSignedUnsigned},
+  {2, SWF6SC, {LavelUnsigned, LavelSigned},LavelSwf6,LavelSignedUnsigned},
+  {2, SWF7SC, {LavelUnsigned, LavelSigned},LavelSwf7,LavelSignedUnsigned},
+  // SWFxBO
+  {2, SWF0SC, {LavelMotorola, LavelIntel},LavelSwf0,LavelByteOrder},
+  {2, SWF1SC, {LavelMotorola, LavelIntel},LavelSwf1,LavelByteOrder},
+  {2, SWF2SC, {LavelMotorola, LavelIntel},LavelSwf2,LavelByteOrder},
+  {2, SWF3SC, {LavelMotorola, LavelIntel},LavelSwf3,LavelByteOrder},
+  {2, SWF4SC, {LavelMotorola, LavelIntel},LavelSwf4,LavelByteOrder},
+  {2, SWF5SC, {LavelMotorola, LavelIntel},LavelSwf5,LavelByteOrder},
+  {2, SWF6SC, {LavelMotorola, LavelIntel},LavelSwf6,LavelByteOrder},
+  {2, SWF7SC, {LavelMotorola, LavelIntel},LavelSwf7,LavelByteOrder},
   // COxSW
   {2, CO0, {LavelOff, LavelOn},LavelCo0,LavelCompareOut0},
   {2, CO1, {LavelOff, LavelOn},LavelCo1,LavelCompareOut1},
@@ -578,6 +841,21 @@ const pageInfo_button8 pageButton8[] = {
   {2, CO1, {LavelActive, LavelInactive},LavelCo1,LavelIfSwfmsg},
   {2, CO2, {LavelActive, LavelInactive},LavelCo2,LavelIfSwfmsg},
   {2, CO3, {LavelActive, LavelInactive},LavelCo3,LavelIfSwfmsg},
+  // COxLM
+  {COLMCOUNT, CO0CN, {LavelLevel, LavelLatch, LavelToggle},LavelCo0,LavelOutputMode},
+  {COLMCOUNT, CO1CN, {LavelLevel, LavelLatch, LavelToggle},LavelCo1,LavelOutputMode},
+  {COLMCOUNT, CO2CN, {LavelLevel, LavelLatch, LavelToggle},LavelCo2,LavelOutputMode},
+  {COLMCOUNT, CO3CN, {LavelLevel, LavelLatch, LavelToggle},LavelCo3,LavelOutputMode},
+  // COxCR
+  {2, CO0CN, {LavelOff, LavelOn},LavelCo0,LavelCritical},
+  {2, CO1CN, {LavelOff, LavelOn},LavelCo1,LavelCritical},
+  {2, CO2CN, {LavelOff, LavelOn},LavelCo2,LavelCritical},
+  {2, CO3CN, {LavelOff, LavelOn},LavelCo3,LavelCritical},
+  // COxOT
+  {COOTCOUNT, CO0PW, {LavelDigital, LavelPwmDuty, LavelFrequency},LavelCo0,LavelOutputType},
+  {COOTCOUNT, CO1PW, {LavelDigital, LavelPwmDuty, LavelFrequency},LavelCo1,LavelOutputType},
+  {COOTCOUNT, CO2PW, {LavelDigital, LavelPwmDuty, LavelFrequency},LavelCo2,LavelOutputType},
+  {COOTCOUNT, CO3PW, {LavelDigital, LavelPwmDuty, LavelFrequency},LavelCo3,LavelOutputType},
   // AOHSW, AOSSW, AOSBO
   {2, AO, {LavelOff, LavelOn},LavelAuxSpi,"HWFout to SPI"},
   {2, AO, {LavelOff, LavelOn},LavelAuxSpi,"SWFout to SPI"},
@@ -666,16 +944,104 @@ const pageInfo_value pageValue[] = {
   {SWF5, 1, VALUEISLIMITED, 0, 7, LavelSwf5, LavelEndBitPos},
   {SWF6, 1, VALUEISLIMITED, 0, 7, LavelSwf6, LavelEndBitPos},
   {SWF7, 1, VALUEISLIMITED, 0, 7, LavelSwf7, LavelEndBitPos},
+  // SWFxFM
+  {SWF0SC, 4, VALUEISLIMITED, 1, 0xFFFF, LavelSwf0, LavelFactorMul},
+  {SWF1SC, 4, VALUEISLIMITED, 1, 0xFFFF, LavelSwf1, LavelFactorMul},
+  {SWF2SC, 4, VALUEISLIMITED, 1, 0xFFFF, LavelSwf2, LavelFactorMul},
+  {SWF3SC, 4, VALUEISLIMITED, 1, 0xFFFF, LavelSwf3, LavelFactorMul},
+  {SWF4SC, 4, VALUEISLIMITED, 1, 0xFFFF, LavelSwf4, LavelFactorMul},
+  {SWF5SC, 4, VALUEISLIMITED, 1, 0xFFFF, LavelSwf5, LavelFactorMul},
+  {SWF6SC, 4, VALUEISLIMITED, 1, 0xFFFF, LavelSwf6, LavelFactorMul},
+  {SWF7SC, 4, VALUEISLIMITED, 1, 0xFFFF, LavelSwf7, LavelFactorMul},
+  // SWFxFD
+  {SWF0SC, 4, VALUEISLIMITED, 1, 0xFFFF, LavelSwf0, LavelFactorDiv},
+  {SWF1SC, 4, VALUEISLIMITED, 1, 0xFFFF, LavelSwf1, LavelFactorDiv},
+  {SWF2SC, 4, VALUEISLIMITED, 1, 0xFFFF, LavelSwf2, LavelFactorDiv},
+  {SWF3SC, 4, VALUEISLIMITED, 1, 0xFFFF, LavelSwf3, LavelFactorDiv},
+  {SWF4SC, 4, VALUEISLIMITED, 1, 0xFFFF, LavelSwf4, LavelFactorDiv},
+  {SWF5SC, 4, VALUEISLIMITED, 1, 0xFFFF, LavelSwf5, LavelFactorDiv},
+  {SWF6SC, 4, VALUEISLIMITED, 1, 0xFFFF, LavelSwf6, LavelFactorDiv},
+  {SWF7SC, 4, VALUEISLIMITED, 1, 0xFFFF, LavelSwf7, LavelFactorDiv},
+  // SWFxOF
+  {SWF0SC, 8, VALUEISLIMITED, INT32_MIN, INT32_MAX, LavelSwf0, LavelOffset},
+  {SWF1SC, 8, VALUEISLIMITED, INT32_MIN, INT32_MAX, LavelSwf1, LavelOffset},
+  {SWF2SC, 8, VALUEISLIMITED, INT32_MIN, INT32_MAX, LavelSwf2, LavelOffset},
+  {SWF3SC, 8, VALUEISLIMITED, INT32_MIN, INT32_MAX, LavelSwf3, LavelOffset},
+  {SWF4SC, 8, VALUEISLIMITED, INT32_MIN, INT32_MAX, LavelSwf4, LavelOffset},
+  {SWF5SC, 8, VALUEISLIMITED, INT32_MIN, INT32_MAX, LavelSwf5, LavelOffset},
+  {SWF6SC, 8, VALUEISLIMITED, INT32_MIN, INT32_MAX, LavelSwf6, LavelOffset},
+  {SWF7SC, 8, VALUEISLIMITED, INT32_MIN, INT32_MAX, LavelSwf7, LavelOffset},
+  // SWFxML
+  {SWF0MX, 2, VALUEISLIMITED, 0, SWFMUXLENMAX, LavelSwf0, LavelMuxLength},
+  {SWF1MX, 2, VALUEISLIMITED, 0, SWFMUXLENMAX, LavelSwf1, LavelMuxLength},
+  {SWF2MX, 2, VALUEISLIMITED, 0, SWFMUXLENMAX, LavelSwf2, LavelMuxLength},
+  {SWF3MX, 2, VALUEISLIMITED, 0, SWFMUXLENMAX, LavelSwf3, LavelMuxLength},
+  {SWF4MX, 2, VALUEISLIMITED, 0, SWFMUXLENMAX, LavelSwf4, LavelMuxLength},
+  {SWF5MX, 2, VALUEISLIMITED, 0, SWFMUXLENMAX, LavelSwf5, LavelMuxLength},
+  {SWF6MX, 2, VALUEISLIMITED, 0, SWFMUXLENMAX, LavelSwf6, LavelMuxLength},
+  {SWF7MX, 2, VALUEISLIMITED, 0, SWFMUXLENMAX, LavelSwf7, LavelMuxLength},
+  // SWFxMB
+  {SWF0MX, 1, VALUEISLIMITED, 0, 7, LavelSwf0, LavelMuxEndByte},
+  {SWF1MX, 1, VALUEISLIMITED, 0, 7, LavelSwf1, LavelMuxEndByte},
+  {SWF2MX, 1, VALUEISLIMITED, 0, 7, LavelSwf2, LavelMuxEndByte},
+  {SWF3MX, 1, VALUEISLIMITED, 0, 7, LavelSwf3, LavelMuxEndByte},
+  {SWF4MX, 1, VALUEISLIMITED, 0, 7, LavelSwf4, LavelMuxEndByte},
+  {SWF5MX, 1, VALUEISLIMITED, 0, 7, LavelSwf5, LavelMuxEndByte},
+  {SWF6MX, 1, VALUEISLIMITED, 0, 7, LavelSwf6, LavelMuxEndByte},
+  {SWF7MX, 1, VALUEISLIMITED, 0, 7, LavelSwf7, LavelMuxEndByte},
+  // SWFxMI
+  {SWF0MX, 1, VALUEISLIMITED, 0, 7, LavelSwf0, LavelMuxEndBit},
+  {SWF1MX, 1, VALUEISLIMITED, 0, 7, LavelSwf1, LavelMuxEndBit},
+  {SWF2MX, 1, VALUEISLIMITED, 0, 7, LavelSwf2, LavelMuxEndBit},
+  {SWF3MX, 1, VALUEISLIMITED, 0, 7, LavelSwf3, LavelMuxEndBit},
+  {SWF4MX, 1, VALUEISLIMITED, 0, 7, LavelSwf4, LavelMuxEndBit},
+  {SWF5MX, 1, VALUEISLIMITED, 0, 7, LavelSwf5, LavelMuxEndBit},
+  {SWF6MX, 1, VALUEISLIMITED, 0, 7, LavelSwf6, LavelMuxEndBit},
+  {SWF7MX, 1, VALUEISLIMITED, 0, 7, LavelSwf7, LavelMuxEndBit},
+  // SWFxMV
+  {SWF0MX, 4, VALUEISLIMITED, 0, 0xFFFF, LavelSwf0, LavelMuxValue},
+  {SWF1MX, 4, VALUEISLIMITED, 0, 0xFFFF, LavelSwf1, LavelMuxValue},
+  {SWF2MX, 4, VALUEISLIMITED, 0, 0xFFFF, LavelSwf2, LavelMuxValue},
+  {SWF3MX, 4, VALUEISLIMITED, 0, 0xFFFF, LavelSwf3, LavelMuxValue},
+  {SWF4MX, 4, VALUEISLIMITED, 0, 0xFFFF, LavelSwf4, LavelMuxValue},
+  {SWF5MX, 4, VALUEISLIMITED, 0, 0xFFFF, LavelSwf5, LavelMuxValue},
+  {SWF6MX, 4, VALUEISLIMITED, 0, 0xFFFF, LavelSwf6, LavelMuxValue},
+  {SWF7MX, 4, VALUEISLIMITED, 0, 0xFFFF, LavelSwf7, LavelMuxValue},
   // COxUSF
-  {CO0, 1, VALUEISLIMITED, 0, 7, LavelCo0, LavelUsingSwfNo}, 
-  {CO1, 1, VALUEISLIMITED, 0, 7, LavelCo1, LavelUsingSwfNo}, 
-  {CO2, 1, VALUEISLIMITED, 0, 7, LavelCo2, LavelUsingSwfNo}, 
-  {CO3, 1, VALUEISLIMITED, 0, 7, LavelCo3, LavelUsingSwfNo}, 
+  {CO0, 2, VALUEISLIMITED, 0, SWFCOUNT - 1, LavelCo0, LavelUsingSwfNo}, 
+  {CO1, 2, VALUEISLIMITED, 0, SWFCOUNT - 1, LavelCo1, LavelUsingSwfNo}, 
+  {CO2, 2, VALUEISLIMITED, 0, SWFCOUNT - 1, LavelCo2, LavelUsingSwfNo}, 
+  {CO3, 2, VALUEISLIMITED, 0, SWFCOUNT - 1, LavelCo3, LavelUsingSwfNo}, 
   // COxTRS
   {CO0, 8, VALUEISANY, 0, 0, LavelCo0, LavelThreshould},
   {CO1, 8, VALUEISANY, 0, 0, LavelCo1, LavelThreshould},
   {CO2, 8, VALUEISANY, 0, 0, LavelCo2, LavelThreshould},
   {CO3, 8, VALUEISANY, 0, 0, LavelCo3, LavelThreshould},
+  // COxHY
+  {CO0CN, 8, VALUEISLIMITED, 0, INT32_MAX, LavelCo0, LavelHysteresis},
+  {CO1CN, 8, VALUEISLIMITED, 0, INT32_MAX, LavelCo1, LavelHysteresis},
+  {CO2CN, 8, VALUEISLIMITED, 0, INT32_MAX, LavelCo2, LavelHysteresis},
+  {CO3CN, 8, VALUEISLIMITED, 0, INT32_MAX, LavelCo3, LavelHysteresis},
+  // COxTN
+  {CO0CN, 4, VALUEISLIMITED, 0, 0xFFFF, LavelCo0, LavelOnDelay},
+  {CO1CN, 4, VALUEISLIMITED, 0, 0xFFFF, LavelCo1, LavelOnDelay},
+  {CO2CN, 4, VALUEISLIMITED, 0, 0xFFFF, LavelCo2, LavelOnDelay},
+  {CO3CN, 4, VALUEISLIMITED, 0, 0xFFFF, LavelCo3, LavelOnDelay},
+  // COxTF
+  {CO0CN, 4, VALUEISLIMITED, 0, 0xFFFF, LavelCo0, LavelOffDelay},
+  {CO1CN, 4, VALUEISLIMITED, 0, 0xFFFF, LavelCo1, LavelOffDelay},
+  {CO2CN, 4, VALUEISLIMITED, 0, 0xFFFF, LavelCo2, LavelOffDelay},
+  {CO3CN, 4, VALUEISLIMITED, 0, 0xFFFF, LavelCo3, LavelOffDelay},
+  // COxSP
+  {CO0PW, 8, VALUEISLIMITED, 1, INT32_MAX, LavelCo0, LavelSpan},
+  {CO1PW, 8, VALUEISLIMITED, 1, INT32_MAX, LavelCo1, LavelSpan},
+  {CO2PW, 8, VALUEISLIMITED, 1, INT32_MAX, LavelCo2, LavelSpan},
+  {CO3PW, 8, VALUEISLIMITED, 1, INT32_MAX, LavelCo3, LavelSpan},
+  // COxFS
+  {CO0PW, 4, VALUEISLIMITED, 1, 0xFFFF, LavelCo0, LavelFullFreq},
+  {CO1PW, 4, VALUEISLIMITED, 1, 0xFFFF, LavelCo1, LavelFullFreq},
+  {CO2PW, 4, VALUEISLIMITED, 1, 0xFFFF, LavelCo2, LavelFullFreq},
+  {CO3PW, 4, VALUEISLIMITED, 1, 0xFFFF, LavelCo3, LavelFullFreq},
 };
 
 // 値のmax,min,isSignedを返すインタフェース
@@ -689,6 +1055,17 @@ bool getValueIsAny(int pageIndex){
   return pageValue[pageIndex].isAnyVal;
 }
 
+// Info page type *******************************
+// ページの情報 enum ePageと１対１対応
+const pageInfo_info pageInfo[] = {
+  // DGRX
+  {DG, 8, "RX DIAG", "E:reset counters"},
+  // DGSTAT
+  {DG, 8, "SWF STAT", "U/D:SWF E:reset"},
+  // DGID
+  {DG, 8, "ID TRAFFIC", "U/D L/R:sort E:clr"},
+};
+
 // CAN Mask and Filter setting screen table
 const canMaskFilterTable canMFtable[HWFMENUCOUNT] = {
   {F_MFTMASK, 0, CANMASKVAL0}, {F_MFTFILTER, 0, CANFILTERVAL0},
@@ -705,7 +1082,8 @@ const canMaskFilterTable canMFtable[HWFMENUCOUNT] = {
 ePageType page2pageType(ePage page){
   ePageType pageType = ERROR;
   if(page >= PAGEMAX); // pageType = ERROR
-  else if(page > VALUE_TYPE) pageType = VALUE;
+  else if(page > INFO_TYPE) pageType = INFO;
+  else if(page > VALUE_TYPE && page < INFO_TYPE) pageType = VALUE;
   else if(page > BUTTON_TYPE && page < VALUE_TYPE) pageType = BUTTON8;
   else if(page > LIST_TYPE && page < BUTTON_TYPE) pageType = LIST8;
   else if(page > MONITOR_TYPE && page < LIST_TYPE) pageType = MONITOR;
@@ -720,6 +1098,7 @@ ePageType page2pageType(ePage page){
 int page2pageIndex(ePage page){
   int retval = ERROR;
   switch(page2pageType(page)){
+    case INFO: return page - (INFO_TYPE + 1);
     case VALUE: return page - (VALUE_TYPE + 1);
     case BUTTON8: return page - (BUTTON_TYPE + 1);
     case LIST8: return page - (LIST_TYPE + 1);
@@ -736,8 +1115,20 @@ void page2typeIndexes(ePage page, int &pageIndex, eDeviceSettingRegType &regType
   // making the device setting reg type and the reg index
   switch(page2pageType(page)){
     case VALUE:
-      if(page >= CO0TRS){regType = COTRS; regIndex = page - CO0TRS;}
+      if(page >= CO0FS){regType = COFS; regIndex = page - CO0FS;}
+      else if(page >= CO0SP){regType = COSP; regIndex = page - CO0SP;}
+      else if(page >= CO0TF){regType = COTF; regIndex = page - CO0TF;}
+      else if(page >= CO0TN){regType = COTN; regIndex = page - CO0TN;}
+      else if(page >= CO0HY){regType = COHY; regIndex = page - CO0HY;}
+      else if(page >= CO0TRS){regType = COTRS; regIndex = page - CO0TRS;}
       else if(page >= CO0USF){regType = COUSF; regIndex = page - CO0USF;}
+      else if(page >= SWF0MV){regType = SWFMV; regIndex = page - SWF0MV;}
+      else if(page >= SWF0MI){regType = SWFMI; regIndex = page - SWF0MI;}
+      else if(page >= SWF0MB){regType = SWFMB; regIndex = page - SWF0MB;}
+      else if(page >= SWF0ML){regType = SWFML; regIndex = page - SWF0ML;}
+      else if(page >= SWF0OF){regType = SWFOF; regIndex = page - SWF0OF;}
+      else if(page >= SWF0FD){regType = SWFFD; regIndex = page - SWF0FD;}
+      else if(page >= SWF0FM){regType = SWFFM; regIndex = page - SWF0FM;}
       else if(page >= SWF0EI){regType = SWFEI; regIndex = page - SWF0EI;}
       else if(page >= SWF0EB){regType = SWFEB; regIndex = page - SWF0EB;}
       else if(page >= SWF0SI){regType = SWFSI; regIndex = page - SWF0SI;}
@@ -750,14 +1141,18 @@ void page2typeIndexes(ePage page, int &pageIndex, eDeviceSettingRegType &regType
       else if(page >= SL0LD){regType = SLLD; regIndex = page - SL0LD;}
       else if(page >= SL0SV){regType = SLSV; regIndex = page - SL0SV;}
       else if(page >= AOHSW){regType = AOSET; regIndex = page - AOHSW;}
+      else if(page >= CO0OT){regType = COOT; regIndex = page - CO0OT;}
+      else if(page >= CO0CR){regType = COCR; regIndex = page - CO0CR;}
+      else if(page >= CO0LM){regType = COLM; regIndex = page - CO0LM;}
       else if(page >= CO0POL){regType = COPOL; regIndex = page - CO0POL;}
       else if(page >= CO0SW){regType = COSW; regIndex = page - CO0SW;}
+      else if(page >= SWF0BO){regType = SWFBO; regIndex = page - SWF0BO;}
       else if(page >= SWF0SU){regType = SWFSU; regIndex = page - SWF0SU;}
       else if(page >= SWF0SW){regType = SWFSW; regIndex = page - SWF0SW;}
       else if(page >= HWFF0L){regType = HWFFL; regIndex = page - HWFF0L;}
       else {regType = CANSPEED; regIndex = 0;}
       return;
-    case LIST8:
+    case LIST8: case INFO:
       regType = DSRT_ERROR;
       regIndex = ERROR_GENERAL;
       return;
@@ -779,6 +1174,10 @@ Display::Display(Adafruit_ILI9341* tft, SettingsManager* setMan, int width, int
   : tft_(tft), setMan_(setMan), tftWidth(width), tftHeight(height), titleHeight(titleH){
     // make CAN voltage object
     objVcan_ = new BoxObject(tft_, boxOI_canVolgate, boxOC_textOnly, " 0.0");
+    objCaption_ = new BoxObject(tft_, boxOI_caption, boxOC_textOnly, "CANID:");
+    // make bus load objects
+    objBusLoad_ = new BoxObject(tft_, boxOI_busLoad, boxOC_textOnly, "");
+    objBusLoadDrop_ = new BoxObject(tft_, boxOI_busLoad, boxOC_textAlert, "");
     // make icon objects
     iconHF_ = new BoxObject(tft_, boxOI_iconHF, boxOC_iconDefault, "HF");
     iconHD_ = new BoxObject(tft_, boxOI_iconHD, boxOC_iconDefault, "HD");
@@ -799,7 +1198,17 @@ void Display::setCanMFtable(const canMaskFilterTable *pCanMaskFilterTable){
 }
 
 // clear screen
+void Display::setLineRenderer(TftLineRenderer* lineRenderer){
+  lineRenderer_ = lineRenderer;
+}
+
+void Display::finishLine(){
+  if(lineRenderer_ != nullptr) lineRenderer_->wait();
+}
+
 void Display::clearScreen(uint16_t color){
+  finishLine();
+  lineQueue_.clear();
   tft_->fillScreen(color);
   tft_->setRotation(0);
   tft_->setScrollMargins(8,0);
@@ -975,16 +1384,33 @@ void Display::homeCursor(){
 }
 
 // draw CAN Voltage in the status line
-void Display::drawCANvoltage(String strVcan){
+void Display::drawCANvoltage(const char* strVcan){
   if(pageType_ == MONITOR){
+    finishLine();
     setTextColor(statusColor_);           // set text color
     objVcan_->changeText(strVcan);
     tft_->setCursor(0, A_ROWSIZE * pcln); // set back GRAM row address
   }
 }
 
+// draw bus load and frames/s in the status line
+// fDrop: 取りこぼしがあれば赤で表示する
+void Display::drawBusLoad(const char* strLoad, bool fDrop){
+  if(pageType_ == MONITOR){
+    finishLine();
+    if(fDrop != fBusLoadDrop_){
+      (fBusLoadDrop_ ? objBusLoadDrop_ : objBusLoad_)->changeText("");  // 前の色の表示を消す
+      fBusLoadDrop_ = fDrop;
+    }
+    (fBusLoadDrop_ ? objBusLoadDrop_ : objBusLoad_)->changeText(strLoad);
+    tft_->setTextColor(color_);           // objの色からモニター表示の色に戻す
+    tft_->setCursor(0, A_ROWSIZE * pcln); // set back GRAM row address
+  }
+}
+
 // Write new Status line
 void Display::writeStatusLine(uint16_t color = STATUSLINE_TEXTCOLOR){
+  finishLine();
   statusColor_ = color;
   // erace previous text
   tft_->fillRect(0, 0, ILI9341_TFTWIDTH, A_ROWSIZE, STATUSLINE_BACKGROUNDCOLOR);
@@ -992,8 +1418,10 @@ void Display::writeStatusLine(uint16_t color = STATUSLINE_TEXTCOLOR){
   homeCursor();                 // cursor go home and fontsize = 1
   setTextColor(statusColor_);   // set text color
   tft_->println(StatusLine);    // draw status line text
+  objCaption_->draw(FLAG_DRAW); // draw caption
   drawStatusIconAll();          // draw status icons
   objVcan_->draw(FLAG_DRAW);    // draw CAN voltage
+  (fBusLoadDrop_ ? objBusLoadDrop_ : objBusLoad_)->draw(FLAG_DRAW);  // draw bus load
   // set cursor position
   cln = pcln = 1;
   tft_->setCursor(0, A_ROWSIZE * pcln); // set back GRAM row address
@@ -1022,6 +1450,7 @@ void Display::setStatusIconSw(eStatuLineIcon iconType, bool offOn){
 void Display::drawStatusIcon(eStatuLineIcon iconType, bool offOn){
   // 表示フラグが変更されたときだけ描画
   if(statuIconSw_[iconType] != offOn){
+    finishLine();
     BoxObject* obj = iconType2obj(iconType);
     obj->draw(!offOn);
     statuIconSw_[iconType] = offOn;   // write back the flag
@@ -1048,6 +1477,36 @@ void Display::resetMonitorScrollType(){
   monitorScrollType_.fMonitorScrollSw_ = true;
   monitorScrollType_.fMonitorDispSw_.bit.hwfDisp = true;
   monitorScrollType_.fMonitorDispSw_.bit.swfDisp = true;
+  if(monitorScrollType_.fMonitorDeltaSw_ || monitorScrollType_.fMonitorTraceSw_){
+    monitorScrollType_.fMonitorDeltaSw_ = false;
+    monitorScrollType_.fMonitorTraceSw_ = false;
+    drawCaption();
+  }
+}
+
+void Display::drawCaption(){
+  finishLine();
+  if(monitorScrollType_.fMonitorTraceSw_) objCaption_->changeText("TRACE:");
+  else if(monitorScrollType_.fMonitorDeltaSw_) objCaption_->changeText("DELTA:");
+  else objCaption_->changeText("CANID:");
+  tft_->setTextColor(color_);           // objの色からモニター表示の色に戻す
+  tft_->setCursor(0, A_ROWSIZE * pcln); // set back GRAM row address
+}
+
+void Display::clearMonitorArea(){
+  finishLine();
+  lineQueue_.clear();
+  tft_->scrollTo(0);
+  tft_->fillRect(0, A_ROWSIZE, ILI9341_TFTWIDTH, ILI9341_TFTHEIGHT - A_ROWSIZE, BACKGROUNDCOLOR);
+  cln = pcln = 1;
+  tft_->setTextColor(color_);
+  tft_->setCursor(0, A_ROWSIZE * pcln); // set back GRAM row address
+}
+
+bool Display::getTraceStartRequest(){
+  bool req = fTraceStartReq_;
+  fTraceStartReq_ = false;
+  return req;
 }
 // get monitor scroll type
 monitorScrollType Display::getMonitorScrollType(){
@@ -1055,7 +1514,8 @@ monitorScrollType Display::getMonitorScrollType(){
 }
 
 // Show 1 line with scrolling
-void Display::write1Line(String* s, uint16_t color){
+// hlChars: bit nが1の文字をMONITOR_HLCOLORで表示する (先頭64文字まで)
+void Display::write1Line(const char* s, uint16_t len, uint16_t color, uint64_t hlChars){
   // set text color
   setTextColor(color);
   // clear first line and scroll if written area is over
@@ -1066,26 +1526,82 @@ void Display::write1Line(String* s, uint16_t color){
       tft_->setCursor(0, A_ROWSIZE * SCROLLMARGINLN); // set GRAM row address
       pcln = SCROLLMARGINLN;
     }
-    // erace previous text
-    tft_->fillRect(0, pcln * A_ROWSIZE, ILI9341_TFTWIDTH, A_ROWSIZE, ILI9341_BLACK);    // 6.5ms on SAMD21
+    // erace previous text (line rendererは行全体を背景ごと書くので消さない)
+    if(lineRenderer_ == nullptr){
+      tft_->fillRect(0, pcln * A_ROWSIZE, ILI9341_TFTWIDTH, A_ROWSIZE, ILI9341_BLACK);    // 6.5ms on SAMD21
+    }
+    else finishLine();
     // scrolling in advance
     tft_->scrollTo((pcln + 1) * A_ROWSIZE);
   }
+  if(lineRenderer_ != nullptr){
+    // 40文字毎に1行ずつline bufferに展開してDMAで送る (CPUの描画は1行0.2ms程度)
+    int row = pcln;
+    for(uint16_t pos = 0; pos < len && row < CURSORROWNUM; pos += CURSORCOLNUM, row++){
+      uint8_t n = (len - pos > CURSORCOLNUM) ? CURSORCOLNUM : len - pos;
+      lineRenderer_->drawRow(row * A_ROWSIZE, s + pos, n, color, BACKGROUNDCOLOR,
+                             (pos < 64) ? (hlChars >> pos) : 0, MONITOR_HLCOLOR);
+    }
+    int clninc = (len + CURSORCOLNUM - 1) / CURSORCOLNUM;
+    cln += clninc;
+    pcln += clninc;
+    return;
+  }
   // print with linefeed for moving GRAM row address
-  tft_->println(*s);     // 3-10ms on SAMD21
+  int row0 = pcln;
+  tft_->write((const uint8_t*)s, len);
+  tft_->println();       // 3-10ms on SAMD21
   // calc cursor inclement for multiple lines
-  int clninc = (s->length() + CURSORCOLNUM - 1) / CURSORCOLNUM;
+  int clninc = (len + CURSORCOLNUM - 1) / CURSORCOLNUM;
   cln += clninc;
   pcln += clninc;
+  // 強調する文字を上書きする。同じglyphなので背景透過のまま色だけ変わる
+  if(hlChars != 0){
+    tft_->setTextColor(MONITOR_HLCOLOR);
+    for(unsigned int i = 0; i < len && i < 64; i++){
+      if(((hlChars >> i) & 1) == 0) continue;
+      int row = row0 + i / CURSORCOLNUM;
+      if(row >= CURSORROWNUM) break;
+      tft_->setCursor((i % CURSORCOLNUM) * TEXTSIZEX * TEXTMAGNITUDE, row * A_ROWSIZE);
+      tft_->print(s[i]);
+    }
+    tft_->setTextColor(color_);
+    tft_->setCursor(0, A_ROWSIZE * pcln); // set back GRAM row address
+  }
 }
 
 // post Line if mode is run mode
 // モニタモード且つCAN受信した時に呼ばれる
-void Display::postLine(String& s, uint16_t color){
+// ここでは描かずにqueueに積むだけ。描画はloop()がrenderLine()で1行ずつ行う
+bool Display::postLine(const char* s, uint16_t len, uint16_t color, uint64_t hlChars){
   // fMonitorScrollSw_がTrueの時はスクロール表示、falseの時は表示停止
   if(monitorScrollType_.fMonitorScrollSw_){
-    write1Line(&s, color);           // display CAN data screenの1ライン表示処理
+    lineQueue_.push(s, len, color, hlChars);
+    return true;
   }
+  return false;
+}
+
+// 1回の呼出しで描くのは1行まで。line rendererが前の行を転送中なら待たずに戻る
+bool Display::renderLine(){
+  if(lineRenderer_ != nullptr && lineRenderer_->isBusy()) return false;
+  const queuedLine* l = lineQueue_.peek();
+  if(l == nullptr) return false;
+  write1Line(l->text, l->len, l->color, l->hlChars);
+  lineQueue_.pop();
+  return true;
+}
+
+uint32_t Display::getLineDropCount(){
+  return lineQueue_.getDropCount();
+}
+
+uint8_t Display::getLineQueueHighWater(){
+  return lineQueue_.getHighWater();
+}
+
+void Display::resetLineQueueCounters(){
+  lineQueue_.resetCounters();
 }
 
 // check if both previous mode and current mode are monitor mode
@@ -1095,6 +1611,44 @@ bool Display::isMonitorMode(){
   else return false;
 }
 
+// check if both previous mode and current mode are info mode
+bool Display::isInfoMode(){
+  if(pageType_ == INFO && currentPage_ == newPage_) return true;
+  else return false;
+}
+
+// get the current page
+ePage Display::getCurrentPage(){
+  return currentPage_;
+}
+
+// Info pageの1行を書き換える
+void Display::setInfoLine(int line, const char* s){
+  BoxObject *obj;
+  if(pageType_ != INFO || line >= repeatCount_) return;
+  if(checkObject_Box(line, obj)) obj->changeText(s);  // 型確認＆text変更
+  else DEBUG_PRINTLN("Error: setInfoLine object type"); // 型エラー
+}
+
+// Info pageのリセット要求を取得してクリア
+bool Display::getInfoResetRequest(){
+  bool req = fInfoResetReq_;
+  fInfoResetReq_ = false;
+  return req;
+}
+
+int Display::getInfoStepRequest(){
+  int req = infoStepReq_;
+  infoStepReq_ = 0;
+  return req;
+}
+
+bool Display::getInfoModeRequest(){
+  bool req = fInfoModeReq_;
+  fInfoModeReq_ = false;
+  return req;
+}
+
 // check if the display page is changed
 bool Display::isPageChanged(){
   if(currentPage_ != newPage_) return true;
@@ -1111,6 +1665,7 @@ bool Display::isPageBackToMonitorMode(){
 
 // change page
 void Display::changePage(){
+  finishLine();
   // erase previous page
   DEBUG2_PRINTLN("CP0_erase previous page");
   switch(pageType_){
@@ -1143,6 +1698,8 @@ void Display::calcRepeatCountOfDigit(){
     case COTRS: // CO threshould value
       // set value byte length and bit length
       extractLen(setMan_, setMan_->getSettingValue(COUSF, regIndex_), &byteLen_, &bitLen_);
+      // 物理値と比較するSWFはint32の範囲で入力
+      if(isScaledSwf(setMan_, setMan_->getSettingValue(COUSF, regIndex_))) bitLen_ = 32;
       // 1桁16進表示のためbit長を4bitsで割って余りを繰り上げ
       repeatCount_ = (bitLen_ + 3) / 4; // repeatCount_: digit count
       break;
@@ -1173,7 +1730,15 @@ void Display::setLimitValue(){
 
   valueIsAny_ = getValueIsAny(pageIndex_);
   if(valueIsAny_){    // COTRS
-    valueIsSign_ = setMan_->getSettingValue(SWFSU, setMan_->getSettingValue(COUSF, regIndex_));
+    int swfIndex = setMan_->getSettingValue(COUSF, regIndex_);
+    if(isScaledSwf(setMan_, swfIndex)){  // 物理値はsigned int32
+      valueIsSign_ = true;
+      valueMax_ = INT32_MAX;
+      valueMin_ = (uint32_t)INT32_MIN;
+      DEBUG_PRINT("valueMax_,Min_=");DEBUG_PRINT(valueMax_);DEBUG_PRINT(", ");DEBUG_PRINTLN(valueMin_);
+      return;
+    }
+    valueIsSign_ = setMan_->getSettingValue(SWFSU, swfIndex);
     max = powInt(2, bitLen_) - 1;
     min = 0;
     if(valueIsSign_){
@@ -1186,10 +1751,12 @@ void Display::setLimitValue(){
   else if(regType_ == DS_HWF &&  // Filter番号におけるIDlengthがSTDのとき、数を制限
           setMan_->getSettingValue(HWFFL, pCanMaskFilterTable_[pageIndex_].num) == CANFLSTD){
     // standard case: limited digits
+    valueIsSign_ = false;
     valueMax_ = CANSTDIDNUMMAX;
     valueMin_ = 0;
   }
   else{
+    valueIsSign_ = getValueMin(pageIndex_) < 0;   // SWFOF
     valueMax_ = getValueMax(pageIndex_);
     valueMin_ = getValueMin(pageIndex_);
   }
@@ -1204,27 +1771,85 @@ uint32_t Display::getCurrentValue_fromSetman(){
 
 // set the different type value to setman
 void Display::setNewValue_toSetman(){
-  if(valueIsAny_) setMan_->setSettingValue((uint64_t)newValue_, regType_, pageIndex_, regIndex_);
+  if(valueIsAny_){   // signedは負の閾値をint64として比較できるよう符号拡張して保存
+    uint64_t val = valueIsSign_ ? (uint64_t)(int64_t)(int32_t)newValue_ : (uint64_t)newValue_;
+    setMan_->setSettingValue(val, regType_, pageIndex_, regIndex_);
+  }
   else setMan_->setSettingValue((int32_t)newValue_, regType_, pageIndex_, regIndex_);
 }
 
-// SWF0-7でStartByte/BitとStopByteBit位置がおかしいとエラー表示
+// SWFのStartByte/BitとStopByteBit位置がおかしいとエラー表示
 void Display::noticeByteBitPositionError(int swfIndex){
   uint8_t startByte = setMan_->getSettingValue(SWFSB, swfIndex);
   uint8_t startBit = setMan_->getSettingValue(SWFSI, swfIndex);
   uint8_t endByte = setMan_->getSettingValue(SWFEB, swfIndex);
   uint8_t endBit = setMan_->getSettingValue(SWFEI, swfIndex);
-  if (startByte > endByte){
-    DEBUG2_PRINTLN("SWF0-7 Stt>End ByteErr!");
+  bool intel = setMan_->getSettingValue(SWFBO, swfIndex) == SWFBO_INTEL;
+  if (!intel && startByte > endByte){
+    DEBUG2_PRINTLN("SWF Stt>End ByteErr!");
     showNotice(NOTICETIME3, boxOI_noticeSmall, boxOC_notice, "Stt>End ByteErr!"); // 画面にNotice表示
   }
+  else if (intel && startByte < endByte){
+    DEBUG2_PRINTLN("SWF Stt<End ByteErr!");
+    showNotice(NOTICETIME3, boxOI_noticeSmall, boxOC_notice, "Stt<End ByteErr!"); // 画面にNotice表示
+  }
   else if(startByte == endByte && startBit < endBit){
-    DEBUG2_PRINTLN("SWF0-7 Stt<End BitErr!");
+    DEBUG2_PRINTLN("SWF Stt<End BitErr!");
     showNotice(NOTICETIME3, boxOI_noticeSmall, boxOC_notice, "Stt<End BitErr!");  // 画面にNotice表示
   }
   else;   // no error
 }
 
+// SWF0-7系ページの設定レジスタ番号を表示中のbankのSWF番号にする
+void Display::applySwfBank(){
+  switch(regType_){
+    case SWFSW: case SWFSU: case SWFBO: case SWFID: case SWFSB: case SWFSI: case SWFEB: case SWFEI:
+    case SWFFM: case SWFFD: case SWFOF: case SWFML: case SWFMB: case SWFMI: case SWFMV:
+      regIndex_ += swfBank_ * SWFBANKSIZE;
+      break;
+    default:
+      break;
+  }
+}
+
+// SWF関連ページのタイトルを表示中のbankのSWF番号で作り直す
+void Display::makeSwfTitles(String &topTitle, String &subTitle){
+  char buf[INFOLINECHARS + 1];
+  int swfIndex;
+  if(newPage_ == SWF){                                // SWF list page
+    swfIndex = swfBank_ * SWFBANKSIZE;
+    snprintf(buf, sizeof(buf), "SWF%X-%X L/R:bank", swfIndex, swfIndex + SWFBANKSIZE - 1);
+    subTitle = buf;
+    return;
+  }
+  if(newPage_ >= SWF0 && newPage_ <= SWF7) swfIndex = swfBank_ * SWFBANKSIZE + (newPage_ - SWF0);
+  else if(newPage_ >= SWF0SC && newPage_ <= SWF7SC) swfIndex = swfBank_ * SWFBANKSIZE + (newPage_ - SWF0SC);
+  else if(newPage_ >= SWF0MX && newPage_ <= SWF7MX) swfIndex = swfBank_ * SWFBANKSIZE + (newPage_ - SWF0MX);
+  else{
+    switch(regType_){
+      case SWFSW: case SWFSU: case SWFBO: case SWFID: case SWFSB: case SWFSI: case SWFEB: case SWFEI:
+      case SWFFM: case SWFFD: case SWFOF: case SWFML: case SWFMB: case SWFMI: case SWFMV:
+        swfIndex = regIndex_;
+        break;
+      default:
+        return;                                       // SWF以外のページはそのまま
+    }
+  }
+  snprintf(buf, sizeof(buf), "SWF%X", swfIndex);
+  topTitle = buf;
+  if((newPage_ >= SWF0 && newPage_ <= SWF7) || regType_ == SWFSW){   // "SoftwareFilterN"のsub title
+    snprintf(buf, sizeof(buf), "SoftwareFilter%X", swfIndex);
+    subTitle = buf;
+  }
+}
+
+// SWF list pageの表示bankを変えて再描画
+void Display::changeSwfBank(int step){
+  swfBank_ = (swfBank_ + step + SWFBANKCOUNT) % SWFBANKCOUNT;
+  previousCursorPos_[currentPage_] = cursorPos_;   // keep cursor pos
+  drawPage();
+}
+
 // draw page
 void Display::drawPage(){
   int objectCount = 0, cnt = 0;
@@ -1235,6 +1860,8 @@ void Display::drawPage(){
   // set page type and index
   pageType_ = page2pageType(newPage_);                                // 画面ページタイプを更新
   page2typeIndexes(newPage_, pageIndex_, regType_, regIndex_);        // その他ページ情報を更新
+  applySwfBank();                                                     // SWF0-7ページは表示中のbankのSWF
+  String topTitle, subTitle;
   DEBUG2_PRINT("DP0_drawPage currentPage_,newPage_,PageType,pageIndex_,regType_,regIndex_= ");
   DEBUG2_PRINT(currentPage_);DEBUG2_PRINT(", ");DEBUG2_PRINT(newPage_);DEBUG2_PRINT(", ");
   DEBUG2_PRINT(pageType_);DEBUG2_PRINT(", ");DEBUG2_PRINT(pageIndex_);DEBUG2_PRINT(", ");
@@ -1250,8 +1877,12 @@ void Display::drawPage(){
       repeatCount_ = pageList8[pageIndex_].listCount;
       cursorPos_ = previousCursorPos_[newPage_];  // load cursor position
       if(cursorPos_ >= repeatCount_) cursorPos_ = 0;  // cursorPos_ limitation
-      page->addObject(POAT_FIXED, new TextObject(tft_, textOI_topTitle, pageList8[pageIndex_].topTitle));
-      page->addObject(POAT_FIXED, new TextObject(tft_, textOI_subTitle, pageList8[pageIndex_].subTitle));
+      topTitle = pageList8[pageIndex_].topTitle;
+      subTitle = pageList8[pageIndex_].subTitle;
+      makeSwfTitles(topTitle, subTitle);
+      page->addObject(POAT_FIXED, new TextObject(tft_, textOI_topTitle, topTitle));
+      page->addObject(POAT_FIXED, new TextObject(tft_, textOI_subTitle, subTitle));
+      if(newPage_ == SWF) page->addObject(POAT_FIXED, new BoxObject(tft_, boxOI_swfBank, boxOC_default, "NEXT"));
       for(int i = 0; i < objectCount; i++){
         switch(pageObjList_list8[i]){
           case BUTTON_BACK:
@@ -1259,8 +1890,9 @@ void Display::drawPage(){
             break;
           case LIST_1LINE:
             if(cnt < repeatCount_){
-              page->addObject(POAT_FIXED, new ListObject(tft_, boxOI_list8[cnt], boxOC_default, 
-                              pageList8[pageIndex_].listLabels[cnt]));
+              String label = pageList8[pageIndex_].listLabels[cnt];
+              if(newPage_ == SWF) label = "SoftwareFilter" + String(swfBank_ * SWFBANKSIZE + cnt, HEX);
+              page->addObject(POAT_FIXED, new ListObject(tft_, boxOI_list8[cnt], boxOC_default, label));
               cnt++;
             }
             break;
@@ -1271,15 +1903,20 @@ void Display::drawPage(){
       }
       page->draw();
       // SWF0-7でStartByte/BitとStopByteBit位置がおかしいとエラー表示
-      if(newPage_ >= SWF0 && newPage_ <= SWF7) noticeByteBitPositionError((int)(newPage_ - SWF0));
+      if(newPage_ >= SWF0 && newPage_ <= SWF7){
+        noticeByteBitPositionError(swfBank_ * SWFBANKSIZE + (int)(newPage_ - SWF0));
+      }
       break;
     case BUTTON8:
       objectCount = sizeof(pageObjList_buttonBox8) / sizeof(pageObjList_buttonBox8[0]);
       repeatCount_ = pageButton8[pageIndex_].buttonCount;
       cursorPos_ = previousCursorPos_[newPage_];  // cursorPos_ starts prev pos
       if(cursorPos_ >= repeatCount_) cursorPos_ = 0;  // cursorPos_ limitation
-      page->addObject(POAT_FIXED, new TextObject(tft_, textOI_topTitle, pageButton8[pageIndex_].topTitle));
-      page->addObject(POAT_FIXED, new TextObject(tft_, textOI_subTitle, pageButton8[pageIndex_].subTitle));
+      topTitle = pageButton8[pageIndex_].topTitle;
+      subTitle = pageButton8[pageIndex_].subTitle;
+      makeSwfTitles(topTitle, subTitle);
+      page->addObject(POAT_FIXED, new TextObject(tft_, textOI_topTitle, topTitle));
+      page->addObject(POAT_FIXED, new TextObject(tft_, textOI_subTitle, subTitle));
       for(int i = 0; i < objectCount; i++){
         switch(pageObjList_buttonBox8[i]){
           case BUTTON_BACK:
@@ -1305,8 +1942,11 @@ void Display::drawPage(){
       calcRepeatCountOfDigit();       // calc repeatCount_
       setLimitValue();                // set limiting values to private regs
       cursorPos_ = 0;
-      page->addObject(POAT_FIXED, new TextObject(tft_, textOI_topTitle, pageValue[pageIndex_].topTitle));
-      page->addObject(POAT_FIXED, new TextObject(tft_, textOI_subTitle, pageValue[pageIndex_].subTitle));
+      topTitle = pageValue[pageIndex_].topTitle;
+      subTitle = pageValue[pageIndex_].subTitle;
+      makeSwfTitles(topTitle, subTitle);
+      page->addObject(POAT_FIXED, new TextObject(tft_, textOI_topTitle, topTitle));
+      page->addObject(POAT_FIXED, new TextObject(tft_, textOI_subTitle, subTitle));
       for(int i = 0; i < objectCount; i++){
         switch(pageObjList_value[i]){
           case BUTTON_BACK:
@@ -1341,6 +1981,19 @@ void Display::drawPage(){
       num2hexToScreenValObj(currentValue_);                         // valueをrepeatCount桁分表示更新
       newValue_ = currentValue_;                                    // 更新値を現在値で初期化
       break;
+    case INFO:
+      repeatCount_ = pageInfo[pageIndex_].lineCount;
+      fInfoResetReq_ = false;
+      infoStepReq_ = 0;
+      fInfoModeReq_ = false;
+      page->addObject(POAT_FIXED, new TextObject(tft_, textOI_topTitle, pageInfo[pageIndex_].topTitle));
+      page->addObject(POAT_FIXED, new TextObject(tft_, textOI_subTitle, pageInfo[pageIndex_].subTitle));
+      page->addObject(POAT_FIXED, new BoxObject(tft_, boxOI_back, boxOC_default, "BACK"));
+      for(cnt = 0; cnt < repeatCount_; cnt++){
+        page->addObject(POAT_MUTABLE, new BoxObject(tft_, boxOI_list8[cnt], boxOC_info, ""));
+      }
+      page->draw();
+      break;
     default:
       DEBUG_PRINTLN("DP1 case:ERROR");
       break;
@@ -1450,7 +2103,7 @@ void Display::incrementValue(){
   // check if cursor pos is on a value box
   if(cursorPos_ >= repeatCount_ || cursorPos_ < 0) return;
   // Increment value
-  if(valueIsAny_ && valueIsSign_){    // handle if value has sign for COTRS
+  if(valueIsSign_){    // handle if value has sign for COTRS, SWFOF
     int64_t val = (int32_t)newValue_;
     val += powInt(16, cursorPos_);
     // check range and limitation
@@ -1474,7 +2127,7 @@ void Display::decrementValue(){
   // check if cursor pos is on a value box
   if(cursorPos_ >= repeatCount_ || cursorPos_ < 0) return;
   // Decrement value
-  if(valueIsAny_ && valueIsSign_){    // handle if value has sign for COTRS 
+  if(valueIsSign_){    // handle if value has sign for COTRS, SWFOF
     int64_t val = (int32_t)newValue_;
     val -= powInt(16, cursorPos_);
     // check range and limitation
@@ -1519,6 +2172,9 @@ bool Display::touched(int tx, int ty){
       newPage_ = pageList8[pageIndex_].previous;
       previousCursorPos_[currentPage_] = 0;   // clear current cursor pos
     }
+    else if(currentPage_ == SWF && checkTouchedBox(tx, ty, boxOI_swfBank.boxPos)){  // SWF bank NEXT button
+      changeSwfBank(1);
+    }
     else{   // check if a List box is touched
       fassigned = false;
       for(cnt = 0; cnt < repeatCount_; cnt++){
@@ -1556,8 +2212,10 @@ bool Display::touched(int tx, int ty){
         previousCursorPos_[currentPage_] = 0;   // clear current cursor pos
       }
       else if(regType_ == SLLD && cnt == SAVELOAD_YESPOS){
-        setMan_->loadDeviceSettings(regIndex_);       // ロード
-        showNotice(NOTICETIME1, boxOI_notice, boxOC_notice, "Loaded!");    // 画面にNotice表示
+        if(setMan_->loadDeviceSettings(regIndex_)){   // ロード
+          showNotice(NOTICETIME1, boxOI_notice, boxOC_notice, "Loaded!");    // 画面にNotice表示
+        }
+        else showNotice(NOTICETIME1, boxOI_notice, boxOC_notice, "Defaults!");  // slotが空/古い形式
         newPage_ = pageButton8[pageIndex_].previous;  // 前のページに戻る
         previousCursorPos_[currentPage_] = 0;   // clear current cursor pos
       }
@@ -1591,6 +2249,12 @@ bool Display::touched(int tx, int ty){
       }
     }
     break;
+  case INFO:
+    if(checkTouchedBack(tx, ty)){               // BACK button
+      newPage_ = pageInfo[pageIndex_].previous;
+    }
+    else fassigned = false;
+    break;
   default:
     DEBUG_PRINTLN("DT1 case:ERROR");
     fassigned = false;
@@ -1622,6 +2286,18 @@ bool Display::keyControl(uint16_t pushedSw){
       drawStatusIcon(SLI_HD, monitorScrollType_.fMonitorDispSw_.bit.hwfDisp);
       drawStatusIcon(SLI_SD, monitorScrollType_.fMonitorDispSw_.bit.swfDisp);
     }
+    else if(pushedSw & BITPOS_SWD){
+      // change-only (delta) display on/off
+      monitorScrollType_.fMonitorDeltaSw_ = !monitorScrollType_.fMonitorDeltaSw_;
+      drawCaption();
+    }
+    else if(pushedSw & (BITPOS_SWL | BITPOS_SWR)){
+      // scroll <-> trace
+      monitorScrollType_.fMonitorTraceSw_ = !monitorScrollType_.fMonitorTraceSw_;
+      fTraceStartReq_ = monitorScrollType_.fMonitorTraceSw_;
+      clearMonitorArea();
+      drawCaption();
+    }
     else fassigned = false;
     break;
   case LIST8:
@@ -1641,6 +2317,12 @@ bool Display::keyControl(uint16_t pushedSw){
       if(++cursorPos_ >= repeatCount_) cursorPos_ = 0;
       moveCursorPosition(cursorPos_);
     }
+    else if(currentPage_ == SWF && (pushedSw & BITPOS_SWL)){ // 前のSWF bank
+      changeSwfBank(-1);
+    }
+    else if(currentPage_ == SWF && (pushedSw & BITPOS_SWR)){ // 次のSWF bank
+      changeSwfBank(1);
+    }
     else fassigned = false;
     break;
   case BUTTON8:
@@ -1658,8 +2340,10 @@ bool Display::keyControl(uint16_t pushedSw){
         previousCursorPos_[currentPage_] = 0;   // clear current cursor pos
       }
       else if(regType_ == SLLD && cursorPos_ == SAVELOAD_YESPOS){
-        setMan_->loadDeviceSettings(regIndex_);       // ロード
-        showNotice(NOTICETIME1, boxOI_notice, boxOC_notice, "Loaded!");    // 画面にNotice表示
+        if(setMan_->loadDeviceSettings(regIndex_)){   // ロード
+          showNotice(NOTICETIME1, boxOI_notice, boxOC_notice, "Loaded!");    // 画面にNotice表示
+        }
+        else showNotice(NOTICETIME1, boxOI_notice, boxOC_notice, "Defaults!");  // slotが空/古い形式
         newPage_ = pageButton8[pageIndex_].previous;  // 前のページに戻る
         previousCursorPos_[currentPage_] = 0;   // clear current cursor pos
       }
@@ -1700,6 +2384,24 @@ bool Display::keyControl(uint16_t pushedSw){
     }
     else fassigned = false;
     break;
+  case INFO:
+    if(pushedSw & bitposSwC_){                     // 前のページに戻る
+      newPage_ = pageInfo[pageIndex_].previous;
+    }
+    else if(pushedSw & bitposSwE_){                // 表示内容のリセット要求
+      fInfoResetReq_ = true;
+    }
+    else if(pushedSw & BITPOS_SWU){                // 前の表示対象
+      infoStepReq_ = -1;
+    }
+    else if(pushedSw & BITPOS_SWD){                // 次の表示対象
+      infoStepReq_ = 1;
+    }
+    else if(pushedSw & (BITPOS_SWL | BITPOS_SWR)){ // 表示方法の切替
+      fInfoModeReq_ = true;
+    }
+    else fassigned = false;
+    break;
   default:
     DEBUG_PRINTLN("KC1 case:ERROR");
     fassigned = false;
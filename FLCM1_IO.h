@@ -30,6 +30,10 @@
 #include "debug.h"            // for debug out level setting
 #include "mcp_can.h"
 #include "screen.h"
+#include "FL_tftline.h"
+#include "FL_linequeue.h"       // DMA line renderer
+#include "FL_swfplan.h"         // SoftwareFilter, extraction plan
+#include "FL_comparator.h"      // comparator plan, COLM_xxx
 
 
 // エラーレベル
@@ -96,6 +100,10 @@
 #define CANFLSTD        0       // Filter Length (Standard 11bits)
 #define CANFLEXT        1       // Filter Length (Extended 29bits)
 
+#define SWFCOUNT        64      // software filter count, must be multiple of SWFBANKSIZE
+#define SWFBANKSIZE     8       // SWF0-7ページに一度に表示するSWF数
+#define SWFBANKCOUNT    (SWFCOUNT / SWFBANKSIZE)
+
 // ***** SW definitions
 #define BITPOS_SWC     (1 << 0)
 #define BITPOS_SWE     (1 << 1)
@@ -128,7 +136,8 @@
 #define STATUSLINE_BACKGROUNDCOLOR  ILI9341_BLUE
 #define STATUSLINE_LINECOLOR        ILI9341_CYAN
 #define STATUSLINE_TEXTCOLOR        ILI9341_YELLOW
-#define SWFMENUCOUNT    MUTABLEOBJMAX
+#define MONITOR_HLCOLOR             ILI9341_CYAN    // 変化表示モードで変化したbyteの色
+#define SWFMENUCOUNT    SWFCOUNT
 #define COMENUCOUNT     4
 #define AUXMENUCOUNT    3
 #define OPMENUCOUNT     1
@@ -143,6 +152,7 @@
 #define SIGNED64BITMAX  0x7fffffffffffffff
 #define NOTICETIME1     1000  // in ms
 #define NOTICETIME3     3000  // in ms
+#define INFOLINECHARS   19    // Info page 1 line chars (textsize 2)
 
 // ***** TOUCH definitions
 #define TOUCH_X_MAX     3700
@@ -161,24 +171,30 @@ int powInt(int base, int exponent);
 const uint32_t CANspeedMap[] = {
   CAN_10KBPS, CAN_50KBPS, CAN_100KBPS, CAN_125KBPS, CAN_250KBPS, CAN_500KBPS, CAN_800KBPS, CAN_1000KBPS
   };
+// CANspeedMapと対応するbitrate [bit/s] (bus load計算用)
+const uint32_t CANbitrateMap[] = {
+  10000, 50000, 100000, 125000, 250000, 500000, 800000, 1000000
+  };
 
 // CAN Software filtered value set
 struct canSoftwareFilteredValueSet{
-  int64_t value[MUTABLEOBJMAX];
-  uint8_t len[MUTABLEOBJMAX];
-  union{  // 0:false 1:true:filtered
-    uint8_t byte;
-    struct{
-      unsigned b0 : 1;
-      unsigned b1 : 1;
-      unsigned b2 : 1;
-      unsigned b3 : 1;
-      unsigned b4 : 1;
-      unsigned b5 : 1;
-      unsigned b6 : 1;
-      unsigned b7 : 1;
-    } bit;
-  } fIsFiltered;
+  int64_t value[SWFCOUNT];  // scalingありのSWFは物理値
+  uint8_t len[SWFCOUNT];
+  swfMask_t fIsFiltered;  // 0:false 1:true:filtered
+  swfMask_t fIsScaled;    // 1:valueは物理値 (10進表示)
+};
+
+// CAN ID -> plan dispatch index. planはID順に並べ、同じIDのplanは連続させる
+// index値 0:該当filterなし n:plan[n-1]から同じIDのplanが続く
+// 11bit IDも29bit IDも同じopen addressing hashで引く (11bit IDの直接表2KBはSRAMに対して大きすぎる)
+// SIZE = 2 * SWFCOUNTなので使用率は50%以下、探索は空きslotで止まる
+#define SWFIDHASHSIZE   (2 * SWFCOUNT)          // must be power of 2
+#define SWFIDHASHMASK   (SWFIDHASHSIZE - 1)
+struct canSoftwareFilterPlanSet{
+  canSoftwareFilterPlan plan[SWFCOUNT];       // 有効なSWFだけをID順に詰めて格納
+  uint8_t count;                              // 有効なSWF数
+  uint8_t hashIndex[SWFIDHASHSIZE];           // 0:empty n:plan[n-1] (idと分けてpaddingを無くす)
+  uint32_t hashId[SWFIDHASHSIZE];
 };
 
 // CAN Mask and Filter setting screen table
@@ -198,15 +214,15 @@ enum eDeviceSettingRegType{ //ePageのbutton以降の各行(画面ごと)を記
   // Button8 type
   CANSPEED,
   HWFFL,
-  SWFSW, SWFSU,
-  COSW, COPOL,
+  SWFSW, SWFSU, SWFBO,
+  COSW, COPOL, COLM, COCR, COOT,
   AOSET,
   SLSV, SLLD,
   DS_OPSM,
   // Value type
   DS_HWF,
-  SWFID, SWFSB, SWFSI, SWFEB, SWFEI,
-  COUSF, COTRS,
+  SWFID, SWFSB, SWFSI, SWFEB, SWFEI, SWFFM, SWFFD, SWFOF, SWFML, SWFMB, SWFMI, SWFMV,
+  COUSF, COTRS, COHY, COTN, COTF, COSP, COFS,
   DSRTMAX
 };
 
@@ -215,22 +231,28 @@ enum eSaveLoadPos {
   SLP_SL0, SLP_SL1, SLP_SL2, SLP_SL3, SLP_SL4, SLP_SL5, SLP_SL6, SLP_SL7, SLP_TEMP, SLP_MAX
 };
 
-// 設定データ格納構造体
-struct SoftwareFilter {
-  int32_t canID;
-  int8_t startByte;
-  int8_t startBit;
-  int8_t endByte;
-  int8_t endBit;
-  bool onoff;
-  bool sign;
-};
+// CO output mode (COLM) はFL_comparator.h
+// CO output type (COOT)
+#define COOT_DIGITAL    0       // 比較結果をPORTに出力
+#define COOT_PWM        1       // (value - COTRS) / COSP をTCCのdutyで出力
+#define COOT_FREQ       2       // (value - COTRS) / COSP * COFS [Hz] をTCCの周波数で出力 (1本だけ)
+#define COOTCOUNT       3
+#define CORULESIZE      64      // CO複合条件のテキスト (NUL終端含む)
 
+// 設定データ格納構造体 (SoftwareFilterはFL_swfplan.h)
 struct ComparatorOutput {
   uint64_t threshould;
   int8_t usingSwf;
   bool onoff;
   bool pol;
+  uint8_t latchMode;      // COLM_xxx
+  uint32_t hysteresis;    // threshould - hysteresis を下回るまで条件成立を保持
+  uint16_t onDelay;       // [ms] 条件がこの時間続いたら成立
+  uint16_t offDelay;      // [ms] 条件の不成立がこの時間続いたら不成立
+  bool critical;          // 1:CAN受信割込の中で判定して出力 (coRuleは使わない)
+  uint8_t outType;        // COOT_xxx
+  uint32_t span;          // COOT_PWM/FREQ: threshouldからこの幅で0-100%
+  uint16_t fullFreq;      // COOT_FREQ: 100%の周波数 [Hz]
 };
 
 struct DeviceSettings {
@@ -239,35 +261,75 @@ struct DeviceSettings {
   int16_t hwf[HWFMENUCOUNT];
   SoftwareFilter swf[SWFMENUCOUNT];
   ComparatorOutput co[COMENUCOUNT];
+  char coRule[COMENUCOUNT][CORULESIZE];  // 空でなければusingSwf/threshouldの代わりに使う (Serialで設定)
   bool ao[AUXMENUCOUNT];
   bool op[OPMENUCOUNT];
 };
+#define CANSPEEDDEFAULT 5       // CANspeedMap index 500kbps
+
+// Flashの保存形式: DeviceSettingsの後ろにlayout versionとCRCを付ける
+// DeviceSettings (SoftwareFilter, ComparatorOutputを含む) の並びや大きさを変えたらDSLAYOUTVERSIONを上げること
+// 消去済み/古い形式/壊れたslotはloadDeviceSettings()でdefault値にする
+#define DSLAYOUTVERSION 1
+struct DeviceSettingsSlot {
+  DeviceSettings settings;
+  uint16_t layout;        // DSLAYOUTVERSION
+  uint16_t size;          // sizeof(DeviceSettings)
+  uint32_t crc;           // settings, layout, size のCRC-32
+};
+
+// CAN関連設定の差分 diffCanSettings()の戻り値
+#define CANDIFF_HWF(i)  (1 << (i))                    // DS_HWF[i]のMask/Filterを書き直す
+#define CANDIFF_HWFALL  ((1 << HWFMENUCOUNT) - 1)
+#define CANDIFF_SPEED   (1 << HWFMENUCOUNT)           // CAN speed変更 (MCPのreset要)
 
 // 設定記憶域操作クラスの定義
 class SettingsManager{
 private:
-  DeviceSettings currentDeviceSetting_;  // 現在設定値（RAM内）
+  DeviceSettingsSlot slot_;              // flashと同じ形式で持ち、save/load時に別のcopyを作らない
+  DeviceSettings &currentDeviceSetting_ = slot_.settings;  // 現在設定値（RAM内）
+  // MCPに書込済みのCAN設定 (diffCanSettings()で使う分だけ)
+  int8_t appliedCanSpeed_;
+  bool appliedHwffl_[HWFFLMENUCOUNT];
+  int16_t appliedHwf_[HWFMENUCOUNT];
+  bool fCanApplied_ = false;             // appliedXxx_が有効
+  uint32_t tempCrc_;                     // flashのtemp領域のCRC
+  bool fTempValid_ = false;              // tempCrc_が有効
+  uint32_t calcSlotCrc();                // slot_のlayout/sizeを埋めてCRCを計算
 public:
   SettingsManager();
 
   // 設定値の呼び出し
   int32_t getSettingValue(eDeviceSettingRegType regType, int regIndex);
   uint64_t getSettingAnyvalue(eDeviceSettingRegType regType, int regIndex); // for COTRS
+  const SoftwareFilter& getSoftwareFilter(int swfIndex);  // SWF planの作成用
   // 設定値の範囲内チェック
   bool isValidSetting(int32_t value, eDeviceSettingRegType regType, int pageIndex);
   // 設定値の書き込み
   void setSettingValue(int32_t value, eDeviceSettingRegType regType, int pageIndex, int regIndex);
   void setSettingValue(uint64_t value, eDeviceSettingRegType regType, int pageIndex, int regIndex);// for COTRS
+  // CO複合条件のテキスト
+  void getCoRule(int coNum, char* buf, size_t size);   // NUL終端してbufにコピー
+  void setCoRule(int coNum, const char* rule);
   // 現在設定値をFlash領域にsave
   void saveDeviceSettings(int pos);
-  // 現在設定値をFlash領域からload
-  void loadDeviceSettings(int pos);
+  // 現在設定値をFlash領域からload (false: slotが無効でdefault値にした)
+  bool loadDeviceSettings(int pos);
+  // 現在設定値をdefault値にする
+  void setDefaultDeviceSettings();
+  // 現在設定値がflashのtemp領域と同じか
+  bool isTempSaved();
+  // MCPに書込済みのCAN設定との差分 CANDIFF_xxx
+  uint16_t diffCanSettings();
+  void markCanSettingsApplied();
 
 };
 
 // bit列抽出用設定のLengthをあらかじめ計算
-// startBit of startByte must be left or same pos from endbit of endByte
+// Start(MSB)はEnd(LSB)より上位のbit位置であること
 void extractLen(SettingsManager *setMan, uint8_t swfIndex, uint8_t *byteLen, uint8_t *bitLen);
+// SWFのfactor/offsetが物理値変換をするか
+bool isScaledSwf(SettingsManager *setMan, uint8_t swfIndex);
 
 
 // **************************************************************************************************************
@@ -298,18 +360,26 @@ enum ePage {
   // Monitor type:0 START:1 STOP:2
   PAGEERROR = -1, MONITOR_TYPE, INMONITOR,
   // List8 type
-  LIST_TYPE, MENU_TOP, HWF, SWF, CO, AO, SL, OP,                  // Main menu
+  LIST_TYPE, MENU_TOP, HWF, SWF, CO, AO, SL, OP, DG,              // Main menu
   HWFF0, HWFF1, HWFF2, HWFF3, HWFF4, HWFF5,                       // HardWareFilter Filter
   SWF0, SWF1, SWF2, SWF3, SWF4, SWF5, SWF6, SWF7,                 // SoftWareFilter
+  SWF0SC, SWF1SC, SWF2SC, SWF3SC, SWF4SC, SWF5SC, SWF6SC, SWF7SC, // SWF value format
+  SWF0MX, SWF1MX, SWF2MX, SWF3MX, SWF4MX, SWF5MX, SWF6MX, SWF7MX, // SWF multiplexor
   CO0, CO1, CO2, CO3,                                             // CompareOut
+  CO0CN, CO1CN, CO2CN, CO3CN,                                     // CO condition
+  CO0PW, CO1PW, CO2PW, CO3PW,                                     // CO PWM/frequency output
   SL0, SL1, SL2, SL3, SL4, SL5, SL6, SL7,                         // SaveLoad
   // Button8 type
   BUTTON_TYPE, CAN_SPEED,
   HWFF0L, HWFF1L, HWFF2L, HWFF3L, HWFF4L, HWFF5L,                 // HWF FilterLength(std11/ext29)
   SWF0SW, SWF1SW, SWF2SW, SWF3SW, SWF4SW, SWF5SW, SWF6SW, SWF7SW, // SWF 
   SWF0SU, SWF1SU, SWF2SU, SWF3SU, SWF4SU, SWF5SU, SWF6SU, SWF7SU,
-  CO0SW, CO1SW, CO2SW, CO3SW, CO4SW, CO5SW,
-  CO0POL, CO1POL, CO2POL, CO3POL, CO4POL, CO5POL,
+  SWF0BO, SWF1BO, SWF2BO, SWF3BO, SWF4BO, SWF5BO, SWF6BO, SWF7BO, // byte order
+  CO0SW, CO1SW, CO2SW, CO3SW,
+  CO0POL, CO1POL, CO2POL, CO3POL,
+  CO0LM, CO1LM, CO2LM, CO3LM,                                     // output mode (level/latch/toggle)
+  CO0CR, CO1CR, CO2CR, CO3CR,                                     // critical (ISR fast path)
+  CO0OT, CO1OT, CO2OT, CO3OT,                                     // output type (digital/PWM/frequency)
   AOHSW, AOSSW, AOSBO,
   SL0SV, SL1SV, SL2SV, SL3SV, SL4SV, SL5SV, SL6SV, SL7SV,
   SL0LD, SL1LD, SL2LD, SL3LD, SL4LD, SL5LD, SL6LD, SL7LD,
@@ -321,14 +391,28 @@ enum ePage {
   SWF0SI, SWF1SI, SWF2SI, SWF3SI, SWF4SI, SWF5SI, SWF6SI, SWF7SI, // start bit
   SWF0EB, SWF1EB, SWF2EB, SWF3EB, SWF4EB, SWF5EB, SWF6EB, SWF7EB, // end byte
   SWF0EI, SWF1EI, SWF2EI, SWF3EI, SWF4EI, SWF5EI, SWF6EI, SWF7EI, // end bit
-  CO0USF, CO1USF, CO2USF, CO3USF, CO4USF, CO5USF,
-  CO0TRS, CO1TRS, CO2TRS, CO3TRS, CO4TRS, CO5TRS,
+  SWF0FM, SWF1FM, SWF2FM, SWF3FM, SWF4FM, SWF5FM, SWF6FM, SWF7FM, // factor numerator
+  SWF0FD, SWF1FD, SWF2FD, SWF3FD, SWF4FD, SWF5FD, SWF6FD, SWF7FD, // factor denominator
+  SWF0OF, SWF1OF, SWF2OF, SWF3OF, SWF4OF, SWF5OF, SWF6OF, SWF7OF, // offset
+  SWF0ML, SWF1ML, SWF2ML, SWF3ML, SWF4ML, SWF5ML, SWF6ML, SWF7ML, // mux bit length
+  SWF0MB, SWF1MB, SWF2MB, SWF3MB, SWF4MB, SWF5MB, SWF6MB, SWF7MB, // mux end byte
+  SWF0MI, SWF1MI, SWF2MI, SWF3MI, SWF4MI, SWF5MI, SWF6MI, SWF7MI, // mux end bit
+  SWF0MV, SWF1MV, SWF2MV, SWF3MV, SWF4MV, SWF5MV, SWF6MV, SWF7MV, // mux value
+  CO0USF, CO1USF, CO2USF, CO3USF,
+  CO0TRS, CO1TRS, CO2TRS, CO3TRS,
+  CO0HY, CO1HY, CO2HY, CO3HY,                                     // hysteresis
+  CO0TN, CO1TN, CO2TN, CO3TN,                                     // on delay [ms]
+  CO0TF, CO1TF, CO2TF, CO3TF,                                     // off delay [ms]
+  CO0SP, CO1SP, CO2SP, CO3SP,                                     // PWM/frequency span
+  CO0FS, CO1FS, CO2FS, CO3FS,                                     // full scale frequency [Hz]
+  // Info type
+  INFO_TYPE, DGRX, DGSTAT, DGID,                                      // Diagnostics
   PAGEMAX
 };
 
 // 画面の種類を表す列挙型
 enum ePageType {
-  ERROR = -1, MONITOR, LIST8, BUTTON8, VALUE,
+  ERROR = -1, MONITOR, LIST8, BUTTON8, VALUE, INFO,
   PAGETYPEMAX
 };
 
@@ -367,8 +451,17 @@ struct pageInfo_value {
   const char* subTitle;       // Sub title
 };
 
+// ページの情報を格納する構造体の定義
+// 表示内容はloop側からsetInfoLine()で書き換える
+struct pageInfo_info {
+  ePage previous;             // 戻り先ページ
+  int8_t lineCount;           // 表示行数 max8
+  const char* topTitle;       // Top title
+  const char* subTitle;       // Sub title
+};
+
 // Status line
-const char StatusLine[] = "CANID: Message0-7      V";
+const char StatusLine[] = "                       V";  // 先頭はobjCaption_
 
 // Function prototypes ********************************************************************************
 int getButtonCount(int pageIndex);
@@ -394,6 +487,8 @@ struct monitorScrollType{
     } bit;
   } fMonitorDispSw_;
   bool fMonitorScrollSw_; // true:START false:STOP
+  bool fMonitorDeltaSw_;  // true:同じIDの前回からdataが変化したframeだけ表示
+  bool fMonitorTraceSw_;  // true:ID毎の固定行で表示 (trace) false:スクロール表示
 };
 
 // 画面描画クラスの定義
@@ -414,6 +509,10 @@ private:
   bool statuIconSw_[SLIMAX];  // status line icons on/off flag. index: eStatuLineIcon
   BoxObject *iconHF_, *iconHD_, *iconHA_, *iconSF_, *iconSD_, *iconSA_, *iconCD_;
   BoxObject *objVcan_;    // CAN voltage obj
+  BoxObject *objCaption_; // "CANID:" 変化表示モードでは"DELTA:" traceでは"TRACE:"
+  bool fTraceStartReq_ = false;           // traceに切り替わった
+  BoxObject *objBusLoad_, *objBusLoadDrop_;  // bus load obj 通常/取りこぼしあり
+  bool fBusLoadDrop_ = false;             // objBusLoadDrop_を表示中
   // ページ情報
   ePage currentPage_ = INMONITOR, newPage_ = INMONITOR; // 現在ページ、新ページ
   ePageType pageType_ = ERROR;                  // ページ画面種類
@@ -423,6 +522,10 @@ private:
   int regIndex_ = 0;                            // 保存レジスタのデータ位置
   int cursorPos_ = 0;                     // cursor position
   int8_t previousCursorPos_[VALUE_TYPE];  // previous page's cursor position
+  bool fInfoResetReq_ = false;            // Info pageでEキーが押された
+  int infoStepReq_ = 0;                   // Info pageでU/Dキーが押された -1:U +1:D
+  bool fInfoModeReq_ = false;             // Info pageでL/Rキーが押された
+  int swfBank_ = 0;                       // SWF0-7ページが指すSWFのbank (SWFn = bank * SWFBANKSIZE + n)
   // ページvalue情報
   uint8_t byteLen_, bitLen_;             // byte length(max8[bytes]), bit length (max32[bits])
   uint32_t currentValue_ = 0, newValue_ = 0;  // for value setting page
@@ -433,12 +536,22 @@ private:
   BoxObject* iconType2obj(eStatuLineIcon iconType);
   const canMaskFilterTable *pCanMaskFilterTable_;
   void noticeByteBitPositionError(int swfIndex);
+  // SWF bank
+  void applySwfBank();
+  void makeSwfTitles(String &topTitle, String &subTitle);
+  void changeSwfBank(int step);
   uint16_t bitposSwC_ = BITPOS_SWC, bitposSwE_ = BITPOS_SWE;     // for swapping sw
+  TftLineRenderer* lineRenderer_ = nullptr;   // nullptr: write1Lineはprintlnで描く
+  void finishLine();                          // DMAで送信中の行があれば完了を待つ (tftへの他の描画の前に呼ぶ)
+  DisplayLineQueue lineQueue_;                // postLine()した未描画の行
 
 public:
   Display(Adafruit_ILI9341* tft, SettingsManager* setMan, int width, int height, int titleH,
           int listItemH);
   
+  // モニター表示の1行をline buffer + DMAで描く
+  void setLineRenderer(TftLineRenderer* lineRenderer);
+
   // set CAN Mask/Filter flag for HWF menu
   void setCanMFtable(const canMaskFilterTable *pCanMaskFilterTable);
 
@@ -455,6 +568,9 @@ public:
   
   // monitor mode scroll type
   void resetMonitorScrollType();
+  void drawCaption();                         // monitorScrollType_に合わせてstatus line先頭を描く
+  void clearMonitorArea();                    // status line以外を消してスクロール位置を戻す
+  bool getTraceStartRequest();                // traceへの切替要求を取得してクリア
   monitorScrollType getMonitorScrollType();
 
   // Write Status line
@@ -462,14 +578,27 @@ public:
   void setStatusIconSw(eStatuLineIcon iconType, bool offOn);
   void drawStatusIcon(eStatuLineIcon iconType, bool offOn);
   void drawStatusIconAll();
-  void drawCANvoltage(String vCan);
+  void drawCANvoltage(const char* strVcan);
+  void drawBusLoad(const char* strLoad, bool fDrop);
 
   // Show 1 line with scrolling
-  void write1Line(String* s, uint16_t color = ILI9341_WHITE);
-  void postLine(String& s, uint16_t color = ILI9341_WHITE);
+  void write1Line(const char* s, uint16_t len, uint16_t color = ILI9341_WHITE, uint64_t hlChars = 0);
+  bool postLine(const char* s, uint16_t len, uint16_t color = ILI9341_WHITE, uint64_t hlChars = 0);   // false: 表示停止中で表示しなかった
+  bool renderLine();                          // 積まれた行を1行だけ描く false:描く行が無い/DMA転送中
+  uint32_t getLineDropCount();                // 描画が追いつかず捨てた行数
+  uint8_t getLineQueueHighWater();
+  void resetLineQueueCounters();
 
   // check if the display mode is monitor
   bool isMonitorMode();
+
+  // Info page
+  bool isInfoMode();
+  ePage getCurrentPage();
+  void setInfoLine(int line, const char* s);
+  bool getInfoResetRequest();                 // Eキーによるリセット要求を取得してクリア
+  int getInfoStepRequest();                   // U/Dキーによる表示対象の変更要求(-1/0/+1)を取得してクリア
+  bool getInfoModeRequest();                  // L/Rキーによる表示方法の変更要求を取得してクリア
   
   // check if the display mode is changed
   bool isPageChanged();
@@ -0,0 +1,89 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "FL_busload.h"
+
+// **************************************************************************************************************
+// Class BusLoadMeter *******************************************************************************************
+// **************************************************************************************************************
+BusLoadMeter::BusLoadMeter()
+    : bitrate_(0), bits_(0), frames_(0), lastTime_(0), lastDrops_(0),
+      loadPermille_(0), fps_(0), dropPerSec_(0) {
+  for (uint8_t dlc = 0; dlc <= 8; dlc++) {
+    frameBits_[0][dlc] = calcFrameBits(false, dlc);
+    frameBits_[1][dlc] = calcFrameBits(true, dlc);
+  }
+}
+
+// 最大 extended DLC8: 118 + 29 + 13 = 160 bit
+uint8_t BusLoadMeter::calcFrameBits(bool ext, uint8_t dlc) {
+  uint8_t g = (ext ? 54 : 34) + 8 * dlc;
+#if BUSLOAD_WORSTCASE
+  uint8_t stuff = (g - 1) / 4;
+#else
+  uint8_t stuff = (g + 16) / 32;
+#endif
+  return g + stuff + BUSLOAD_FIXEDBITS;
+}
+
+void BusLoadMeter::setBitrate(uint32_t bitrate) {
+  bitrate_ = bitrate;
+}
+
+void BusLoadMeter::addFrame(const canMessageSet &msg) {
+  bits_ += frameBits_[msg.ext ? 1 : 0][msg.len > 8 ? 8 : msg.len];
+  frames_++;
+}
+
+void BusLoadMeter::update(uint32_t now, uint32_t drops) {
+  uint32_t dt = now - lastTime_;
+  if (dt == 0) return;
+  // 取りこぼし累計がリセットされていたら今回の値をそのまま区間の数とする
+  uint32_t dropped = (drops >= lastDrops_) ? drops - lastDrops_ : drops;
+  // 取りこぼしたframeは受信frameの平均bit数で見積もる
+  uint32_t avgBits = frames_ ? bits_ / frames_ : frameBits_[0][8];
+  uint64_t bits = (uint64_t)bits_ + (uint64_t)dropped * avgBits;
+  if (bitrate_ != 0) {
+    uint64_t permille = bits * 1000000000ULL / ((uint64_t)bitrate_ * dt);
+    loadPermille_ = permille > 1000 ? 1000 : (uint16_t)permille;
+  }
+  fps_ = (uint32_t)((uint64_t)(frames_ + dropped) * 1000000 / dt);
+  dropPerSec_ = (uint32_t)((uint64_t)dropped * 1000000 / dt);
+  bits_ = 0;
+  frames_ = 0;
+  lastTime_ = now;
+  lastDrops_ = drops;
+}
+
+uint16_t BusLoadMeter::getLoadPermille() {
+  return loadPermille_;
+}
+
+uint32_t BusLoadMeter::getFps() {
+  return fps_;
+}
+
+uint32_t BusLoadMeter::getDropPerSec() {
+  return dropPerSec_;
+}
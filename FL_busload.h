@@ -0,0 +1,66 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#ifndef _FL_BUSLOAD_H_
+#define _FL_BUSLOAD_H_
+
+#include <Arduino.h>
+#include "mcp25625_can.h"     // canMessageSet
+
+// ***** Bus load definitions
+#define BUSLOAD_WORSTCASE   0   // stuff bit 1:最悪値 (g-1)/4  0:期待値 ランダムなdataで約g/32
+#define BUSLOAD_FIXEDBITS   13  // stuffされない部分 CRC delimiter 1 + ACK 2 + EOF 7 + IFS 3
+
+// **************************************************************************************************************
+// Class BusLoadMeter *******************************************************************************************
+// **************************************************************************************************************
+// 受信frameのbus上のbit数を積算し、update()毎にその区間のbus load/frame数/取りこぼし数を求める
+// frameのbit数はSOFからCRCまで(stuff対象 g bit) + stuff bit + BUSLOAD_FIXEDBITS
+//   standard: g = 34 + 8*DLC, extended: g = 54 + 8*DLC
+// [ext][DLC]の表を引いて足すだけなので1Mbpsの全frameで呼んでもよい
+// addFrame()/update()/getterはloop()からのみ呼ぶ
+class BusLoadMeter {
+private:
+  uint8_t frameBits_[2][9];   // [ext][DLC] 1frameのbit数
+  uint32_t bitrate_;          // [bit/s]
+  uint32_t bits_;             // 区間内に受信したbit数
+  uint32_t frames_;           // 区間内に受信したframe数
+  uint32_t lastTime_;         // 前回update()の時刻 [us]
+  uint32_t lastDrops_;        // 前回update()時の取りこぼし累計
+  uint16_t loadPermille_;     // bus load [0.1%]
+  uint32_t fps_;              // [frames/s] 取りこぼしを含む
+  uint32_t dropPerSec_;       // [frames/s]
+
+public:
+  BusLoadMeter();
+  void setBitrate(uint32_t bitrate);          // [bit/s]
+  void addFrame(const canMessageSet &msg);
+  void update(uint32_t now, uint32_t drops);  // now: [us] drops: 取りこぼしたframe数の累計
+  uint16_t getLoadPermille();
+  uint32_t getFps();
+  uint32_t getDropPerSec();
+  static uint8_t calcFrameBits(bool ext, uint8_t dlc);
+};
+
+#endif
@@ -0,0 +1,123 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "FL_canring.h"
+
+// slotの書込/読出がindex更新を跨いで並べ替えられないようにする
+#define COMPILER_BARRIER()  __asm__ __volatile__("" ::: "memory")
+
+// **************************************************************************************************************
+// Class CanFrameRing *******************************************************************************************
+// **************************************************************************************************************
+CanFrameRing::CanFrameRing(eRingPolicy policy)
+    : head_(0), tail_(0), policy_(policy), reservedIsDiscard_(false),
+      pushedCount_(0), overflowCount_(0), highWater_(0) {}
+
+// producer side ************************************************************************************************
+canMessageSet* CanFrameRing::reserve() {
+  uint16_t h = head_;
+  if ((uint16_t)(h - tail_) >= CANRINGSIZE) {   // 満杯
+    if (policy_ == RING_DROP_NEWEST) {
+      // MCPのRXバッファは空けないとINTが下がったままになるので、読み捨て先を返す
+      reservedIsDiscard_ = true;
+      return &discard_;
+    }
+    tail_ = tail_ + 1;                          // 最古を捨てる
+    overflowCount_ = overflowCount_ + 1;
+  }
+  reservedIsDiscard_ = false;
+  return &slot_[h & CANRINGMASK];
+}
+
+void CanFrameRing::commit() {
+  if (reservedIsDiscard_) {
+    overflowCount_ = overflowCount_ + 1;
+    return;
+  }
+  COMPILER_BARRIER();
+  uint16_t used = (uint16_t)(head_ + 1 - tail_);
+  head_ = head_ + 1;
+  pushedCount_ = pushedCount_ + 1;
+  if (used > highWater_) highWater_ = used;
+}
+
+// consumer side ************************************************************************************************
+bool CanFrameRing::pop(canMessageSet &msg) {
+  for (;;) {
+    uint16_t t = tail_;
+    if (t == head_) return false;               // 空
+    COMPILER_BARRIER();
+    msg = slot_[t & CANRINGMASK];
+    COMPILER_BARRIER();
+    // コピー中にISRが最古を捨てていなければ確定、捨てられていたら次の最古を読み直す
+    noInterrupts();
+    bool unchanged = (tail_ == t);
+    if (unchanged) tail_ = t + 1;
+    interrupts();
+    if (unchanged) return true;
+  }
+}
+
+void CanFrameRing::clear() {
+  noInterrupts();
+  tail_ = head_;
+  interrupts();
+}
+
+uint16_t CanFrameRing::count() {
+  return (uint16_t)(head_ - tail_);
+}
+
+bool CanFrameRing::isEmpty() {
+  return head_ == tail_;
+}
+
+// settings and counters ****************************************************************************************
+void CanFrameRing::setPolicy(eRingPolicy policy) {
+  policy_ = policy;
+}
+
+eRingPolicy CanFrameRing::getPolicy() {
+  return policy_;
+}
+
+uint32_t CanFrameRing::getPushedCount() {
+  return pushedCount_;
+}
+
+uint32_t CanFrameRing::getOverflowCount() {
+  return overflowCount_;
+}
+
+uint16_t CanFrameRing::getHighWater() {
+  return highWater_;
+}
+
+void CanFrameRing::resetCounters() {
+  noInterrupts();
+  pushedCount_ = 0;
+  overflowCount_ = 0;
+  highWater_ = (uint16_t)(head_ - tail_);
+  interrupts();
+}
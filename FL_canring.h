@@ -0,0 +1,84 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#ifndef _FL_CANRING_H_
+#define _FL_CANRING_H_
+
+#include <Arduino.h>
+#include "mcp25625_can.h"     // canMessageSet
+
+// ***** CAN frame ring definitions
+#define CANRINGSIZE     64                  // frame slots, must be power of 2
+#define CANRINGMASK     (CANRINGSIZE - 1)
+#define CANRINGPOLICY   RING_DROP_OLDEST    // default overflow policy
+
+// 満杯時の動作
+enum eRingPolicy {
+  RING_DROP_OLDEST,   // 最古のフレームを捨てて新しいフレームを格納
+  RING_DROP_NEWEST    // 新しいフレームを読み捨てる
+};
+
+// **************************************************************************************************************
+// Class CanFrameRing *******************************************************************************************
+// **************************************************************************************************************
+// Single producer (MCP25625 ISR) / single consumer (loop) ring of CAN frames.
+// Producer: reserve() -> fill the slot -> commit(). Call from the ISR only.
+// Consumer: pop(). Call from loop() only.
+// DROP_OLDESTでは満杯時にISRがtailを進めるため、pop()はコピー後にtailが動いていないことを
+// 割込禁止区間で確認してからtailを進める(M0+にはLDREX/STREXがない)
+class CanFrameRing {
+private:
+  canMessageSet slot_[CANRINGSIZE];
+  canMessageSet discard_;               // DROP_NEWEST満杯時の読み捨て先
+  volatile uint16_t head_;              // 書込位置 (ISRのみ更新)
+  volatile uint16_t tail_;              // 読出位置 (loop, DROP_OLDEST満杯時はISRも更新)
+  volatile eRingPolicy policy_;
+  bool reservedIsDiscard_;              // reserve()がdiscard_を返した
+  volatile uint32_t pushedCount_;       // ringに格納したフレーム数
+  volatile uint32_t overflowCount_;     // 満杯で捨てたフレーム数
+  volatile uint16_t highWater_;         // 最大使用スロット数
+
+public:
+  CanFrameRing(eRingPolicy policy = CANRINGPOLICY);
+
+  // producer side (ISR)
+  canMessageSet* reserve();             // 書込先スロットを取得 (満杯でも必ず返す)
+  void commit();                        // reserve()したスロットを確定
+
+  // consumer side (loop)
+  bool pop(canMessageSet &msg);         // true:msgに1フレーム取得 false:空
+  void clear();                         // 未読フレームを全て破棄
+  uint16_t count();                     // 未読フレーム数
+  bool isEmpty();
+
+  // settings and counters
+  void setPolicy(eRingPolicy policy);
+  eRingPolicy getPolicy();
+  uint32_t getPushedCount();
+  uint32_t getOverflowCount();
+  uint16_t getHighWater();
+  void resetCounters();
+};
+
+#endif
@@ -0,0 +1,118 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "FL_comparator.h"
+#include "FL_timebase.h"
+
+// **************************************************************************************************************
+// Plan state ***************************************************************************************************
+// **************************************************************************************************************
+bool comparatorSameConfig(const comparatorPlan &a, const comparatorPlan &b) {
+  return a.threshold == b.threshold && a.thresholdOff == b.thresholdOff && a.onDelay == b.onDelay &&
+         a.offDelay == b.offDelay && a.pinMask == b.pinMask && a.polMask == b.polMask &&
+         a.latchMode == b.latchMode && a.coNum == b.coNum && a.swfNum == b.swfNum && a.inputs == b.inputs;
+}
+
+bool criticalComparatorSameConfig(const criticalComparator &a, const criticalComparator &b) {
+  const canSoftwareFilterPlan &x = a.swf, &y = b.swf;
+  return comparatorSameConfig(a.co, b.co) && a.outSet == b.outSet &&
+         x.mask == y.mask && x.id == y.id && x.scaleMul == y.scaleMul && x.scaleOffset == y.scaleOffset &&
+         x.muxMask == y.muxMask && x.muxValue == y.muxValue && x.shift == y.shift && x.signShift == y.signShift &&
+         x.intel == y.intel && x.scaled == y.scaled && x.scaleShift == y.scaleShift && x.muxShift == y.muxShift;
+}
+
+void comparatorCopyState(comparatorPlan &to, const comparatorPlan &from) {
+  to.cond = from.cond;
+  to.stable = from.stable;
+  to.pending = from.pending;
+  to.out = from.out;
+  to.since = from.since;
+}
+
+// **************************************************************************************************************
+// Comparator step **********************************************************************************************
+// **************************************************************************************************************
+uint8_t stepComparator(comparatorPlan &plan, bool cond, uint32_t timestamp, uint32_t *set, uint32_t *clr,
+                       comparatorOutputState &out) {
+  plan.cond = cond;
+  // on/off delay: 受信時刻の差で判定
+  bool rise = false;
+  if (cond == plan.stable) plan.pending = false;
+  else {
+    if (!plan.pending) {
+      plan.pending = true;
+      plan.since = timestamp;
+    }
+    if (timestamp - plan.since >= (cond ? plan.onDelay : plan.offDelay)) {
+      plan.stable = cond;
+      plan.pending = false;
+      rise = cond;
+    }
+  }
+  // output mode
+  if (plan.latchMode == COLM_LEVEL) plan.out = plan.stable;
+  else if (rise) plan.out = (plan.latchMode == COLM_LATCH) ? true : !plan.out;
+  bool lowHigh = plan.out;
+  uint32_t active = (lowHigh ? plan.pinMask : 0) ^ plan.polMask;
+  set[plan.port] |= active;
+  clr[plan.port] |= active ^ plan.pinMask;
+  if (out.state[plan.coNum] == lowHigh) return 0;
+  out.state[plan.coNum] = lowHigh;
+  return 1 << plan.coNum;
+}
+
+// **************************************************************************************************************
+// Critical comparator (ISR fast path) **************************************************************************
+// **************************************************************************************************************
+// 最悪実行時間はcritical CO数に比例し、1 COあたり64bit演算がCRITOPxxx回以下とstepComparator()の分岐だけ
+// loopもsettingsの参照もない。演算数の上限はtests/test_comparatorで確認する
+bool runCriticalComparators(criticalComparator *crits, uint8_t count, const canMessageSet &msg,
+                            comparatorOutputState &out) {
+  uint64_t data[2];
+  bool fLoaded = false;
+  for (uint8_t i = 0; i < count; i++) {
+    criticalComparator &crit = crits[i];
+    if (crit.swf.id != msg.id) continue;
+    SWFOPCOUNT(SWFOP_CO, 1);
+    if (!fLoaded) {
+      data[SWFBO_INTEL] = loadMsgData64(msg.buf);
+      data[SWFBO_MOTOROLA] = __builtin_bswap64(data[SWFBO_INTEL]);
+      SWFOPCOUNT(SWFOP_ALU64, 1);
+      fLoaded = true;
+    }
+    if (crit.swf.muxMask != 0) {
+      SWFOPCOUNT(SWFOP_SHIFT64, 1);
+      SWFOPCOUNT(SWFOP_ALU64, 2);
+      if (((data[crit.swf.intel] >> crit.swf.muxShift) & crit.swf.muxMask) != crit.swf.muxValue) continue;
+    }
+    int64_t value = extractSwfValue(crit.swf, data);
+    comparatorPlan &plan = crit.co;
+    uint32_t set[1] = {0}, clr[1] = {0};
+    uint8_t changed = stepComparator(plan, comparatorCond(plan, value), msg.timestamp, set, clr, out);
+    if (set[0]) *crit.outSet = set[0];
+    if (clr[0]) *crit.outClr = clr[0];
+    if (changed) comparatorRecordChange(out, plan.coNum, msg.timestamp, timebaseNow() - msg.timestamp);
+  }
+  return fLoaded;
+}
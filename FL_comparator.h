@@ -0,0 +1,128 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#ifndef _FL_COMPARATOR_H_
+#define _FL_COMPARATOR_H_
+
+#include <Arduino.h>
+#include "mcp25625_can.h"     // canMessageSet
+#include "FL_swfplan.h"       // canSoftwareFilterPlan, extractSwfValue
+
+// ***** Comparator output definitions
+#define COOUTMAX        4       // CO count (PIN_COCOUNT以上)
+#define COPORTMAX       2       // SAMD21 PORT group count (PA, PB)
+// CO output mode (COLM)
+#define COLM_LEVEL      0       // 条件が成立している間active
+#define COLM_LATCH      1       // 条件の成立でactiveになり、解除するまで保持
+#define COLM_TOGGLE     2       // 条件の成立毎にactive/inactiveを反転
+#define COLMCOUNT       3
+
+// critical CO 1個あたりの最悪経路の演算数の上限 (mux判定 + 抽出 + scaling + hysteresis)
+// tests/test_comparatorが全scaling経路で超えないことを確認する。1フレームでbswapの分ALU64が1回増える
+#define CRITOPMUL64     3
+#define CRITOPSHIFT64   9
+#define CRITOPALU64     10
+// Cortex-M0+ 48MHz (flash 1 wait) での1回あたりのcycle数の見積り (実機の値ではない)
+// MUL64: __aeabi_lmul / overflow判定付き乗算, SHIFT64: __aeabi_llsl/llsr/lasr の呼出
+// CO: ID比較, stepComparator(), PORT書込2回, timebaseNow(), latency記録
+#define CRITCYCMUL64    60
+#define CRITCYCSHIFT64  15
+#define CRITCYCALU64    4
+#define CRITCYCCO       200
+#define CRITCPUMHZ      48
+// n個のcritical COが1フレームで全て一致した時の見積り [cycles] [us]
+#define CRITWCETCYCLES(n)   ((n) * (CRITOPMUL64 * CRITCYCMUL64 + CRITOPSHIFT64 * CRITCYCSHIFT64 + \
+                                    CRITOPALU64 * CRITCYCALU64 + CRITCYCCO) + CRITCYCALU64)
+#define CRITWCETUS(n)       ((CRITWCETCYCLES(n) + CRITCPUMHZ - 1) / CRITCPUMHZ)
+
+// Comparator plan (設定変更時に作成)
+// 条件 = value >= threshold (成立中は value >= thresholdOff) をフレームの受信時刻でon/off delay判定し、
+// COLMに従った出力 XOR COPOL を PORT group毎にOUTSET/OUTCLR各1回で書く
+// delayの経過はそのSWFの次のフレームで判定する (loop()でのtimer pollingはしない)
+struct comparatorPlan {
+  int64_t threshold;    // COTRS
+  int64_t thresholdOff; // threshold - COHY (成立中はこれを下回るまで成立のまま)
+  uint32_t onDelay;     // [us] 条件の成立がこの時間続いたら確定
+  uint32_t offDelay;    // [us] 条件の不成立がこの時間続いたら確定
+  uint32_t pinMask;     // PORT groupの出力bit
+  uint32_t polMask;     // COPOL=1:pinMask (比較結果を反転して出力) 0:0
+  uint8_t latchMode;    // COLM_xxx
+  uint8_t port;         // set/clr maskのindex (PORT group)
+  uint8_t coNum;
+  uint8_t swfNum;       // COUSF CORULESWF:複合条件
+  swfMask_t inputs;     // 参照するSWF
+  // 状態 (planを作り直す時に初期化)
+  bool cond;            // hysteresis判定後の条件
+  bool stable;          // delay判定後の条件
+  bool pending;         // cond != stable で delay待ち
+  bool out;             // 出力 (COPOL適用前)
+  uint32_t since;       // condがstableと異なり始めたフレームの受信時刻 [us]
+};
+
+// CO毎の出力状態。critical COはCAN受信割込からも書くのでvolatile
+struct comparatorOutputState {
+  volatile int8_t state[COOUTMAX];        // 前回の出力 -1:未出力 0:LOW 1:HIGH
+  volatile uint32_t changeTime[COOUTMAX]; // 出力が変化したフレームの受信時刻 [us]
+  volatile uint32_t latency[COOUTMAX];    // 受信からCO出力変化までの時間 [us]
+  volatile uint32_t latencyMax[COOUTMAX]; // latencyの最大値 [us]
+};
+
+// critical CO: CAN受信割込の中でID一致 -> mux判定 -> 抽出 -> scaling -> 出力まで行う
+struct criticalComparator {
+  canSoftwareFilterPlan swf;    // COUSFのswfPlanのコピー
+  comparatorPlan co;            // co.portは0 (set/clrの[0]だけ使う)
+  volatile uint32_t *outSet;    // PORT group OUTSET.reg
+  volatile uint32_t *outClr;    // PORT group OUTCLR.reg
+};
+
+// hysteresis: 成立中はthresholdOffを下回るまで成立のまま
+static inline bool comparatorCond(const comparatorPlan &plan, int64_t value) {
+  SWFOPCOUNT(SWFOP_ALU64, 1);
+  return value >= (plan.cond ? plan.thresholdOff : plan.threshold);
+}
+
+// 出力が変化したCOの受信からの遅延を記録する
+static inline void comparatorRecordChange(comparatorOutputState &out, uint8_t coNum, uint32_t timestamp,
+                                          uint32_t latency) {
+  out.changeTime[coNum] = timestamp;
+  out.latency[coNum] = latency;
+  if (latency > out.latencyMax[coNum]) out.latencyMax[coNum] = latency;
+}
+
+// 設定から作った部分 (状態とport index以外) が同じか。同じなら作り直したplanに前の状態を引き継ぐ
+bool comparatorSameConfig(const comparatorPlan &a, const comparatorPlan &b);
+bool criticalComparatorSameConfig(const criticalComparator &a, const criticalComparator &b);
+// cond/stable/pending/out/sinceをコピーする (latchの保持とdelayの計時を続ける)
+void comparatorCopyState(comparatorPlan &to, const comparatorPlan &from);
+
+// 条件(hysteresis判定後)からon/off delayとoutput modeを適用して出力(COPOL適用前)を決め、
+// PORT group毎のset/clr maskに積む。戻り値 bit n: COnの出力が変化
+uint8_t stepComparator(comparatorPlan &plan, bool cond, uint32_t timestamp, uint32_t *set, uint32_t *clr,
+                       comparatorOutputState &out);
+// CAN受信割込の中で1フレーム毎に呼ぶ。一致したcritical COを判定してPORTに書く
+// 戻り値 false:該当IDなし
+bool runCriticalComparators(criticalComparator *crits, uint8_t count, const canMessageSet &msg,
+                            comparatorOutputState &out);
+
+#endif
@@ -0,0 +1,188 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "FL_idtable.h"
+
+// **************************************************************************************************************
+// Class CanIdTable *********************************************************************************************
+// **************************************************************************************************************
+CanIdTable::CanIdTable() {
+  clear();
+}
+
+uint16_t CanIdTable::hashOf(uint32_t key) {
+  return (uint16_t)((key * 2654435761UL) >> 20) & IDHASHMASK;
+}
+
+int CanIdTable::findSlot(uint32_t key) {
+  for (uint16_t h = hashOf(key), n = 0; n < IDHASHSIZE; h = (h + 1) & IDHASHMASK, n++) {
+    if (hash_[h] == 0) return -1;
+    if (entry_[hash_[h] - 1].key == key) return h;
+  }
+  return -1;
+}
+
+void CanIdTable::removeSlot(uint16_t slot) {
+  uint16_t i = slot;
+  uint16_t j = slot;
+  hash_[i] = 0;
+  for (;;) {
+    j = (j + 1) & IDHASHMASK;
+    if (hash_[j] == 0) return;
+    uint16_t k = hashOf(entry_[hash_[j] - 1].key);
+    // kが(i, j]にあるentryは空いたiより手前に戻せない
+    bool inRange = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+    if (inRange) continue;
+    hash_[i] = hash_[j];
+    hash_[j] = 0;
+    i = j;
+  }
+}
+
+uint8_t CanIdTable::evictOldest(uint32_t now) {
+  uint8_t oldest = 0;
+  uint32_t oldestAge = 0;
+  for (uint8_t n = 0; n < used_; n++) {
+    uint32_t age = now - entry_[n].lastTime;
+    if (age >= oldestAge) {
+      oldestAge = age;
+      oldest = n;
+    }
+  }
+  int slot = findSlot(entry_[oldest].key);
+  if (slot >= 0) removeSlot(slot);
+  evictedCount_++;
+  return oldest;
+}
+
+// 前回のdataとの比較はDLCまでのbyteを64bitのXORで行う
+static uint16_t changedBytes(const uint8_t *prev, const uint8_t *cur, uint8_t dlc) {
+  uint64_t a, b;
+  memcpy(&a, prev, 8);
+  memcpy(&b, cur, 8);
+  uint64_t diff = a ^ b;
+  if (dlc < 8) diff &= ((uint64_t)1 << (dlc * 8)) - 1;
+  uint16_t changed = 0;
+  for (uint8_t n = 0; diff != 0; n++, diff >>= 8) {
+    if (diff & 0xFF) changed |= 1 << n;
+  }
+  return changed;
+}
+
+uint16_t CanIdTable::update(const canMessageSet &msg) {
+  uint32_t key = msg.ext ? (msg.id | IDKEY_EXT) : msg.id;
+  uint16_t h = hashOf(key);
+  uint8_t n;
+  for (;;) {
+    uint8_t s = hash_[h];
+    if (s == 0) break;                        // 未登録
+    if (entry_[s - 1].key == key) {           // 登録済み
+      canIdEntry &e = entry_[s - 1];
+      uint32_t period = msg.timestamp - e.lastTime;
+      if (e.ewmaPeriod == 0) {
+        e.ewmaPeriod = e.minPeriod = e.maxPeriod = period;
+      } else {
+        e.ewmaPeriod += ((int32_t)(period - e.ewmaPeriod)) >> IDEWMASHIFT;
+        if (period < e.minPeriod) e.minPeriod = period;
+        if (period > e.maxPeriod) e.maxPeriod = period;
+      }
+      uint16_t changed = (msg.len == e.dlc) ? changedBytes(e.data, msg.buf, msg.len) : IDCHG_NEW;
+      e.count++;
+      e.lastTime = msg.timestamp;
+      e.dlc = msg.len;
+      memcpy(e.data, msg.buf, sizeof(e.data));
+      return changed;
+    }
+    h = (h + 1) & IDHASHMASK;
+  }
+  // 新しいID
+  if (used_ < IDTABLESIZE) {
+    n = used_++;
+  } else {
+    n = evictOldest(msg.timestamp);
+    h = hashOf(key);                          // back shiftでslotが動くので探し直す
+    while (hash_[h] != 0) h = (h + 1) & IDHASHMASK;
+  }
+  canIdEntry &e = entry_[n];
+  e.key = key;
+  e.dlc = msg.len;
+  memcpy(e.data, msg.buf, sizeof(e.data));
+  e.count = 1;
+  e.lastTime = msg.timestamp;
+  e.ewmaPeriod = e.minPeriod = e.maxPeriod = 0;
+  hash_[h] = n + 1;
+  return IDCHG_NEW;
+}
+
+void CanIdTable::clear() {
+  memset(hash_, 0, sizeof(hash_));
+  used_ = 0;
+  evictedCount_ = 0;
+}
+
+uint16_t CanIdTable::getUsed() {
+  return used_;
+}
+
+uint32_t CanIdTable::getEvictedCount() {
+  return evictedCount_;
+}
+
+const canIdEntry& CanIdTable::getEntry(uint8_t n) {
+  return entry_[n];
+}
+
+// sort ********************************************************************************************************
+bool CanIdTable::isBefore(uint8_t a, uint8_t b, eIdSortKey sortKey) {
+  const canIdEntry &ea = entry_[a];
+  const canIdEntry &eb = entry_[b];
+  switch (sortKey) {
+    case IDSORT_COUNT:
+      return ea.count > eb.count;
+    case IDSORT_RATE:
+      if (ea.ewmaPeriod == 0) return false;
+      if (eb.ewmaPeriod == 0) return true;
+      return ea.ewmaPeriod < eb.ewmaPeriod;
+    case IDSORT_ID: default:
+      return ea.key < eb.key;
+  }
+}
+
+// entry数は高々IDTABLESIZEなので挿入ソート
+uint8_t CanIdTable::sort(uint8_t *order, eIdSortKey sortKey) {
+  for (uint8_t n = 0; n < used_; n++) {
+    uint8_t m = n;
+    while (m > 0 && isBefore(n, order[m - 1], sortKey)) {
+      order[m] = order[m - 1];
+      m--;
+    }
+    order[m] = n;
+  }
+  return used_;
+}
+
+double CanIdTable::getRate(const canIdEntry &e) {
+  if (e.ewmaPeriod == 0) return 0.0;
+  return 1000000.0 / e.ewmaPeriod;
+}
@@ -0,0 +1,95 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#ifndef _FL_IDTABLE_H_
+#define _FL_IDTABLE_H_
+
+#include <Arduino.h>
+#include "mcp25625_can.h"     // canMessageSet
+
+// ***** CAN ID traffic table definitions
+#define IDTABLESIZE     64                  // entries (max 255), 1 entry = 36 bytes
+#define IDHASHSIZE      (2 * IDTABLESIZE)   // hash slots, must be power of 2
+#define IDHASHMASK      (IDHASHSIZE - 1)
+#define IDKEY_EXT       0x80000000UL        // keyのbit31: extended ID (29bitなので衝突しない)
+#define IDEWMASHIFT     3                   // EWMA係数 1/8
+#define IDCHG_NEW       0x100               // update()の戻り値: 新しいID又はDLCが変わった (bit0-7: 変化したbyte)
+
+#if IDTABLESIZE > 255
+#error "IDTABLESIZE must be 255 or less"
+#endif
+
+// 並べ替えの基準
+enum eIdSortKey {
+  IDSORT_COUNT,     // 受信数の多い順
+  IDSORT_RATE,      // 周期の短い順 (1回しか受信していないIDは最後)
+  IDSORT_ID,        // CAN IDの小さい順 (standard -> extended)
+  IDSORTMAX
+};
+
+// 1 CAN IDの受信状況
+struct canIdEntry {
+  uint32_t key;         // CAN ID | IDKEY_EXT
+  uint8_t dlc;
+  uint8_t data[8];      // 最後に受信したdata
+  uint32_t count;       // 受信数
+  uint32_t lastTime;    // 最後の受信時刻 [us]
+  uint32_t ewmaPeriod;  // 受信周期のEWMA [us] 0:未計測
+  uint32_t minPeriod;   // [us]
+  uint32_t maxPeriod;   // [us]
+};
+
+// **************************************************************************************************************
+// Class CanIdTable *********************************************************************************************
+// **************************************************************************************************************
+// CAN ID毎の受信数/周期/DLC/最後のdataを固定容量の表に集計する
+// 表引きはlinear probingのopen addressing (slot = entry番号+1, 0:空)
+// 満杯で新しいIDを受信したら、最後の受信が最も古いentryを追い出して再利用する (LRU)
+// update()/getter/sort()はloop()からのみ呼ぶ
+class CanIdTable {
+private:
+  canIdEntry entry_[IDTABLESIZE];
+  uint8_t hash_[IDHASHSIZE];
+  uint16_t used_;           // 使用entry数
+  uint32_t evictedCount_;   // 追い出したentry数
+
+  static uint16_t hashOf(uint32_t key);
+  int findSlot(uint32_t key);           // keyのあるslot -1:なし
+  void removeSlot(uint16_t slot);       // slotを空けて後続をback shiftする
+  uint8_t evictOldest(uint32_t now);    // 最も古いentryを表から外してentry番号を返す
+  bool isBefore(uint8_t a, uint8_t b, eIdSortKey sortKey);
+
+public:
+  CanIdTable();
+  uint16_t update(const canMessageSet &msg);     // 前回の同じIDのframeから変化したbyte (IDCHG_NEW)
+  void clear();
+
+  uint16_t getUsed();
+  uint32_t getEvictedCount();
+  const canIdEntry& getEntry(uint8_t n);
+  uint8_t sort(uint8_t *order, eIdSortKey sortKey);   // orderにentry番号を並べてentry数を返す
+  static double getRate(const canIdEntry &e);         // EWMA周期からの受信頻度 [Hz]
+};
+
+#endif
@@ -0,0 +1,91 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "FL_linefmt.h"
+
+static const char hexDigits[] = "0123456789ABCDEF";
+
+// **************************************************************************************************************
+// Class LineFormatter ******************************************************************************************
+// **************************************************************************************************************
+void LineFormatter::clear() {
+  len_ = 0;
+  buf_[0] = '\0';
+}
+
+void LineFormatter::put(char c) {
+  if (len_ >= LINEFMTSIZE) return;
+  buf_[len_++] = c;
+  buf_[len_] = '\0';
+}
+
+void LineFormatter::put(const char *s) {
+  while (*s != '\0' && len_ < LINEFMTSIZE) buf_[len_++] = *s++;
+  buf_[len_] = '\0';
+}
+
+void LineFormatter::putHex(uint32_t value, uint8_t digits) {
+  if (digits == 0) {                            // 上位の0を飛ばす (0は"0")
+    digits = 1;
+    for (uint32_t v = value >> 4; v != 0; v >>= 4) digits++;
+  }
+  for (int8_t n = digits - 1; n >= 0; n--) put(hexDigits[(value >> (n * 4)) & 0x0F]);
+}
+
+// 下の桁から一時bufferに作って逆順に写す (M0+に除算命令はないが定数10の除算は乗算になる)
+void LineFormatter::putDec(uint32_t value, uint8_t width, char pad) {
+  char tmp[10];
+  uint8_t n = 0;
+  do {
+    tmp[n++] = '0' + value % 10;
+    value /= 10;
+  } while (value != 0);
+  for (uint8_t w = n; w < width; w++) put(pad);
+  while (n > 0) put(tmp[--n]);
+}
+
+void LineFormatter::putDec(int32_t value) {
+  if (value < 0) {
+    put('-');
+    putDec((uint32_t)0 - (uint32_t)value);
+  }
+  else putDec((uint32_t)value);
+}
+
+void LineFormatter::putFixed(double value, uint8_t decimals) {
+  if (isnan(value)) { put("nan"); return; }
+  bool neg = value < 0;
+  if (neg) value = -value;
+  uint32_t scale = 1;
+  for (uint8_t n = 0; n < decimals; n++) scale *= 10;
+  double scaled = value * scale + 0.5;
+  if (scaled >= 4294967295.0 * scale) { put(neg ? "-ovf" : "ovf"); return; }
+  uint64_t v = (uint64_t)scaled;
+  if (neg && v != 0) put('-');                  // 丸めて0になる負の値は"-0.000"にしない
+  putDec((uint32_t)(v / scale));
+  if (decimals > 0) {
+    put('.');
+    putDec((uint32_t)(v % scale), decimals, '0');
+  }
+}
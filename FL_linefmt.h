@@ -0,0 +1,56 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#ifndef _FL_LINEFMT_H_
+#define _FL_LINEFMT_H_
+
+#include <Arduino.h>
+
+// ***** Line formatter definitions
+#define LINEFMTSIZE     64      // 1行の最大文字数 (モニター表示は40文字で折り返す)
+
+// **************************************************************************************************************
+// Class LineFormatter ******************************************************************************************
+// **************************************************************************************************************
+// 固定長bufferに1行を組み立てる。heapを使わずsprintfも呼ばないので受信frame毎に使ってよい
+// LINEFMTSIZEを超えた文字は捨てる。stackに置いて使う
+class LineFormatter {
+private:
+  char buf_[LINEFMTSIZE + 1];
+  uint8_t len_;
+
+public:
+  LineFormatter() : len_(0) { buf_[0] = '\0'; }
+  void clear();
+  void put(char c);
+  void put(const char *s);
+  void putHex(uint32_t value, uint8_t digits);            // 大文字16進 digits 0:ゼロ詰めしない
+  void putDec(uint32_t value, uint8_t width = 0, char pad = ' ');  // width: 右詰め桁数
+  void putDec(int32_t value);
+  void putFixed(double value, uint8_t decimals);          // 小数点以下decimals桁 (四捨五入)
+  const char* c_str() const { return buf_; }
+  uint8_t length() const { return len_; }
+};
+
+#endif
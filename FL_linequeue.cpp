@@ -0,0 +1,82 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "FL_linequeue.h"
+
+// **************************************************************************************************************
+// Class DisplayLineQueue ***************************************************************************************
+// **************************************************************************************************************
+DisplayLineQueue::DisplayLineQueue()
+    : head_(0), tail_(0), dropCount_(0), highWater_(0) {}
+
+void DisplayLineQueue::push(const char* s, uint16_t len, uint16_t color, uint64_t hlChars) {
+  if ((uint8_t)(head_ - tail_) >= LINEQSIZE) {   // 満杯
+    tail_++;                                     // 最古を捨てる
+    dropCount_++;
+  }
+  queuedLine &l = line_[head_ & LINEQMASK];
+  if (len > LINEFMTSIZE) len = LINEFMTSIZE;
+  memcpy(l.text, s, len);
+  l.len = len;
+  l.color = color;
+  l.hlChars = hlChars;
+  head_++;
+  uint8_t used = head_ - tail_;
+  if (used > highWater_) highWater_ = used;
+}
+
+const queuedLine* DisplayLineQueue::peek() {
+  if (head_ == tail_) return nullptr;
+  return &line_[tail_ & LINEQMASK];
+}
+
+void DisplayLineQueue::pop() {
+  if (head_ != tail_) tail_++;
+}
+
+void DisplayLineQueue::clear() {
+  tail_ = head_;
+}
+
+uint8_t DisplayLineQueue::count() {
+  return (uint8_t)(head_ - tail_);
+}
+
+bool DisplayLineQueue::isEmpty() {
+  return head_ == tail_;
+}
+
+// counters *****************************************************************************************************
+uint32_t DisplayLineQueue::getDropCount() {
+  return dropCount_;
+}
+
+uint8_t DisplayLineQueue::getHighWater() {
+  return highWater_;
+}
+
+void DisplayLineQueue::resetCounters() {
+  dropCount_ = 0;
+  highWater_ = count();
+}
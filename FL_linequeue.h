@@ -0,0 +1,72 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#ifndef _FL_LINEQUEUE_H_
+#define _FL_LINEQUEUE_H_
+
+#include <Arduino.h>
+#include "FL_linefmt.h"       // LINEFMTSIZE
+
+// ***** Display line queue definitions
+#define LINEQSIZE       8                   // queued lines, must be power of 2
+#define LINEQMASK       (LINEQSIZE - 1)
+
+struct queuedLine {
+  char text[LINEFMTSIZE];   // NUL終端しない (lenまで)
+  uint8_t len;
+  uint16_t color;
+  uint64_t hlChars;         // bit nが1の文字を強調表示
+};
+
+// **************************************************************************************************************
+// Class DisplayLineQueue ***************************************************************************************
+// **************************************************************************************************************
+// モニター表示行の待ち行列。postLine()が積み、loop()が1回に1行ずつ描画する
+// 描画が追いつかず満杯になったら最古の行を捨てる (スクロールで流れて行く行なので新しい行を優先)
+// 積むのも描くのもloop()だけなので割込禁止はしない
+class DisplayLineQueue {
+private:
+  queuedLine line_[LINEQSIZE];
+  uint8_t head_;                        // 書込位置
+  uint8_t tail_;                        // 読出位置
+  uint32_t dropCount_;                  // 満杯で捨てた行数
+  uint8_t highWater_;                   // 最大使用行数
+
+public:
+  DisplayLineQueue();
+
+  void push(const char* s, uint16_t len, uint16_t color, uint64_t hlChars);  // 満杯なら最古を捨てる
+  const queuedLine* peek();             // 最古の行 nullptr:空
+  void pop();                           // peek()した行を捨てる
+  void clear();                         // 未描画の行を全て破棄 (捨てた数には数えない)
+  uint8_t count();
+  bool isEmpty();
+
+  // counters
+  uint32_t getDropCount();
+  uint8_t getHighWater();
+  void resetCounters();
+};
+
+#endif
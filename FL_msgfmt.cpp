@@ -0,0 +1,75 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "FL_msgfmt.h"
+
+// timestamp prefix "sssss.mmm " for display 1 line [ms]
+void formatTimestamp(uint32_t timestamp, LineFormatter &line) {
+  uint32_t ms = timestamp / 1000;
+  line.putDec(ms / 1000);
+  line.put('.');
+  line.putDec(ms % 1000, 3, '0');
+  line.put(' ');
+}
+
+// make a string for display 1 line
+uint64_t formatMsg1line(const canMessageSet &msgSet, LineFormatter &line, uint16_t hlBytes, bool fTimestamp) {
+  uint64_t hlChars = 0;
+  line.clear();
+  if (fTimestamp) formatTimestamp(msgSet.timestamp, line);
+  line.putHex(msgSet.id, CANIDDIGIT8);
+  line.put(" Msg: ");
+  // Data列を文字列に変換
+  for (int i = 0; i < msgSet.len; i++) {
+    uint8_t pos = line.length();
+    line.putHex(msgSet.buf[i], 0);
+    if ((hlBytes >> i) & 1) {
+      for (uint8_t c = pos; c < line.length() && c < 64; c++) hlChars |= (uint64_t)1 << c;
+    }
+    line.put(' ');
+  }
+  return hlChars;
+}
+
+// make a filtered string for display 1 line
+void formatMsg1line_filtered(const canMessageSet &msgSet, LineFormatter &line, int swf_num, int64_t value,
+                             uint8_t valueLen, bool fScaled, bool fTimestamp) {
+  line.clear();
+  if (fTimestamp) formatTimestamp(msgSet.timestamp, line);
+  line.put("0x");
+  line.putHex(msgSet.id, CANIDDIGIT8);
+  line.put(" SWF");
+  line.putHex(swf_num, 0);
+  line.put(": ");
+  if (fScaled && value >= INT32_MIN && value <= INT32_MAX) {
+    line.putDec((int32_t)value);          // 物理値は10進表示
+  }
+  else if (valueLen <= 1) line.putHex((uint8_t)value, 0);
+  else if (valueLen <= 2) line.putHex((uint16_t)value, 0);
+  else if (valueLen <= 4 || (uint64_t)value >> 32 == 0) line.putHex((uint32_t)value, 0);
+  else {
+    line.putHex((uint32_t)((uint64_t)value >> 32), 0);
+    line.putHex((uint32_t)value, 8);      // 下位32bitはゼロ詰め
+  }
+}
@@ -0,0 +1,45 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#ifndef _FL_MSGFMT_H_
+#define _FL_MSGFMT_H_
+
+#include <Arduino.h>
+#include "mcp25625_can.h"     // canMessageSet
+#include "FL_linefmt.h"       // LineFormatter
+
+// ***** Monitor line format definitions
+#define CANIDDIGIT8     8     // in Hex
+
+// モニター表示1行の文字列を作る (受信frame毎に呼ぶのでLineFormatterだけでheapは使わない)
+// fTimestamp: 行の先頭に受信時刻 "sssss.mmm " を付ける (MONITOR_TIMESTAMP)
+void formatTimestamp(uint32_t timestamp, LineFormatter &line);
+// "ID Msg: D0 D1 ..." hlBytes: 強調するbyte (bit n: buf[n])
+// 戻り値: 強調するbyteの文字位置 (bit n: n文字目, 先頭64文字まで)
+uint64_t formatMsg1line(const canMessageSet &msgSet, LineFormatter &line, uint16_t hlBytes, bool fTimestamp);
+// "0xID SWFn: value" scalingありは10進、なしはvalueLen bytesの16進
+void formatMsg1line_filtered(const canMessageSet &msgSet, LineFormatter &line, int swf_num, int64_t value,
+                             uint8_t valueLen, bool fScaled, bool fTimestamp);
+
+#endif
@@ -0,0 +1,165 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "FL_pwmout.h"
+#include "wiring_private.h"   // for pinPeripheral() function
+
+#define PWMOUT_DUTYTCC  TCC0
+#define PWMOUT_FREQTCC  TCC1
+
+// PAxxのTCC割当 (TCC0 WOn -> CCn, TCC1 WO2/3 -> CC0/1)
+struct pwmPinMux {
+  uint8_t portPin;    // PORTAのbit
+  uint8_t dutyCc;     // TCC0 CC
+  uint8_t dutyMux;    // PIO_TIMER:E PIO_TIMER_ALT:F
+  uint8_t freqCc;     // TCC1 CC
+  uint8_t freqMux;
+};
+static const pwmPinMux pwmPins[] = {
+  {8,  0, PIO_TIMER,     0, PIO_TIMER_ALT},   // PA08: TCC0/WO0, TCC1/WO2
+  {9,  1, PIO_TIMER,     1, PIO_TIMER_ALT},   // PA09: TCC0/WO1, TCC1/WO3
+  {10, 2, PIO_TIMER_ALT, 0, PIO_TIMER},       // PA10: TCC0/WO2, TCC1/WO0
+  {11, 3, PIO_TIMER_ALT, 1, PIO_TIMER},       // PA11: TCC0/WO3, TCC1/WO1
+};
+#define PWMPINCOUNT     (sizeof(pwmPins) / sizeof(pwmPins[0]))
+
+// **************************************************************************************************************
+// Setup ********************************************************************************************************
+// **************************************************************************************************************
+PwmOutput::PwmOutput() : lastPer_(PWMOUT_PERMAX), dutyWave_(0), freqWave_(0), fFreqUsed_(false), writeCount_(0) {
+  memset(lastCc_, 0, sizeof(lastCc_));
+  memset(pin_, -1, sizeof(pin_));
+  memset(pinMux_, 0, sizeof(pinMux_));
+}
+
+void PwmOutput::begin() {
+  GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_TCC0_TCC1 | GCLK_CLKCTRL_GEN(PWMOUT_GCLK_GEN) | GCLK_CLKCTRL_CLKEN;
+  while (GCLK->STATUS.bit.SYNCBUSY);
+  PM->APBCMASK.reg |= PM_APBCMASK_TCC0 | PM_APBCMASK_TCC1;
+  reset();
+}
+
+static void tccReset(Tcc *tcc) {
+  tcc->CTRLA.reg = TCC_CTRLA_SWRST;
+  while (tcc->SYNCBUSY.bit.SWRST);
+}
+
+// WAVEはENABLE中に書けないので止めてから設定する。CCはSWRST後の0 (inactive) のまま
+// start()からTCC毎に1回だけ呼ぶので、動作中の他のchannelを止め直すことはない
+static void tccStart(Tcc *tcc, uint32_t wave, uint32_t per) {
+  tcc->CTRLA.bit.ENABLE = 0;
+  while (tcc->SYNCBUSY.bit.ENABLE);
+  tcc->WAVE.reg = wave;
+  while (tcc->SYNCBUSY.bit.WAVE);
+  tcc->PER.reg = per;
+  while (tcc->SYNCBUSY.bit.PER);
+  tcc->CTRLA.reg |= TCC_CTRLA_PRESCALER_DIV1 | TCC_CTRLA_ENABLE;
+  while (tcc->SYNCBUSY.bit.ENABLE);
+}
+
+void PwmOutput::reset() {
+  tccReset(PWMOUT_DUTYTCC);
+  tccReset(PWMOUT_FREQTCC);
+  dutyWave_ = TCC_WAVE_WAVEGEN_NPWM;
+  freqWave_ = TCC_WAVE_WAVEGEN_NPWM;
+  fFreqUsed_ = false;
+  memset(lastCc_, 0, sizeof(lastCc_));
+  memset(pin_, -1, sizeof(pin_));
+  lastPer_ = PWMOUT_PERMAX;
+}
+
+int8_t PwmOutput::attach(int pin, ePwmOutMode mode, bool invert) {
+  if (g_APinDescription[pin].ulPort != PORTA) return -1;
+  const pwmPinMux *mux = NULL;
+  for (unsigned i = 0; i < PWMPINCOUNT; i++) {
+    if (pwmPins[i].portPin == g_APinDescription[pin].ulPin) mux = &pwmPins[i];
+  }
+  if (mux == NULL) return -1;
+  int8_t ch;
+  if (mode == PWMOUT_DUTY) {
+    ch = mux->dutyCc;
+    if (pin_[ch] >= 0) return -1;
+    if (invert) dutyWave_ |= TCC_WAVE_POL0 << mux->dutyCc;
+    pinMux_[ch] = mux->dutyMux;
+  }
+  else {
+    if (fFreqUsed_) return -1;
+    fFreqUsed_ = true;
+    ch = PWMOUT_FREQCH + mux->freqCc;
+    if (invert) freqWave_ |= TCC_WAVE_POL0 << mux->freqCc;
+    pinMux_[ch] = mux->freqMux;
+  }
+  pin_[ch] = pin;
+  return ch;
+}
+
+void PwmOutput::start() {
+  bool duty = false, freq = false;
+  for (int ch = 0; ch < PWMOUT_CHMAX; ch++) {
+    if (pin_[ch] < 0) continue;
+    if (ch < PWMOUT_FREQCH) duty = true;
+    else freq = true;
+  }
+  if (duty) tccStart(PWMOUT_DUTYTCC, dutyWave_, PWMOUT_DUTYTOP - 1);
+  if (freq) tccStart(PWMOUT_FREQTCC, freqWave_, PWMOUT_PERMAX);
+  // TCCが動いてから (CC = 0: inactive, POL反映済み) pinを切り替える
+  for (int ch = 0; ch < PWMOUT_CHMAX; ch++) {
+    if (pin_[ch] >= 0) pinPeripheral(pin_[ch], (EPioType)pinMux_[ch]);
+  }
+}
+
+// **************************************************************************************************************
+// Update *******************************************************************************************************
+// **************************************************************************************************************
+// CCB/PERBは周期の終わりでCC/PERに移るので、出力の途中で波形が切れない
+void PwmOutput::setDuty(int8_t ch, uint32_t num, uint32_t den) {
+  if (ch < 0 || ch >= PWMOUT_FREQCH || den == 0) return;
+  uint32_t cc = (num >= den) ? PWMOUT_DUTYTOP : (uint32_t)((uint64_t)num * PWMOUT_DUTYTOP / den);
+  if (cc == lastCc_[ch]) return;
+  lastCc_[ch] = cc;
+  while (PWMOUT_DUTYTCC->SYNCBUSY.reg & (TCC_SYNCBUSY_CCB0 << ch));
+  PWMOUT_DUTYTCC->CCB[ch].reg = cc;
+  writeCount_++;
+}
+
+void PwmOutput::setFrequency(int8_t ch, uint32_t hz) {
+  if (ch < PWMOUT_FREQCH || ch >= PWMOUT_CHMAX) return;
+  uint32_t per = PWMOUT_PERMAX;
+  uint32_t cc = 0;                              // 停止: 常にinactive
+  if (hz != 0) {
+    per = PWMOUT_CLK / hz;
+    if (per > PWMOUT_PERMAX + 1) per = PWMOUT_PERMAX + 1;
+    if (per < 2) per = 2;
+    cc = per / 2;
+    per--;
+  }
+  if (per == lastPer_ && cc == lastCc_[ch]) return;
+  lastPer_ = per;
+  lastCc_[ch] = cc;
+  int n = ch - PWMOUT_FREQCH;
+  while (PWMOUT_FREQTCC->SYNCBUSY.reg & (TCC_SYNCBUSY_PERB | (TCC_SYNCBUSY_CCB0 << n)));
+  PWMOUT_FREQTCC->PERB.reg = per;
+  PWMOUT_FREQTCC->CCB[n].reg = cc;
+  writeCount_++;
+}
@@ -0,0 +1,72 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#ifndef _FL_PWMOUT_H_
+#define _FL_PWMOUT_H_
+
+#include <Arduino.h>
+
+// ***** PWM/frequency output definitions
+// CO pin (PA08-PA11) をTCCの波形出力に切り替え、duty/周波数をbuffer register (CCB/PERB) で更新する
+// TCC0: duty用 NPWM 全channel共通のcarrier PWMOUT_DUTYFREQ
+// TCC1: frequency用 NPWM duty50% PERBで周期を変える。周期は1つなのでfrequency出力は1本だけ
+// clockはtimebaseBegin()が設定するGCLK generator 5 (16MHz) を使う
+#define PWMOUT_GCLK_GEN     5
+#define PWMOUT_CLK          16000000UL
+#define PWMOUT_DUTYFREQ     1000                            // [Hz] duty modeのcarrier
+#define PWMOUT_DUTYTOP      (PWMOUT_CLK / PWMOUT_DUTYFREQ)  // 16000 counts = duty分解能
+#define PWMOUT_PERMAX       0xFFFFFF                        // TCC 24bit
+#define PWMOUT_FREQCH       4                               // attach()の戻り値 4以上: TCC1のchannel
+#define PWMOUT_CHMAX        6                               // TCC0 CC0-3 + TCC1 CC0-1
+
+enum ePwmOutMode {
+  PWMOUT_DUTY, PWMOUT_FREQ
+};
+
+class PwmOutput {
+public:
+  PwmOutput();
+  void begin();                   // timebaseBegin()の後に呼ぶ
+  void reset();                   // 両TCCを止める。pinの多重化は呼出側がpinMode()で戻す
+  // reset()の後、使うpinを全てattach()してからstart()を1回呼ぶ
+  // pinのchannelとWAVE/POLを記録する (TCCは止めたまま)。戻り値 channel, -1: TCCに出せないpin / 使用中
+  // invert: 出力を反転 (停止中の出力もHIGHになる)
+  int8_t attach(int pin, ePwmOutMode mode, bool invert);
+  void start();                   // attach()したchannelのあるTCCを1回ずつenableし、pinをTCCに接続する
+  void setDuty(int8_t ch, uint32_t num, uint32_t den);  // duty = num / den (num >= den: 100%)
+  void setFrequency(int8_t ch, uint32_t hz);             // 0: 停止 (inactive)
+  uint32_t getWriteCount() const { return writeCount_; }  // buffer registerに書いた回数
+
+private:
+  uint32_t lastCc_[PWMOUT_CHMAX];   // 同じ値は書かない (sync待ちを省く)
+  uint32_t lastPer_;                // TCC1 PER
+  uint32_t dutyWave_;               // TCC0 WAVE (POL bit)
+  uint32_t freqWave_;               // TCC1 WAVE (POL bit)
+  bool fFreqUsed_;
+  int8_t pin_[PWMOUT_CHMAX];        // attach()したpin, -1: 未使用
+  uint8_t pinMux_[PWMOUT_CHMAX];    // PIO_TIMER / PIO_TIMER_ALT
+  uint32_t writeCount_;
+};
+
+#endif
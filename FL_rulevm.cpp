@@ -0,0 +1,285 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "FL_rulevm.h"
+
+// **************************************************************************************************************
+// Class RuleProgram ********************************************************************************************
+// **************************************************************************************************************
+RuleProgram::RuleProgram() {
+  clear();
+}
+
+void RuleProgram::clear() {
+  len_ = 0;
+  inputs_ = 0;
+}
+
+bool RuleProgram::isValid() {
+  return len_ != 0;
+}
+
+uint64_t RuleProgram::getInputs() {
+  return inputs_;
+}
+
+uint8_t RuleProgram::getCodeLength() {
+  return len_;
+}
+
+bool RuleProgram::isSameCode(const RuleProgram &other) {
+  return len_ == other.len_ && memcmp(code_, other.code_, len_) == 0;
+}
+
+// compile ******************************************************************************************************
+int RuleProgram::compile(const char* text, uint8_t swfCount) {
+  clear();
+  src_ = text;
+  pos_ = 0;
+  depth_ = 0;
+  nest_ = 0;
+  swfCount_ = (swfCount > RULESWFMAX) ? RULESWFMAX : swfCount;
+  error_ = false;
+  skipSpace();
+  if (src_[pos_] == '\0') return 0;             // ruleなし
+  parseExpr();
+  skipSpace();
+  if (!error_ && src_[pos_] != '\0') error_ = true;   // 余分な文字
+  if (!error_ && inputs_ == 0) {                // 定数だけのruleは常に同じ結果になる
+    error_ = true;
+    pos_ = 0;
+  }
+  emit(RULEOP_END);
+  if (error_) {
+    int errPos = pos_ + 1;
+    clear();
+    return errPos;
+  }
+  return 0;
+}
+
+void RuleProgram::skipSpace() {
+  while (src_[pos_] == ' ' || src_[pos_] == '\t') pos_++;
+}
+
+bool RuleProgram::emit(uint8_t b) {
+  if (len_ >= RULECODESIZE) {
+    error_ = true;
+    return false;
+  }
+  code_[len_++] = b;
+  return true;
+}
+
+void RuleProgram::push() {
+  if (++depth_ > RULESTACKSIZE) error_ = true;
+}
+
+void RuleProgram::pop(uint8_t n) {
+  depth_ -= n;
+}
+
+// expr := term (| term)*
+void RuleProgram::parseExpr() {
+  parseTerm();
+  for (;;) {
+    if (error_) return;
+    skipSpace();
+    if (src_[pos_] != '|') return;
+    pos_++;
+    if (src_[pos_] == '|') pos_++;
+    parseTerm();
+    emit(RULEOP_OR);
+    pop(1);
+  }
+}
+
+// term := factor (& factor)*
+void RuleProgram::parseTerm() {
+  parseFactor();
+  for (;;) {
+    if (error_) return;
+    skipSpace();
+    if (src_[pos_] != '&') return;
+    pos_++;
+    if (src_[pos_] == '&') pos_++;
+    parseFactor();
+    emit(RULEOP_AND);
+    pop(1);
+  }
+}
+
+// factor := compare | !factor | ( expr )
+void RuleProgram::parseFactor() {
+  if (error_) return;
+  skipSpace();
+  char c = src_[pos_];
+  if (c == '!' || c == '(') {
+    if (++nest_ > RULENESTMAX) {
+      error_ = true;
+      return;
+    }
+    pos_++;
+    if (c == '!') {
+      parseFactor();
+      emit(RULEOP_NOT);
+    }
+    else {
+      parseExpr();
+      skipSpace();
+      if (!error_ && src_[pos_] != ')') error_ = true;
+      if (!error_) pos_++;
+    }
+    nest_--;
+  }
+  else {
+    parseOperand();
+    if (error_) return;
+    skipSpace();
+    uint8_t op;
+    char c0 = src_[pos_], c1 = src_[pos_ + 1];
+    if (c0 == '>' && c1 == '=') op = RULEOP_GE;
+    else if (c0 == '<' && c1 == '=') op = RULEOP_LE;
+    else if (c0 == '=' && c1 == '=') op = RULEOP_EQ;
+    else if (c0 == '!' && c1 == '=') op = RULEOP_NE;
+    else if (c0 == '>') op = RULEOP_GT;
+    else if (c0 == '<') op = RULEOP_LT;
+    else {
+      error_ = true;
+      return;
+    }
+    pos_ += (c1 == '=') ? 2 : 1;
+    parseOperand();
+    emit(op);
+    pop(1);
+  }
+}
+
+// operand := Snn (10進のみ) | [-]整数 (0xは16進)
+void RuleProgram::parseOperand() {
+  if (error_) return;
+  skipSpace();
+  int32_t v;
+  if (src_[pos_] == 'S' || src_[pos_] == 's') {
+    pos_++;
+    uint8_t digits = 0;
+    v = 0;
+    while (src_[pos_] >= '0' && src_[pos_] <= '9') {
+      v = v * 10 + (src_[pos_] - '0');
+      if (v >= swfCount_) {
+        error_ = true;
+        return;
+      }
+      digits++;
+      pos_++;
+    }
+    if (digits == 0) {
+      error_ = true;
+      return;
+    }
+    emit(RULEOP_SWF);
+    emit((uint8_t)v);
+    inputs_ |= (uint64_t)1 << v;
+  }
+  else {
+    if (!parseNumber(v)) {
+      error_ = true;
+      return;
+    }
+    if (v >= INT8_MIN && v <= INT8_MAX) {
+      emit(RULEOP_CONST8);
+      emit((uint8_t)v);
+    }
+    else {
+      emit(RULEOP_CONST32);
+      for (int i = 0; i < 4; i++) emit((uint8_t)((uint32_t)v >> (8 * i)));
+    }
+  }
+  push();
+}
+
+// int32の範囲の10進/16進(0x)
+bool RuleProgram::parseNumber(int32_t &v) {
+  bool neg = false;
+  if (src_[pos_] == '-') {
+    neg = true;
+    pos_++;
+  }
+  uint8_t base = 10;
+  if (src_[pos_] == '0' && (src_[pos_ + 1] == 'x' || src_[pos_ + 1] == 'X')) {
+    base = 16;
+    pos_ += 2;
+  }
+  int64_t n = 0;
+  uint8_t digits = 0;
+  for (;;) {
+    char c = src_[pos_];
+    int d;
+    if (c >= '0' && c <= '9') d = c - '0';
+    else if (base == 16 && c >= 'a' && c <= 'f') d = c - 'a' + 10;
+    else if (base == 16 && c >= 'A' && c <= 'F') d = c - 'A' + 10;
+    else break;
+    n = n * base + d;
+    if (n > (int64_t)INT32_MAX + 1) return false;
+    digits++;
+    pos_++;
+  }
+  if (digits == 0) return false;
+  if (neg) n = -n;
+  if (n > INT32_MAX) return false;
+  v = (int32_t)n;
+  return true;
+}
+
+// eval *********************************************************************************************************
+// compile済みのbytecodeはstackの過不足がないことを確認済み
+bool RuleProgram::eval(const int64_t* values) {
+  if (len_ == 0) return false;
+  int64_t stack[RULESTACKSIZE];
+  int8_t sp = -1;                 // stack top
+  const uint8_t* pc = code_;
+  for (;;) {
+    switch (*pc++) {
+      case RULEOP_SWF:     stack[++sp] = values[*pc++];                      break;
+      case RULEOP_CONST8:  stack[++sp] = (int8_t)*pc++;                      break;
+      case RULEOP_CONST32:
+        stack[++sp] = (int32_t)((uint32_t)pc[0] | ((uint32_t)pc[1] << 8) |
+                                ((uint32_t)pc[2] << 16) | ((uint32_t)pc[3] << 24));
+        pc += 4;
+        break;
+      case RULEOP_GT:  sp--; stack[sp] = stack[sp] >  stack[sp + 1];          break;
+      case RULEOP_GE:  sp--; stack[sp] = stack[sp] >= stack[sp + 1];          break;
+      case RULEOP_LT:  sp--; stack[sp] = stack[sp] <  stack[sp + 1];          break;
+      case RULEOP_LE:  sp--; stack[sp] = stack[sp] <= stack[sp + 1];          break;
+      case RULEOP_EQ:  sp--; stack[sp] = stack[sp] == stack[sp + 1];          break;
+      case RULEOP_NE:  sp--; stack[sp] = stack[sp] != stack[sp + 1];          break;
+      case RULEOP_AND: sp--; stack[sp] = stack[sp] && stack[sp + 1];          break;
+      case RULEOP_OR:  sp--; stack[sp] = stack[sp] || stack[sp + 1];          break;
+      case RULEOP_NOT: stack[sp] = !stack[sp];                                break;
+      case RULEOP_END:
+      default:
+        return sp >= 0 && stack[sp] != 0;
+    }
+  }
+}
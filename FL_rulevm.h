@@ -0,0 +1,95 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#ifndef _FL_RULEVM_H_
+#define _FL_RULEVM_H_
+
+#include <Arduino.h>
+
+// ***** Comparator rule definitions
+#define RULECODESIZE    96      // bytecode bytes per rule
+#define RULESTACKSIZE   8       // VM stack depth
+#define RULESWFMAX      64      // SWF number 0-63 (inputs is a 64bit mask)
+#define RULENESTMAX     8       // ( と ! の入れ子の最大数 (比較式自体は数えない)
+
+// bytecode
+enum eRuleOp {
+  RULEOP_END,                   // 結果 = stack top != 0
+  RULEOP_SWF,                   // +1byte SWF number: push value[n]
+  RULEOP_CONST8,                // +1byte int8: push
+  RULEOP_CONST32,               // +4bytes int32 (little endian): push
+  RULEOP_GT, RULEOP_GE, RULEOP_LT, RULEOP_LE, RULEOP_EQ, RULEOP_NE,   // pop b, a: push a op b
+  RULEOP_AND, RULEOP_OR,        // pop b, a: push a op b
+  RULEOP_NOT                    // stack top = !stack top
+};
+
+// **************************************************************************************************************
+// Class RuleProgram ********************************************************************************************
+// **************************************************************************************************************
+// CO出力の複合条件。テキストを設定変更時にbytecodeへcompileし、フレーム毎にstack VMで評価する
+// 文法 (優先順位の高い順):
+//   operand := Snn (SWFnnの値, 10進) | [-]整数 (int32)
+//   compare := operand (> | >= | < | <= | == | !=) operand
+//   factor  := compare | !factor | ( expr )
+//   term    := factor (& factor)*     '&&'も可
+//   expr    := term (| term)*         '||'も可
+// 例: (S1 > 3000 & S2 == 5) | S3 > 105
+// Snnを1つも含まないrule (定数同士の比較だけ) はエラー
+// 評価は短絡しないので、実行時間は値に依らずbytecode長で決まる
+class RuleProgram {
+private:
+  uint8_t code_[RULECODESIZE];
+  uint8_t len_;                 // 0:ruleなし
+  uint64_t inputs_;             // bit n: SWFnを参照する
+  // compile state
+  const char* src_;
+  uint8_t pos_;
+  uint8_t depth_;               // stack深さ
+  uint8_t nest_;                // ( と ! の入れ子の深さ
+  uint8_t swfCount_;
+  bool error_;
+
+  void skipSpace();
+  bool emit(uint8_t b);
+  void push();
+  void pop(uint8_t n);
+  void parseExpr();
+  void parseTerm();
+  void parseFactor();
+  void parseOperand();
+  bool parseNumber(int32_t &v);
+
+public:
+  RuleProgram();
+  // 0:OK(空文字列はruleなし) n:n文字目でエラー
+  int compile(const char* text, uint8_t swfCount);
+  void clear();
+  bool isValid();
+  bool eval(const int64_t* values);     // values: SWF毎の最新値
+  uint64_t getInputs();
+  uint8_t getCodeLength();
+  bool isSameCode(const RuleProgram &other);    // compile結果(bytecode)が同じ
+};
+
+#endif
@@ -0,0 +1,109 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "FL_swfplan.h"
+
+// **************************************************************************************************************
+// Layout *******************************************************************************************************
+// **************************************************************************************************************
+// Motorola: byte0がbit63-56, Intel: byte7がbit63-56
+uint8_t swfBitPos(bool intel, uint8_t bytePos, uint8_t bitPos) {
+  return (intel ? bytePos : 7 - bytePos) * 8 + bitPos;
+}
+
+// Motorola: StartByte <= EndByte, Intel: StartByte >= EndByte
+bool swfFieldLen(const SoftwareFilter &swf, uint8_t *byteLen, uint8_t *bitLen) {
+  bool intel = swf.byteOrder == SWFBO_INTEL;
+  uint8_t msbPos = swfBitPos(intel, swf.startByte, swf.startBit);
+  uint8_t lsbPos = swfBitPos(intel, swf.endByte, swf.endBit);
+  if (msbPos < lsbPos) return false;
+  uint8_t bitl = msbPos - lsbPos + 1;
+  uint8_t bytl = ((bitl - 1) >> 3) + 1;
+  if (bytl > 4) bytl = 8;
+  else if (bytl > 2) bytl = 4;
+  *byteLen = bytl;
+  *bitLen = bitl;
+  return true;
+}
+
+// **************************************************************************************************************
+// Scaling ******************************************************************************************************
+// **************************************************************************************************************
+bool swfIsScaled(const SoftwareFilter &swf) {
+  return swf.factorDiv != 0 && (swf.factorMul != swf.factorDiv || swf.offset != 0);
+}
+
+// factorMul / factorDivを固定小数点 scaleMul / 2^scaleShift にする
+// scaleMul < 2^30 の範囲でshiftを最大(62まで)にして、factorの相対誤差を2^-30程度に抑える
+// mul << (sh + 1) は 2^31 * div 未満で止まるのでoverflowしない
+void compileSwfScale(canSoftwareFilterPlan &plan, const SoftwareFilter &swf) {
+  plan.scaled = swfIsScaled(swf);
+  plan.scaleMul = 1;
+  plan.scaleShift = 0;
+  plan.scaleOffset = 0;
+  if (!plan.scaled) return;
+  uint32_t mul = swf.factorMul;
+  uint32_t div = swf.factorDiv;
+  uint8_t sh = 0;
+  while (sh < 62 && (((uint64_t)mul << (sh + 1)) + div / 2) / div < ((uint64_t)1 << 30)) sh++;
+  plan.scaleMul = (int32_t)((((uint64_t)mul << sh) + div / 2) / div);
+  plan.scaleShift = sh;
+  plan.scaleOffset = swf.offset;
+}
+
+// **************************************************************************************************************
+// Plan *********************************************************************************************************
+// **************************************************************************************************************
+bool compileSwfPlan(canSoftwareFilterPlan &plan, const SoftwareFilter &swf, uint8_t swfNum, uint8_t *valueLen) {
+  uint8_t byteLen, bitLen;
+  if (!swfFieldLen(swf, &byteLen, &bitLen)) return false;
+  bool intel = swf.byteOrder == SWFBO_INTEL;
+  plan.id = swf.canID;
+  plan.shift = swfBitPos(intel, swf.endByte, swf.endBit);
+  plan.intel = intel;
+  plan.mask = (bitLen >= 64) ? ~(uint64_t)0 : (((uint64_t)1 << bitLen) - 1);
+  plan.signShift = swf.sign ? 64 - bitLen : 0;
+  plan.swfNum = swfNum;
+  // multiplexor (SWFと同じbyte order)
+  plan.muxMask = 0;
+  plan.muxShift = 0;
+  plan.muxValue = 0;
+  if (swf.muxLen != 0) {
+    if (swf.muxLen > SWFMUXLENMAX) return false;
+    plan.muxShift = swfBitPos(intel, swf.muxEndByte, swf.muxEndBit);
+    if (plan.muxShift + swf.muxLen > 64) return false;
+    plan.muxMask = (uint16_t)(((uint32_t)1 << swf.muxLen) - 1);
+    plan.muxValue = swf.muxValue & plan.muxMask;
+  }
+  compileSwfScale(plan, swf);
+  *valueLen = byteLen;
+  if (plan.scaled) {    // 物理値の範囲がint32に収まればAUXへは4bytesで出力
+    int64_t rawMax = (bitLen >= 64) ? INT64_MAX : (int64_t)(plan.mask >> (plan.signShift ? 1 : 0));
+    int64_t rawMin = plan.signShift ? -rawMax - 1 : 0;
+    int64_t v0 = scaleSwfValue(rawMin, plan), v1 = scaleSwfValue(rawMax, plan);
+    bool fits32 = v0 >= INT32_MIN && v0 <= INT32_MAX && v1 >= INT32_MIN && v1 <= INT32_MAX;
+    *valueLen = fits32 ? 4 : 8;
+  }
+  return true;
+}
@@ -0,0 +1,161 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#ifndef _FL_SWFPLAN_H_
+#define _FL_SWFPLAN_H_
+
+#include <Arduino.h>
+
+// ***** Software filter extraction definitions
+// SWF byte order
+#define SWFBO_MOTOROLA  0       // big endian: StartByte <= EndByte
+#define SWFBO_INTEL     1       // little endian: StartByte >= EndByte
+#define SWFMUXLENMAX    16      // multiplexor max bit length
+
+typedef uint64_t swfMask_t;     // bit n: SWFn
+#define SWFMASKBIT(n)   ((swfMask_t)1 << (n))
+
+// 設定データ格納構造体 (DeviceSettingsに並ぶ)
+// SWFはSWFCOUNT個並ぶのでbit fieldで詰める
+struct SoftwareFilter {
+  uint32_t canID : 29;
+  uint32_t onoff : 1;
+  uint32_t sign : 1;
+  uint32_t : 1;
+  uint16_t startByte : 3;
+  uint16_t startBit : 3;
+  uint16_t endByte : 3;
+  uint16_t endBit : 3;
+  uint16_t byteOrder : 1;   // SWFBO_xxx
+  uint16_t : 3;
+  // 物理値 = raw * factorMul / factorDiv + offset (factorMul == factorDivかつoffset == 0でscalingなし)
+  uint16_t factorMul;
+  uint16_t factorDiv;
+  // multiplexor: muxLen != 0 のとき、SWFと同じbyte orderで切り出したmux値がmuxValueの時だけ抽出
+  uint16_t muxEndByte : 3;
+  uint16_t muxEndBit : 3;
+  uint16_t muxLen : 5;      // 0:mux off, 1-16[bits]
+  uint16_t : 5;
+  uint16_t muxValue;
+  int32_t offset;
+};
+
+// CAN Software filter extraction plan (設定変更時にcompileSwfPlan()で作成)
+// msg data 8bytesを64bitとして読み、Motorolaはbyte swap後、(data >> shift) & mask で切り出す
+// SWFCOUNT個並ぶので大きいmemberから並べてpaddingを無くす (32 bytes)
+struct canSoftwareFilterPlan {
+  uint64_t mask;        // bit mask after shift
+  uint32_t id;          // filtering CAN ID
+  int32_t scaleMul;     // factorMul / factorDiv の固定小数点値
+  int32_t scaleOffset;
+  uint16_t muxMask;     // multiplexor: (data >> muxShift) & muxMask == muxValue の時だけ抽出, 0:mux off
+  uint16_t muxValue;
+  uint8_t shift;        // right shift count = LSB position of the field
+  uint8_t signShift;    // 符号拡張用 64 - bit length, 0:unsigned
+  uint8_t intel;        // 1:Intel(little endian) 0:Motorola(big endian)
+  uint8_t scaled;       // 1:scalingあり
+  uint8_t scaleShift;   // 物理値 = (raw * scaleMul) >> scaleShift + scaleOffset (0-62)
+  uint8_t muxShift;
+  uint8_t swfNum;       // SWF number 0-(SWFCOUNT-1)
+};
+
+// SWFのbyte/bit位置をmsg data 64bit値のbit位置に変換
+// Motorola: big endianで読んだ64bit値, Intel: little endianで読んだ64bit値
+uint8_t swfBitPos(bool intel, uint8_t bytePos, uint8_t bitPos);
+// Start(MSB)からEnd(LSB)までのbyte長(1,2,4,8)とbit長。位置エラーならfalse (byteLen/bitLenは変えない)
+bool swfFieldLen(const SoftwareFilter &swf, uint8_t *byteLen, uint8_t *bitLen);
+// factor/offsetが物理値変換をするか
+bool swfIsScaled(const SoftwareFilter &swf);
+// factor/offsetをplanの固定小数点scaleにする
+void compileSwfScale(canSoftwareFilterPlan &plan, const SoftwareFilter &swf);
+// SWF設定から抽出planを作る。valueLen: 値のbyte長 (scalingありは物理値が収まる4 or 8)
+// 位置/mux位置エラーならfalse
+bool compileSwfPlan(canSoftwareFilterPlan &plan, const SoftwareFilter &swf, uint8_t swfNum, uint8_t *valueLen);
+
+// 演算数の計測hook: host test (test_comparator) がcritical COの最悪実行時間のmodelを作るために定義する
+// targetでは何もしない。M0+は64bit演算を持たないので、libgccを呼ぶ乗算/可変shiftを分けて数える
+#define SWFOP_MUL64     0       // 64bit乗算 (__aeabi_lmul, overflow判定付きを含む)
+#define SWFOP_SHIFT64   1       // 64bit可変shift (__aeabi_llsl/llsr/lasr)
+#define SWFOP_ALU64     2       // 64bit加減算/比較/論理演算/byte swap (inline)
+#define SWFOP_CO        3       // critical CO 1個分の分岐/load/store/PORT書込/timebase読出
+#define SWFOPKINDS      4
+#ifndef SWFOPCOUNT
+#define SWFOPCOUNT(kind, n)
+#endif
+
+// 以下は受信毎(ISRを含む)に呼ぶのでinline
+// CAN msg data 8bytesをlittle endianの64bitとして読む (SAMD21 is little endian)
+// CAN msg: [byte0][byte1]...[byte7] -> bit7..0 = byte0, bit63..56 = byte7
+static inline uint64_t loadMsgData64(const uint8_t *data) {
+  uint64_t v;
+  memcpy(&v, data, sizeof(v));      // bufは非alignedなのでmemcpyで読む
+  return v;
+}
+
+// 物理値 = raw * scaleMul / 2^scaleShift + scaleOffset (四捨五入, int64を超える値はINT64_MIN/MAXに飽和)
+// rawを上下32bitに分け、raw * scaleMul = hiM * 2^32 + loM として積がint64をoverflowしないようにする
+// scaleShift > 32 (factor < 1/4程度): raw * scaleMul / 2^32 の整数部から丸めるだけ (overflowしない)
+// scaleShift <= 32: (hiM + carry) * 2^k + rem (k = 32 - scaleShift, 0 <= rem < 2^k) と組み直し、
+//                   overflowは (hiM + carry) * 2^k の1回の乗算だけで判定する
+static inline int64_t scaleSwfValue(int64_t raw, const canSoftwareFilterPlan &plan) {
+  int64_t hiM = (raw >> 32) * plan.scaleMul;              // signed upper 32bits * mul, |hiM| < 2^61
+  int64_t loM = (int64_t)(uint32_t)raw * plan.scaleMul;   // unsigned lower 32bits * mul, 0 <= loM < 2^62
+  SWFOPCOUNT(SWFOP_MUL64, 2);
+  int64_t value;
+  if (plan.scaleShift > 32) {
+    uint8_t k = plan.scaleShift - 32;
+    value = (hiM + (loM >> 32) + (((int64_t)1 << k) >> 1)) >> k;
+    SWFOPCOUNT(SWFOP_SHIFT64, 2);
+    SWFOPCOUNT(SWFOP_ALU64, 2);
+  }
+  else {
+    uint8_t k = 32 - plan.scaleShift;
+    int64_t loPart = (loM + (((int64_t)1 << plan.scaleShift) >> 1)) >> plan.scaleShift;  // <= scaleMul * 2^k
+    int64_t upper = hiM + (loPart >> k);                  // |upper| < 2^62
+    SWFOPCOUNT(SWFOP_SHIFT64, 3);
+    SWFOPCOUNT(SWFOP_ALU64, 2);
+    SWFOPCOUNT(SWFOP_MUL64, 1);
+    if (__builtin_mul_overflow(upper, (int64_t)1 << k, &value)) return (upper < 0) ? INT64_MIN : INT64_MAX;
+    value += loPart & (((int64_t)1 << k) - 1);
+    SWFOPCOUNT(SWFOP_SHIFT64, 2);
+    SWFOPCOUNT(SWFOP_ALU64, 3);
+  }
+  SWFOPCOUNT(SWFOP_ALU64, 1);
+  if (__builtin_add_overflow(value, (int64_t)plan.scaleOffset, &value)) {
+    return (plan.scaleOffset < 0) ? INT64_MIN : INT64_MAX;
+  }
+  return value;
+}
+
+// planのfieldを切り出す (signedは最上位bitを符号として拡張、scalingありは物理値)
+// data[SWFBO_INTEL]: msg dataそのまま data[SWFBO_MOTOROLA]: byte swap
+static inline int64_t extractSwfValue(const canSoftwareFilterPlan &plan, const uint64_t *data) {
+  uint64_t field = (data[plan.intel] >> plan.shift) & plan.mask;
+  int64_t raw = (int64_t)(field << plan.signShift) >> plan.signShift;
+  SWFOPCOUNT(SWFOP_SHIFT64, 3);
+  SWFOPCOUNT(SWFOP_ALU64, 1);
+  return plan.scaled ? scaleSwfValue(raw, plan) : raw;
+}
+
+#endif
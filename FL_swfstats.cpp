@@ -0,0 +1,126 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+
+#include "FL_swfstats.h"
+
+// **************************************************************************************************************
+// Class SignalStats ********************************************************************************************
+// **************************************************************************************************************
+SignalStats::SignalStats() {
+  reset();
+}
+
+void SignalStats::reset() {
+  count_ = 0;
+  min_ = 0;
+  max_ = 0;
+  base_ = 0;
+  sumHi_ = 0;
+  sumLo_ = 0;
+  sqHi_ = 0;
+  sqMid_ = 0;
+  sqLo_ = 0;
+  lastTime_ = 0;
+  elapsed_ = 0;
+}
+
+void SignalStats::update(int64_t value, uint32_t timestamp) {
+  if (count_ == 0) {                            // 最初のsampleを基準値にする
+    count_ = 1;
+    min_ = max_ = base_ = value;
+    lastTime_ = timestamp;
+    return;
+  }
+  if (value < min_) min_ = value;
+  if (value > max_) max_ = value;
+  if (count_ == 0xFFFFFFFFUL) return;           // 積算の上限
+  // |x - base_| < 2^64 はuint64の差で正確に求まる
+  bool neg = value < base_;
+  uint64_t ad = neg ? (uint64_t)base_ - (uint64_t)value : (uint64_t)value - (uint64_t)base_;
+  uint64_t lo = sumLo_;
+  if (neg) {
+    sumLo_ -= ad;
+    if (sumLo_ > lo) sumHi_--;                  // borrow
+  }
+  else {
+    sumLo_ += ad;
+    if (sumLo_ < lo) sumHi_++;                  // carry
+  }
+  // ad^2 (128bit) を加える。通常の信号は32bit以内なので64bit乗算1回で済む
+  uint64_t sqLo, sqMid;
+  if ((ad >> 32) == 0) {
+    sqLo = ad * ad;
+    sqMid = 0;
+  }
+  else {
+    uint64_t a0 = (uint32_t)ad, a1 = ad >> 32;
+    uint64_t cross = a0 * a1;                   // 2 * a0 * a1 は65bitになり得る
+    sqLo = a0 * a0;
+    sqMid = a1 * a1 + (cross >> 31);
+    uint64_t crossLo = cross << 33;
+    sqLo += crossLo;
+    if (sqLo < crossLo) sqMid++;
+  }
+  sqLo_ += sqLo;
+  if (sqLo_ < sqLo) sqMid++;                    // ad^2の上位は最大2^64 - 2なので溢れない
+  sqMid_ += sqMid;
+  if (sqMid_ < sqMid) sqHi_++;
+  elapsed_ += (uint32_t)(timestamp - lastTime_); // timebaseの一周を跨いでも差分は正しい
+  lastTime_ = timestamp;
+  count_++;
+}
+
+uint32_t SignalStats::getCount() {
+  return count_;
+}
+
+int64_t SignalStats::getMin() {
+  return min_;
+}
+
+int64_t SignalStats::getMax() {
+  return max_;
+}
+
+#define TWO64   18446744073709551616.0          // 2^64
+
+double SignalStats::getMean() {
+  if (count_ == 0) return 0;
+  double s = (double)sumHi_ * TWO64 + (double)sumLo_;
+  return (double)base_ + s / count_;
+}
+
+double SignalStats::getVariance() {
+  if (count_ < 2) return 0;
+  double s = (double)sumHi_ * TWO64 + (double)sumLo_;
+  double sq = ((double)sqHi_ * TWO64 + (double)sqMid_) * TWO64 + (double)sqLo_;
+  double var = (sq - s * s / count_) / (count_ - 1);
+  return (var < 0) ? 0 : var;                   // 丸め誤差で負にしない
+}
+
+double SignalStats::getRate() {
+  if (count_ < 2 || elapsed_ == 0) return 0;
+  return (double)(count_ - 1) * 1000000.0 / (double)elapsed_;
+}
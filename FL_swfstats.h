@@ -0,0 +1,67 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+
+#ifndef _FL_SWFSTATS_H_
+#define _FL_SWFSTATS_H_
+
+#include <Arduino.h>
+
+// **************************************************************************************************************
+// Class SignalStats ********************************************************************************************
+// **************************************************************************************************************
+// 1信号(SWF)の逐次統計 min/max/count/mean/variance/rate
+// update()は整数演算のみのO(1)。最初のsampleを基準値とした差の和と二乗和を積算し(shifted data)、
+// mean/varianceは読出時にdoubleで計算する。M0+にFPUがないのでWelfordの逐次除算はしない
+// 差は最大65bit、二乗は128bitになるので、和は128bit(hi/lo)、二乗和は160bit(hi/mid/lo)で持つ
+// int64の全範囲のsampleを2^32-1個まで積算しても溢れない (それ以降のsampleは積算しない)
+// update()/reset()/getterはloop()からのみ呼ぶ
+class SignalStats {
+private:
+  // SWFCOUNT個並ぶので64bit memberを先に並べてpaddingを減らす (88 -> 80 bytes)
+  int64_t min_, max_;
+  int64_t base_;          // 最初のsample
+  int64_t sumHi_;         // Σ(x - base_) 上位64bit (符号付き)
+  uint64_t sumLo_;        // Σ(x - base_) 下位64bit
+  uint64_t sqMid_;        // Σ(x - base_)^2 bit127-64
+  uint64_t sqLo_;         // Σ(x - base_)^2 bit63-0
+  uint64_t elapsed_;      // 最初から最後のsampleまでの時間 [us]
+  uint32_t sqHi_;         // Σ(x - base_)^2 bit159-128
+  uint32_t count_;        // sample数
+  uint32_t lastTime_;     // 最後のsampleの受信時刻 [us]
+
+public:
+  SignalStats();
+  void update(int64_t value, uint32_t timestamp);  // timestamp: 受信時刻 [us]
+  void reset();
+
+  uint32_t getCount();
+  int64_t getMin();
+  int64_t getMax();
+  double getMean();
+  double getVariance();   // 不偏分散 count < 2 では0
+  double getRate();       // [samples/s] count < 2 では0
+};
+
+#endif
@@ -0,0 +1,126 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "FL_tftline.h"
+
+// Adafruit_GFX glcdfont.c の 0x20-0x7E (列毎に5byte, bit0が最上段)
+static const uint8_t glyph5x8[][5] = {
+  {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5F, 0x00, 0x00}, {0x00, 0x07, 0x00, 0x07, 0x00}, // ' ' ! "
+  {0x14, 0x7F, 0x14, 0x7F, 0x14}, {0x24, 0x2A, 0x7F, 0x2A, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62}, // # $ %
+  {0x36, 0x49, 0x56, 0x20, 0x50}, {0x00, 0x08, 0x07, 0x03, 0x00}, {0x00, 0x1C, 0x22, 0x41, 0x00}, // & ' (
+  {0x00, 0x41, 0x22, 0x1C, 0x00}, {0x2A, 0x1C, 0x7F, 0x1C, 0x2A}, {0x08, 0x08, 0x3E, 0x08, 0x08}, // ) * +
+  {0x00, 0x80, 0x70, 0x30, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08}, {0x00, 0x00, 0x60, 0x60, 0x00}, // , - .
+  {0x20, 0x10, 0x08, 0x04, 0x02}, {0x3E, 0x51, 0x49, 0x45, 0x3E}, {0x00, 0x42, 0x7F, 0x40, 0x00}, // / 0 1
+  {0x72, 0x49, 0x49, 0x49, 0x46}, {0x21, 0x41, 0x49, 0x4D, 0x33}, {0x18, 0x14, 0x12, 0x7F, 0x10}, // 2 3 4
+  {0x27, 0x45, 0x45, 0x45, 0x39}, {0x3C, 0x4A, 0x49, 0x49, 0x31}, {0x41, 0x21, 0x11, 0x09, 0x07}, // 5 6 7
+  {0x36, 0x49, 0x49, 0x49, 0x36}, {0x46, 0x49, 0x49, 0x29, 0x1E}, {0x00, 0x00, 0x14, 0x00, 0x00}, // 8 9 :
+  {0x00, 0x40, 0x34, 0x00, 0x00}, {0x00, 0x08, 0x14, 0x22, 0x41}, {0x14, 0x14, 0x14, 0x14, 0x14}, // ; < =
+  {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x59, 0x09, 0x06}, {0x3E, 0x41, 0x5D, 0x59, 0x4E}, // > ? @
+  {0x7C, 0x12, 0x11, 0x12, 0x7C}, {0x7F, 0x49, 0x49, 0x49, 0x36}, {0x3E, 0x41, 0x41, 0x41, 0x22}, // A B C
+  {0x7F, 0x41, 0x41, 0x41, 0x3E}, {0x7F, 0x49, 0x49, 0x49, 0x41}, {0x7F, 0x09, 0x09, 0x09, 0x01}, // D E F
+  {0x3E, 0x41, 0x41, 0x51, 0x73}, {0x7F, 0x08, 0x08, 0x08, 0x7F}, {0x00, 0x41, 0x7F, 0x41, 0x00}, // G H I
+  {0x20, 0x40, 0x41, 0x3F, 0x01}, {0x7F, 0x08, 0x14, 0x22, 0x41}, {0x7F, 0x40, 0x40, 0x40, 0x40}, // J K L
+  {0x7F, 0x02, 0x1C, 0x02, 0x7F}, {0x7F, 0x04, 0x08, 0x10, 0x7F}, {0x3E, 0x41, 0x41, 0x41, 0x3E}, // M N O
+  {0x7F, 0x09, 0x09, 0x09, 0x06}, {0x3E, 0x41, 0x51, 0x21, 0x5E}, {0x7F, 0x09, 0x19, 0x29, 0x46}, // P Q R
+  {0x26, 0x49, 0x49, 0x49, 0x32}, {0x03, 0x01, 0x7F, 0x01, 0x03}, {0x3F, 0x40, 0x40, 0x40, 0x3F}, // S T U
+  {0x1F, 0x20, 0x40, 0x20, 0x1F}, {0x3F, 0x40, 0x38, 0x40, 0x3F}, {0x63, 0x14, 0x08, 0x14, 0x63}, // V W X
+  {0x03, 0x04, 0x78, 0x04, 0x03}, {0x61, 0x59, 0x49, 0x4D, 0x43}, {0x00, 0x7F, 0x41, 0x41, 0x41}, // Y Z [
+  {0x02, 0x04, 0x08, 0x10, 0x20}, {0x00, 0x41, 0x41, 0x41, 0x7F}, {0x04, 0x02, 0x01, 0x02, 0x04}, // \ ] ^
+  {0x40, 0x40, 0x40, 0x40, 0x40}, {0x00, 0x03, 0x07, 0x08, 0x00}, {0x20, 0x54, 0x54, 0x78, 0x40}, // _ ` a
+  {0x7F, 0x28, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x28}, {0x38, 0x44, 0x44, 0x28, 0x7F}, // b c d
+  {0x38, 0x54, 0x54, 0x54, 0x18}, {0x00, 0x08, 0x7E, 0x09, 0x02}, {0x18, 0xA4, 0xA4, 0x9C, 0x78}, // e f g
+  {0x7F, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7D, 0x40, 0x00}, {0x20, 0x40, 0x40, 0x3D, 0x00}, // h i j
+  {0x7F, 0x10, 0x28, 0x44, 0x00}, {0x00, 0x41, 0x7F, 0x40, 0x00}, {0x7C, 0x04, 0x78, 0x04, 0x78}, // k l m
+  {0x7C, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38}, {0xFC, 0x18, 0x24, 0x24, 0x18}, // n o p
+  {0x18, 0x24, 0x24, 0x18, 0xFC}, {0x7C, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x24}, // q r s
+  {0x04, 0x04, 0x3F, 0x44, 0x24}, {0x3C, 0x40, 0x40, 0x20, 0x7C}, {0x1C, 0x20, 0x40, 0x20, 0x1C}, // t u v
+  {0x3C, 0x40, 0x30, 0x40, 0x3C}, {0x44, 0x28, 0x10, 0x28, 0x44}, {0x4C, 0x90, 0x90, 0x90, 0x7C}, // w x y
+  {0x44, 0x64, 0x54, 0x4C, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00}, {0x00, 0x00, 0x77, 0x00, 0x00}, // z { |
+  {0x00, 0x41, 0x36, 0x08, 0x00}, {0x02, 0x01, 0x02, 0x04, 0x02},                                 // } ~
+};
+#define GLYPHFIRST  0x20
+#define GLYPHLAST   0x7E
+
+// SPIは上位byteから送るのでbyteを入れ替えておく
+static inline uint16_t spiOrder565(uint16_t color) {
+  return (uint16_t)((color >> 8) | (color << 8));
+}
+
+// **************************************************************************************************************
+// Class TftLineRenderer ****************************************************************************************
+// **************************************************************************************************************
+TftLineRenderer::TftLineRenderer(Adafruit_ILI9341* tft, Adafruit_ZeroDMA* dma, Sercom* sercom, volatile bool* done)
+    : tft_(tft), dma_(dma), sercom_(sercom), done_(done), fPending_(false) {}
+
+uint16_t* TftLineRenderer::getBuffer() {
+  return buf_;
+}
+
+uint32_t TftLineRenderer::getBufferBytes() {
+  return sizeof(buf_);
+}
+
+bool TftLineRenderer::isBusy() {
+  return fPending_ && !*done_;
+}
+
+void TftLineRenderer::wait() {
+  if (!fPending_) return;
+  while (!*done_);
+  // DMA完了は最後のbyteをDATAに書いた時点なので、シフトアウトを待ってからCSを上げる
+  while ((sercom_->SPI.INTFLAG.reg & SERCOM_SPI_INTFLAG_TXC) == 0);
+  while (sercom_->SPI.INTFLAG.reg & SERCOM_SPI_INTFLAG_RXC) (void)sercom_->SPI.DATA.reg;   // 受信した分を捨てる
+  sercom_->SPI.STATUS.reg = SERCOM_SPI_STATUS_BUFOVF;
+  tft_->endWrite();
+  fPending_ = false;
+}
+
+void TftLineRenderer::drawRow(int16_t y, const char* s, uint8_t len, uint16_t color, uint16_t bgColor,
+                              uint64_t hlChars, uint16_t hlColor) {
+  wait();                                   // line bufferは前の行の転送が終わるまで使えない
+  uint16_t bg = spiOrder565(bgColor);
+  uint16_t fg = spiOrder565(color);
+  uint16_t hl = spiOrder565(hlColor);
+  if (len > TFTLINE_COLS) len = TFTLINE_COLS;
+  for (uint8_t n = 0; n < TFTLINE_COLS; n++) {
+    uint16_t* p = &buf_[n * TFTLINE_CHARW];
+    char c = (n < len) ? s[n] : ' ';
+    if (c < GLYPHFIRST || c > GLYPHLAST) c = ' ';
+    const uint8_t* g = glyph5x8[c - GLYPHFIRST];
+    uint16_t f = (n < 64 && ((hlChars >> n) & 1)) ? hl : fg;
+    for (uint8_t col = 0; col < TFTLINE_CHARW - 1; col++) {
+      uint8_t bits = g[col];
+      for (uint8_t row = 0; row < TFTLINE_CHARH; row++, bits >>= 1) {
+        p[row * TFTLINE_WIDTH + col] = (bits & 1) ? f : bg;
+      }
+    }
+    for (uint8_t row = 0; row < TFTLINE_CHARH; row++) p[row * TFTLINE_WIDTH + TFTLINE_CHARW - 1] = bg;
+  }
+  tft_->startWrite();
+  tft_->setAddrWindow(0, y, TFTLINE_WIDTH, TFTLINE_CHARH);   // CS Low, RAMWR後はDC=data
+  sercom_->SPI.INTFLAG.reg = SERCOM_SPI_INTFLAG_TXC;       // 前の転送のTXCを消しておく
+  *done_ = false;
+  fPending_ = true;
+  dma_->startJob();
+}
@@ -0,0 +1,67 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#ifndef _FL_TFTLINE_H_
+#define _FL_TFTLINE_H_
+
+#include <Arduino.h>
+#include <Adafruit_ZeroDMA.h>
+#include "Adafruit_ILI9341.h"
+
+// ***** TFT line renderer definitions
+#define TFTLINE_CHARW       6                               // 5x8 glyph + 1 column space (textsize 1)
+#define TFTLINE_CHARH       8
+#define TFTLINE_WIDTH       ILI9341_TFTWIDTH                // 240
+#define TFTLINE_COLS        (TFTLINE_WIDTH / TFTLINE_CHARW) // 40
+#define TFTLINE_PIXELS      (TFTLINE_WIDTH * TFTLINE_CHARH) // 1920 pixel = 3840 byte
+
+// **************************************************************************************************************
+// Class TftLineRenderer ****************************************************************************************
+// **************************************************************************************************************
+// 1行(240x8)の文字をRGB565のline bufferに展開し、address windowを1回設定してDMAでILI9341へ送る
+// Adafruit_GFXのdrawChar(1文字毎、1pixel毎のSPI転送)を使わない。glyphはAdafruit_GFX標準の5x7 font
+// DMAの完了はtftdma_callbackが*done_をtrueにする。CSはSPIの送信完了(TXC)を待ってからwait()で上げる
+// line bufferは1本なので、次の行の展開は前の行の転送完了を待つ
+// DMA転送中にtftへ他の描画をしてはいけない。他の描画の前にwait()を呼ぶこと
+class TftLineRenderer {
+private:
+  Adafruit_ILI9341* tft_;
+  Adafruit_ZeroDMA* dma_;
+  Sercom* sercom_;                          // tftSPIのSERCOM
+  volatile bool* done_;                     // DMA完了flag (tftdma_callbackが立てる)
+  bool fPending_;                           // startWrite()したままの転送がある
+  uint16_t buf_[TFTLINE_PIXELS];            // SPIの送信順 (上位byteが先) に入れたRGB565
+
+public:
+  TftLineRenderer(Adafruit_ILI9341* tft, Adafruit_ZeroDMA* dma, Sercom* sercom, volatile bool* done);
+  uint16_t* getBuffer();                    // DMA descriptorの転送元
+  uint32_t getBufferBytes();
+  // y: 画面のpixel行 (A_ROWSIZEの倍数)  hlChars: bit nが1の文字はhlColorで描く
+  void drawRow(int16_t y, const char* s, uint8_t len, uint16_t color, uint16_t bgColor,
+               uint64_t hlChars, uint16_t hlColor);
+  void wait();                              // 転送完了を待ってCSを上げる
+  bool isBusy();
+};
+
+#endif
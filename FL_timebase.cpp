@@ -0,0 +1,93 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "FL_timebase.h"
+
+static volatile uint32_t tbOverflows = 0;   // TC3 overflow count = upper bits of the timebase
+
+// **************************************************************************************************************
+// Setup ********************************************************************************************************
+// **************************************************************************************************************
+void timebaseBegin() {
+  // GCLK generator: DFLL48M / TIMEBASE_GCLK_DIV
+  GCLK->GENDIV.reg = GCLK_GENDIV_ID(TIMEBASE_GCLK_GEN) | GCLK_GENDIV_DIV(TIMEBASE_GCLK_DIV);
+  while (GCLK->STATUS.bit.SYNCBUSY);
+  GCLK->GENCTRL.reg = GCLK_GENCTRL_ID(TIMEBASE_GCLK_GEN) | GCLK_GENCTRL_SRC_DFLL48M | GCLK_GENCTRL_GENEN;
+  while (GCLK->STATUS.bit.SYNCBUSY);
+  GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_TCC2_TC3 | GCLK_CLKCTRL_GEN(TIMEBASE_GCLK_GEN) | GCLK_CLKCTRL_CLKEN;
+  while (GCLK->STATUS.bit.SYNCBUSY);
+  PM->APBCMASK.reg |= PM_APBCMASK_TC3;
+
+  // TC3: 16bit free-running, 1MHz
+  TIMEBASE_TC->COUNT16.CTRLA.reg = TC_CTRLA_SWRST;
+  while (TIMEBASE_TC->COUNT16.CTRLA.bit.SWRST);
+  TIMEBASE_TC->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_WAVEGEN_NFRQ | TC_CTRLA_PRESCALER_DIV16;
+  while (TIMEBASE_TC->COUNT16.STATUS.bit.SYNCBUSY);
+  // COUNTを連続読出同期にしておき、読出毎のsync待ちをなくす
+  TIMEBASE_TC->COUNT16.READREQ.reg = TC_READREQ_RCONT | TC_READREQ_RREQ | TC_READREQ_ADDR(TC_COUNT16_COUNT_OFFSET);
+  while (TIMEBASE_TC->COUNT16.STATUS.bit.SYNCBUSY);
+  tbOverflows = 0;
+  TIMEBASE_TC->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF;
+  TIMEBASE_TC->COUNT16.INTENSET.reg = TC_INTENSET_OVF;
+  NVIC_ClearPendingIRQ(TIMEBASE_IRQn);
+  NVIC_SetPriority(TIMEBASE_IRQn, 0);
+  NVIC_EnableIRQ(TIMEBASE_IRQn);
+  TIMEBASE_TC->COUNT16.CTRLA.reg |= TC_CTRLA_ENABLE;
+  while (TIMEBASE_TC->COUNT16.STATUS.bit.SYNCBUSY);
+}
+
+void TC3_Handler() {
+  TIMEBASE_TC->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF;
+  tbOverflows = tbOverflows + 1;
+}
+
+// **************************************************************************************************************
+// Read *********************************************************************************************************
+// **************************************************************************************************************
+// 割込禁止中(他のISR内)はTC3_Handlerが走らないので、未処理のOVFがあれば上位を自分で繰り上げる
+// OVFが立っていてもCOUNTが大きければOVF前に読んだ値なので繰り上げない
+static void timebaseRead(uint32_t *ovf, uint16_t *cnt) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  uint32_t o = tbOverflows;
+  uint16_t c = TIMEBASE_TC->COUNT16.COUNT.reg;
+  if ((TIMEBASE_TC->COUNT16.INTFLAG.reg & TC_INTFLAG_OVF) && c < 0x8000) o++;
+  __set_PRIMASK(primask);
+  *ovf = o;
+  *cnt = c;
+}
+
+uint32_t timebaseNow() {
+  uint32_t ovf;
+  uint16_t cnt;
+  timebaseRead(&ovf, &cnt);
+  return (ovf << 16) | cnt;
+}
+
+uint64_t timebaseNow64() {
+  uint32_t ovf;
+  uint16_t cnt;
+  timebaseRead(&ovf, &cnt);
+  return ((uint64_t)ovf << 16) | cnt;
+}
@@ -0,0 +1,44 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#ifndef _FL_TIMEBASE_H_
+#define _FL_TIMEBASE_H_
+
+#include <Arduino.h>
+
+// ***** Timebase definitions
+// TC3 16bit counter at 1MHz + overflow counter in TC3_Handler = free-running microsecond timebase
+// GCLK generator 5: DFLL48M / 3 = 16MHz -> TC3 prescaler /16 = 1MHz
+// TC5はtone()が使うので使わない。GCLK_CLKCTRL_ID_TCC2_TC3のためTCC2にも16MHzが供給される
+#define TIMEBASE_GCLK_GEN   5
+#define TIMEBASE_GCLK_DIV   3
+#define TIMEBASE_TC         TC3
+#define TIMEBASE_IRQn       TC3_IRQn
+
+// 32bit版は約71.6分で一周する。差分は(uint32_t)(t1 - t0)で求めれば一周を跨いでも正しい
+void timebaseBegin();           // setup()でCAN割込を許可する前に呼ぶ
+uint32_t timebaseNow();         // [us] ISR内からも呼べる
+uint64_t timebaseNow64();       // [us] 一周しない
+
+#endif
@@ -0,0 +1,155 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "FL_trace.h"
+
+// **************************************************************************************************************
+// Class TraceView **********************************************************************************************
+// **************************************************************************************************************
+TraceView::TraceView(Adafruit_ILI9341* tft, uint16_t textColor, uint16_t bgColor)
+    : tft_(tft), textColor_(textColor), bgColor_(bgColor) {
+  clear();
+}
+
+void TraceView::setLineRenderer(TftLineRenderer* lineRenderer) {
+  lineRenderer_ = lineRenderer;
+}
+
+void TraceView::clear() {
+  memset(shown_, ' ', sizeof(shown_));
+  used_ = 0;
+  lastHit_ = 0;
+  passRow_ = TRACEROWS;
+  overflowCount_ = 0;
+}
+
+void TraceView::update(const canMessageSet &msg) {
+  uint32_t key = msg.ext ? (msg.id | 0x80000000UL) : msg.id;
+  uint8_t r = lastHit_;
+  bool fNew = false;
+  if (r >= used_ || row_[r].key != key) {
+    for (r = 0; r < used_; r++) {
+      if (row_[r].key == key) break;
+    }
+    if (r == used_) {                       // 新しいID
+      if (used_ >= TRACEROWS) {
+        overflowCount_++;
+        return;
+      }
+      used_++;
+      row_[r].key = key;
+      row_[r].period = 0;
+      fNew = true;
+    }
+    lastHit_ = r;
+  }
+  traceRow &row = row_[r];
+  if (!fNew) row.period = msg.timestamp - row.lastTime;
+  row.lastTime = msg.timestamp;
+  row.dlc = msg.len > 8 ? 8 : msg.len;
+  memcpy(row.data, msg.buf, sizeof(row.data));
+  row.dirty = true;
+}
+
+// "IIIIIIII L XX XX XX XX XX XX XX XX PPPPP" (TRACECOLS文字, null終端なし)
+void TraceView::formatRow(uint8_t r, char *text) {
+  static const char hex[] = "0123456789ABCDEF";
+  const traceRow &row = row_[r];
+  char buf[TRACECOLS + 1];
+  memset(text, ' ', TRACECOLS);
+  snprintf(buf, sizeof(buf), "%8lX %u", (unsigned long)(row.key & 0x7FFFFFFFUL), row.dlc);
+  memcpy(text, buf, strlen(buf));
+  char *p = text + TRACEIDCOLS + 3;
+  for (uint8_t n = 0; n < row.dlc; n++, p += 3) {
+    p[0] = hex[row.data[n] >> 4];
+    p[1] = hex[row.data[n] & 0x0F];
+  }
+  if (row.period != 0) {
+    uint32_t ms = row.period / 1000;
+    snprintf(buf, sizeof(buf), "%*lu", TRACEPERIODCOLS, (unsigned long)(ms > 99999 ? 99999 : ms));
+    memcpy(text + TRACECOLS - TRACEPERIODCOLS, buf, TRACEPERIODCOLS);
+  }
+}
+
+void TraceView::render() {
+  if (passRow_ >= TRACEROWS) passRow_ = 0;
+  if (lineRenderer_ != nullptr) renderRowDma();
+  else renderCharsGfx();
+}
+
+bool TraceView::isRenderPending() {
+  return passRow_ < TRACEROWS;
+}
+
+// 変化した1行をline bufferに展開してDMAで送る (1行0.2ms程度、転送はloopと並行)
+void TraceView::renderRowDma() {
+  char text[TRACECOLS];
+  for (; passRow_ < used_; passRow_++) {
+    uint8_t r = passRow_;
+    if (!row_[r].dirty) continue;
+    if (lineRenderer_->isBusy()) return;        // 前の行を転送中なら次の呼出しで
+    row_[r].dirty = false;
+    formatRow(r, text);
+    if (memcmp(text, shown_[r], TRACECOLS) == 0) continue;
+    memcpy(shown_[r], text, TRACECOLS);
+    lineRenderer_->drawRow((TRACEROWTOP + r) * TRACECHARH, text, TRACECOLS, textColor_, bgColor_, 0, textColor_);
+    passRow_++;
+    return;
+  }
+  passRow_ = TRACEROWS;
+}
+
+// GFXは1文字毎にpixelを送るので、変化した文字の連続ごとにcursorを合わせてTRACECHARSMAX文字まで描く
+// 上限で止めた行はdirtyのまま残し、次の呼出しでshown_と異なる残りの文字を描く
+void TraceView::renderCharsGfx() {
+  char text[TRACECOLS];
+  uint16_t budget = TRACECHARSMAX;
+  tft_->setTextSize(1);
+  tft_->setTextColor(textColor_, bgColor_);   // 背景色で前の文字を上書きする
+  for (; passRow_ < used_; passRow_++) {
+    uint8_t r = passRow_;
+    if (!row_[r].dirty) continue;
+    formatRow(r, text);
+    int16_t y = (TRACEROWTOP + r) * TRACECHARH;
+    bool inRun = false;
+    for (uint8_t c = 0; c < TRACECOLS; c++) {
+      if (text[c] == shown_[r][c]) {
+        inRun = false;
+        continue;
+      }
+      if (budget == 0) return;
+      if (!inRun) tft_->setCursor(c * TRACECHARW, y);
+      tft_->write(text[c]);
+      shown_[r][c] = text[c];
+      inRun = true;
+      budget--;
+    }
+    row_[r].dirty = false;
+  }
+  passRow_ = TRACEROWS;
+}
+
+uint32_t TraceView::getOverflowCount() {
+  return overflowCount_;
+}
@@ -0,0 +1,88 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2025 FundyLab
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#ifndef _FL_TRACE_H_
+#define _FL_TRACE_H_
+
+#include <Arduino.h>
+#include "Adafruit_ILI9341.h"
+#include "mcp25625_can.h"     // canMessageSet
+#include "FL_tftline.h"       // TftLineRenderer
+
+// ***** Trace view definitions
+#define TRACECHARW      6                           // textsize 1
+#define TRACECHARH      8
+#define TRACECOLS       (ILI9341_TFTWIDTH / TRACECHARW)         // 40
+#define TRACEROWTOP     1                           // 0行目はstatus line
+#define TRACEROWS       (ILI9341_TFTHEIGHT / TRACECHARH - TRACEROWTOP)  // 39
+#define TRACEIDCOLS     8                           // 1行 "IIIIIIII L XX XX XX XX XX XX XX XX PPPPP"
+#define TRACEPERIODCOLS 5                           // 周期 [ms]
+#define TRACECHARSMAX   64                          // line rendererが無い時、render()1回でGFXで描く文字数の上限
+
+// 1 CAN IDの表示内容
+struct traceRow {
+  uint32_t key;         // CAN ID | 0x80000000 (extended)
+  uint8_t dlc;
+  uint8_t data[8];
+  bool dirty;           // render()で描き直す
+  uint32_t lastTime;    // [us]
+  uint32_t period;      // 直前の受信間隔 [us] 0:未計測
+};
+
+// **************************************************************************************************************
+// Class TraceView **********************************************************************************************
+// **************************************************************************************************************
+// CAN ID毎に固定の1行を割り当てて ID/DLC/data/周期 を表示する
+// update()は受信frameでRAM上の行を更新するだけで描画しない
+// render()を一定周期で呼ぶと、変化した行を上から順に描く1回のpassを始める
+// 1回のrender()で描くのは、line rendererがあれば変化した1行 (DMA転送中なら何もしない)、
+// 無ければ前回描いた文字と異なる文字をTRACECHARSMAX文字まで。残りはisRenderPending()の間に続きを描く
+// 行は最初に受信した順に割り当て、TRACEROWSを超えたIDは数えるだけで表示しない
+class TraceView {
+private:
+  Adafruit_ILI9341* tft_;
+  TftLineRenderer* lineRenderer_ = nullptr;   // nullptr: GFXのwrite()で描く
+  uint16_t textColor_, bgColor_;
+  traceRow row_[TRACEROWS];
+  char shown_[TRACEROWS][TRACECOLS];    // 画面に描いてある文字
+  uint8_t used_;                        // 割り当て済みの行数
+  uint8_t lastHit_;                     // 直前にupdate()した行
+  uint8_t passRow_;                     // 描画中のpassの次の行, TRACEROWS: passなし
+  uint32_t overflowCount_;              // 行が足りず表示できなかったframe数
+
+  void formatRow(uint8_t r, char *text);
+  void renderRowDma();
+  void renderCharsGfx();
+
+public:
+  TraceView(Adafruit_ILI9341* tft, uint16_t textColor, uint16_t bgColor);
+  void setLineRenderer(TftLineRenderer* lineRenderer);
+  void clear();                         // 行の割り当てを全て解除 (画面は呼出側で消しておく)
+  void update(const canMessageSet &msg);
+  void render();                        // passが無ければ新しいpassを始めて続きを描く
+  bool isRenderPending();               // passの途中 (次のloopでrender()を呼ぶ)
+  uint32_t getOverflowCount();
+};
+
+#endif
@@ -54,8 +54,7 @@
 #define spi_readwrite      pSPI->transfer
 #define spi_read()         spi_readwrite(0x00)
 #define spi_write(spi_val) spi_readwrite(spi_val)
-#define SPI_BEGIN()        pSPI->beginTransaction(SPISettings(8000000, MSBFIRST, SPI_MODE0))
-//#define SPI_BEGIN()        pSPI->beginTransaction(SPISettings(4000000, MSBFIRST, SPI_MODE0))
+#define SPI_BEGIN()        pSPI->beginTransaction(MCP25625_SPI_SETTINGS)
 #define SPI_END()          pSPI->endTransaction()
 
 /*********************************************************************************************************
@@ -854,6 +853,23 @@ void mcp25625_id_to_buf(const byte ext, const unsigned long id, byte* tbufdata)
     }
 }
 
+/*********************************************************************************************************
+** Function name:           mcp25625_buf_to_id
+** Descriptions:            get id and ext from tbufdata[4]
+*********************************************************************************************************/
+void mcp25625_buf_to_id(const byte* tbufdata, byte* ext, unsigned long* id) {
+    *id = (tbufdata[MCP_SIDH] << 3) + (tbufdata[MCP_SIDL] >> 5);
+    *ext = 0;
+
+    if ((tbufdata[MCP_SIDL] & MCP_TXB_EXIDE_M) ==  MCP_TXB_EXIDE_M) {
+        // extended id
+        *id = (*id << 2) + (tbufdata[MCP_SIDL] & 0x03);
+        *id = (*id << 8) + tbufdata[MCP_EID8];
+        *id = (*id << 8) + tbufdata[MCP_EID0];
+        *ext = 1;
+    }
+}
+
 /*********************************************************************************************************
 ** Function name:           mcp25625_write_id
 ** Descriptions:            write can id
@@ -872,20 +888,8 @@ void mcp25625_can::mcp25625_write_id(const byte mcp_addr, const byte ext, const
 void mcp25625_can::mcp25625_read_id(const byte mcp_addr, byte* ext, unsigned long* id) {
     byte tbufdata[4];
 
-    *ext    = 0;
-    *id     = 0;
-
     mcp25625_readRegisterS(mcp_addr, tbufdata, 4);
-
-    *id = (tbufdata[MCP_SIDH] << 3) + (tbufdata[MCP_SIDL] >> 5);
-
-    if ((tbufdata[MCP_SIDL] & MCP_TXB_EXIDE_M) ==  MCP_TXB_EXIDE_M) {
-        // extended id
-        *id = (*id << 2) + (tbufdata[MCP_SIDL] & 0x03);
-        *id = (*id << 8) + tbufdata[MCP_EID8];
-        *id = (*id << 8) + tbufdata[MCP_EID0];
-        *ext = 1;
-    }
+    mcp25625_buf_to_id(tbufdata, ext, id);
 }
 
 /*********************************************************************************************************
@@ -932,7 +936,8 @@ void mcp25625_can::mcp25625_write_canMsg(const byte buffer_sidh_addr, unsigned l
 void mcp25625_can::mcp25625_read_canMsg(const byte buffer_load_addr, volatile unsigned long* id, volatile byte* ext,
                                   volatile byte* rtrBit, volatile byte* len, volatile byte* buf) {      /* read can msg                 */
     byte tbufdata[4];
-    byte i;
+    byte i, e;
+    unsigned long d;
 
     MCP25625_SELECT();
     spi_readwrite(buffer_load_addr);
@@ -941,15 +946,9 @@ void mcp25625_can::mcp25625_read_canMsg(const byte buffer_load_addr, volatile un
         tbufdata[i] = spi_read();
     }
 
-    *id = (tbufdata[MCP_SIDH] << 3) + (tbufdata[MCP_SIDL] >> 5);
-    *ext = 0;
-    if ((tbufdata[MCP_SIDL] & MCP_TXB_EXIDE_M) ==  MCP_TXB_EXIDE_M) {
-        /* extended id                  */
-        *id = (*id << 2) + (tbufdata[MCP_SIDL] & 0x03);
-        *id = (*id << 8) + tbufdata[MCP_EID8];
-        *id = (*id << 8) + tbufdata[MCP_EID0];
-        *ext = 1;
-    }
+    mcp25625_buf_to_id(tbufdata, &e, &d);
+    *id = d;
+    *ext = e;
 
     byte pMsgSize = spi_read();
     *len = pMsgSize & MCP_DLC_MASK;
@@ -961,6 +960,26 @@ void mcp25625_can::mcp25625_read_canMsg(const byte buffer_load_addr, volatile un
     MCP25625_UNSELECT();
 }
 
+/*********************************************************************************************************
+** Function name:           parseRxBuffer
+** Descriptions:            parse MCP_RXBUF_RAWLEN bytes that follow READ RX BUFFER instruction.
+**                          Used when the rx buffer was read outside of this driver (e.g. by DMA).
+*********************************************************************************************************/
+void mcp25625_can::parseRxBuffer(const byte* raw, canMessageSet* msg) {
+    unsigned long d;
+    byte i;
+
+    mcp25625_buf_to_id(raw, &msg->ext, &d);
+    msg->id = d;
+    msg->len = raw[4] & MCP_DLC_MASK;
+    if (msg->len > MAX_CHAR_IN_MESSAGE) {
+        msg->len = MAX_CHAR_IN_MESSAGE;
+    }
+    for (i = 0; i < msg->len; i++) {
+        msg->buf[i] = raw[5 + i];
+    }
+}
+
 /*********************************************************************************************************
 ** Function name:           mcp25625_start_transmit
 ** Descriptions:            Start message transmit on mcp25625
@@ -1149,6 +1168,53 @@ byte mcp25625_can::init_Filt(byte num, byte ext, unsigned long ulData) {
     return res;
 }
 
+/*********************************************************************************************************
+** Function name:           beginConfig
+** Descriptions:            enter config mode to write several Masks/Filters at once
+**                          no fixed delay, mode change is confirmed by CANSTAT
+*********************************************************************************************************/
+byte mcp25625_can::beginConfig(void) {
+    return mcp25625_setCANCTRL_Mode(MODE_CONFIG);
+}
+
+/*********************************************************************************************************
+** Function name:           endConfig
+** Descriptions:            back to the operational mode from config mode
+*********************************************************************************************************/
+byte mcp25625_can::endConfig(void) {
+    return mcp25625_setCANCTRL_Mode(mcpMode);
+}
+
+/*********************************************************************************************************
+** Function name:           writeMask
+** Descriptions:            write canid Mask without mode change
+*********************************************************************************************************/
+byte mcp25625_can::writeMask(byte num, byte ext, unsigned long ulData) {
+    if (num == 0) {
+        mcp25625_write_id(MCP_RXM0SIDH, ext, ulData);
+    } else if (num == 1) {
+        mcp25625_write_id(MCP_RXM1SIDH, ext, ulData);
+    } else {
+        return MCP25625_FAIL;
+    }
+    return MCP25625_OK;
+}
+
+/*********************************************************************************************************
+** Function name:           writeFilt
+** Descriptions:            write canid filter without mode change
+*********************************************************************************************************/
+byte mcp25625_can::writeFilt(byte num, byte ext, unsigned long ulData) {
+    static const byte filtAddr[] = {
+        MCP_RXF0SIDH, MCP_RXF1SIDH, MCP_RXF2SIDH, MCP_RXF3SIDH, MCP_RXF4SIDH, MCP_RXF5SIDH
+    };
+    if (num >= sizeof(filtAddr)) {
+        return MCP25625_FAIL;
+    }
+    mcp25625_write_id(filtAddr[num], ext, ulData);
+    return MCP25625_OK;
+}
+
 /*********************************************************************************************************
 ** Function name:           sendMsgBuf
 ** Descriptions:            Send message by using buffer read as free from CANINTF status
@@ -1355,6 +1421,142 @@ byte mcp25625_can::checkReceive(void) {
     return ((res & MCP_STAT_RXIF_MASK) ? CAN_MSGAVAIL : CAN_NOMSG);
 }
 
+/*********************************************************************************************************
+** Function name:           readRxStatus
+** Descriptions:            RX STATUS instruction. bit7,6: message in RXB1,RXB0  bit2-0: filter hit
+*********************************************************************************************************/
+byte mcp25625_can::readRxStatus(void) {
+    byte i;
+    #ifdef SPI_HAS_TRANSACTION
+    SPI_BEGIN();
+    #endif
+    MCP25625_SELECT();
+    spi_readwrite(MCP_RX_STATUS);
+    i = spi_read();
+    MCP25625_UNSELECT();
+    #ifdef SPI_HAS_TRANSACTION
+    SPI_END();
+    #endif
+
+    return i;
+}
+
+/*********************************************************************************************************
+** Function name:           mcp25625_rxFilhit
+** Descriptions:            Filter hit of the rx buffer read by instruction. RX STATUS filter bits are used
+**                          when only that buffer is full and it was filled since the last RX STATUS (the
+**                          bits may belong to an already read message otherwise), else RXBnCTRL is read.
+*********************************************************************************************************/
+byte mcp25625_can::mcp25625_rxFilhit(const byte instruction, const byte rxStatus) {
+    byte filhit;
+
+    if (!rxFilhitValid || (rxStatus & MCP_RXSTAT_BUF_MASK) == MCP_RXSTAT_BUF_MASK) {
+        if (instruction == MCP_READ_RX0) {
+            return mcp25625_readRegister(MCP_RXB0CTRL) & MCP_RXB_FILHIT0_M;
+        }
+        return mcp25625_readRegister(MCP_RXB1CTRL) & MCP_RXB_FILHIT_M;
+    }
+    filhit = rxStatus & MCP_RXSTAT_FILHIT_M;
+    if (filhit >= 6) {
+        filhit -= 6;                                                    // RXF0,RXF1 rollover to RXB1
+    }
+    return filhit;
+}
+
+/*********************************************************************************************************
+** Function name:           mcp25625_nextRxBuffer
+** Descriptions:            Return READ RX instruction of the oldest rx buffer in rxStatus, or 0 if none.
+**                          RXF0/RXF1 hits go to RXB0 (or roll over to RXB1 while RXB0 is full), but
+**                          RXF2-5 hits go straight to RXB1, so RXB1 can hold the older message.
+**                          The order is kept from RX STATUS to RX STATUS: a buffer that was already
+**                          pending is older than one that filled since. If both filled since the last
+**                          RX STATUS, RXB0 is read first. That is right for a rollover, but the MCP25625
+**                          does not record the order of a direct RXB1 hit against RXB0. So the order is
+**                          exact when each reception is seen by an RX STATUS before the next one
+**                          completes (one ISR per frame), or when the RXB1 filters (RXF2-5) are unused.
+*********************************************************************************************************/
+byte mcp25625_can::mcp25625_nextRxBuffer(const byte rxStatus) {
+    byte full = rxStatus & MCP_RXSTAT_BUF_MASK;
+    byte filled = full & ~rxPending;                                    // filled since last RX STATUS
+    byte read;
+
+    if (full == MCP_RXSTAT_BUF_MASK) {
+        if (filled == MCP_RXSTAT_RXB0) {
+            rxOlder = MCP_RXSTAT_RXB1;                                  // RXB1 was pending before
+        }
+        else if (filled == MCP_RXSTAT_RXB1) {
+            rxOlder = MCP_RXSTAT_RXB0;
+        }
+        else if (filled == MCP_RXSTAT_BUF_MASK) {
+            rxOlder = MCP_RXSTAT_RXB0;                                  // rollover, or unknown order
+        }
+        read = rxOlder;
+    }
+    else {
+        read = full;
+    }
+    rxPending = full & ~read;
+    rxFilhitValid = (read == full) && (filled == full);
+    if (read == MCP_RXSTAT_RXB0) {
+        return MCP_READ_RX0;
+    }
+    if (read == MCP_RXSTAT_RXB1) {
+        return MCP_READ_RX1;
+    }
+    return 0;
+}
+
+/*********************************************************************************************************
+** Function name:           selectRxBuffer
+** Descriptions:            Return READ RX instruction of the oldest rx buffer in rxStatus(RX STATUS) and
+**                          its filter hit, or 0 if none. For reading one buffer per RX STATUS (e.g. DMA).
+*********************************************************************************************************/
+byte mcp25625_can::selectRxBuffer(byte rxStatus, byte* filhit) {
+    byte instruction = mcp25625_nextRxBuffer(rxStatus);
+
+    if (instruction != 0) {
+        *filhit = mcp25625_rxFilhit(instruction, rxStatus);
+    }
+    return instruction;
+}
+
+/*********************************************************************************************************
+** Function name:           readMsgBatch
+** Descriptions:            Read received messages (max 2) with one RX STATUS, in arrival order as far as
+**                          mcp25625_nextRxBuffer can tell. Return count of messages in out[].
+*********************************************************************************************************/
+byte mcp25625_can::readMsgBatch(canMessageSet* out, byte max) {
+    byte rxStatus = readRxStatus();
+    byte remain = rxStatus;
+    byte instruction, filhit, rtrBit;
+    unsigned long id;
+    byte n = 0;
+
+    while (n < max) {
+        instruction = mcp25625_nextRxBuffer(remain);
+        if (instruction == 0) {
+            break;
+        }
+        filhit = mcp25625_rxFilhit(instruction, rxStatus);              // judged by the first RX STATUS
+        #ifdef SPI_HAS_TRANSACTION
+        SPI_BEGIN();
+        #endif
+        mcp25625_read_canMsg(instruction, &id, &out[n].ext, &rtrBit, &out[n].len, out[n].buf);
+        #ifdef SPI_HAS_TRANSACTION
+        SPI_END();
+        #endif
+        out[n].id = id;
+        if (out[n].len > MAX_CHAR_IN_MESSAGE) {
+            out[n].len = MAX_CHAR_IN_MESSAGE;
+        }
+        out[n].filhit = filhit;
+        remain &= ~((instruction == MCP_READ_RX0) ? MCP_RXSTAT_RXB0 : MCP_RXSTAT_RXB1);
+        n++;
+    }
+
+    return n;
+}
+
 /*********************************************************************************************************
 ** Function name:           checkError
 ** Descriptions:            if something error
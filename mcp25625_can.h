@@ -54,11 +54,23 @@
 #include "mcp25625_can_dfs.h"
 
 #define MAX_CHAR_IN_MESSAGE 8
+#define MCP_RXBUF_RAWLEN    13  // READ RX BUFFERで読める長さ SIDH,SIDL,EID8,EID0,DLC,D0-D7
+#define MCP25625_SPI_SETTINGS   SPISettings(8000000, MSBFIRST, SPI_MODE0)
+//#define MCP25625_SPI_SETTINGS   SPISettings(4000000, MSBFIRST, SPI_MODE0)
+
+struct canMessageSet{
+  uint32_t id;
+  byte ext;
+  byte len;
+  byte filhit;                    // 受信したfilter番号 0-5:RXF0-5
+  byte buf[MAX_CHAR_IN_MESSAGE];
+  uint32_t timestamp;             // 受信時刻 [us] (timebaseNow())
+};
 
 class mcp25625_can : public MCP_CAN
 {
 public:
-    mcp25625_can(byte _CS) : MCP_CAN(_CS), nReservedTx(0){};
+    mcp25625_can(byte _CS) : MCP_CAN(_CS), nReservedTx(0), rxPending(0), rxOlder(0), rxFilhitValid(false){};
     /*
         MCP25625 driver function
     */
@@ -76,6 +88,10 @@ public:
     virtual byte begin_noSPIset(uint32_t speedset, const byte clockset = MCP_16MHz);                                                                    // init can with no SPI begin (for multiple SPI setting)
     virtual byte init_Mask(byte num, byte ext, unsigned long ulData);                                                                                   // init Masks
     virtual byte init_Filt(byte num, byte ext, unsigned long ulData);                                                                                   // init filters
+    byte beginConfig(void);                                                                                                                             // enter config mode (no delay)
+    byte endConfig(void);                                                                                                                               // back to the operational mode set by setMode()
+    byte writeMask(byte num, byte ext, unsigned long ulData);                                                                                           // write Mask, call between beginConfig() and endConfig()
+    byte writeFilt(byte num, byte ext, unsigned long ulData);                                                                                           // write filter, call between beginConfig() and endConfig()
     virtual void setSleepWakeup(byte enable);                                                                                                           // Enable or disable the wake up interrupt (If disabled the MCP25625 will not be woken up by CAN bus activity, making it send only)
     virtual byte sleep();                                                                                                                               // Put the MCP25625 in sleep mode
     virtual byte wake();                                                                                                                                // Wake MCP25625 manually from sleep
@@ -84,6 +100,9 @@ public:
     virtual byte checkError(uint8_t* err_ptr = NULL);                                                                                                   // if something error
 
     virtual byte checkReceive(void);                                                                                                                    // if something received
+    byte readRxStatus(void);                                                                                                                            // RX STATUS instruction
+    byte selectRxBuffer(byte rxStatus, byte *filhit);                                                                                                   // next READ RX instruction in arrival order
+    byte readMsgBatch(canMessageSet *out, byte max);                                                                                                    // read all received msgs with one RX STATUS
     virtual byte readMsgBufID(byte status, volatile unsigned long *id, volatile byte *ext, volatile byte *rtr, volatile byte *len, volatile byte *buf); // read buf with object ID
     /* wrapper */
     byte readMsgBufID(unsigned long *ID, byte *ext, byte *len, byte *buf){
@@ -109,6 +128,8 @@ public:
     virtual bool mcpDigitalWrite(const byte pin, const byte mode);                                                                                      // write HIGH or LOW to RX0BF/RX1BF
     virtual byte mcpDigitalRead(const byte pin);
 
+    void parseRxBuffer(const byte *raw, canMessageSet *msg);                                                                                            // parse READ RX BUFFER raw data (e.g. read by DMA)
+
 private:
     void mcp25625_reset(void); // reset mcp25625
 
@@ -131,6 +152,9 @@ private:
                                 const byte data);
 
     byte mcp25625_readStatus(void);                                  // read mcp25625's Status
+    byte mcp25625_nextRxBuffer(const byte rxStatus);                 // oldest rx buffer
+    byte mcp25625_rxFilhit(const byte instruction,                   // filter hit of rx buffer
+                          const byte rxStatus);
     byte mcp25625_setCANCTRL_Mode(const byte newmode);               // set mode
     byte mcp25625_requestNewMode(const byte newmode);                // Set mode
     byte mcp25625_configRate(const byte canSpeed, const byte clock); // set baudrate
@@ -159,13 +183,9 @@ private:
     byte sendMsg(unsigned long id, byte ext, byte rtrBit, byte len, const byte *buf, bool wait_sent = true); // send message
 private:
     byte nReservedTx; // Count of tx buffers for reserved send
-};
-
-struct canMessageSet{
-  uint32_t id;
-  byte ext;
-  byte len;
-  byte buf[MAX_CHAR_IN_MESSAGE];
+    byte rxPending;   // MCP_RXSTAT_RXBn seen full by the last RX STATUS and not read yet
+    byte rxOlder;     // MCP_RXSTAT_RXBn received first while both buffers are full
+    bool rxFilhitValid; // RX STATUS filter bits belong to the buffer to read
 };
 
 #endif
@@ -79,6 +79,8 @@
 #define MCP_RXB_RX_STDEXT   0x00
 #define MCP_RXB_RX_MASK     0x60
 #define MCP_RXB_BUKT_MASK   (1<<2)
+#define MCP_RXB_FILHIT0_M   0x01                                        // In RXB0CTRL
+#define MCP_RXB_FILHIT_M    0x07                                        // In RXB1CTRL
 
 
 // Bits in the TXBnCTRL registers.
@@ -107,6 +109,11 @@
 #define MCP_STAT_RX0IF (1<<0)
 #define MCP_STAT_RX1IF (1<<1)
 
+#define MCP_RXSTAT_RXB0      (1<<6)                                     // RX STATUS: message in RXB0
+#define MCP_RXSTAT_RXB1      (1<<7)                                     // RX STATUS: message in RXB1
+#define MCP_RXSTAT_BUF_MASK  (0xC0)
+#define MCP_RXSTAT_FILHIT_M  (0x07)                                     // 6,7: RXF0,RXF1 rollover to RXB1
+
 #define MCP_EFLG_RX1OVR (1<<7)
 #define MCP_EFLG_RX0OVR (1<<6)
 #define MCP_EFLG_TXBO   (1<<5)
@@ -94,10 +94,14 @@ void BoxObject::draw(bool flag_drawErase){
 }
 
 void BoxObject::changeText(const String& label){
+  changeText(label.c_str());
+}
+
+void BoxObject::changeText(const char* label){
   // delete previous text
   drawText(tft_, tx, ty, color_.backgroundColor, info_.textSize, label_);
   // modifying text position
-  if(label.length() != label_.length()){                // check for text length changes
+  if(strlen(label) != label_.length()){                 // check for text length changes
     label_ = label;                                                       // update text
     convTextAlignType2pos(tx, ty, info_, width, height, label_);          // modifying tx, ty pos
   }
@@ -137,6 +137,7 @@ public:
   BoxObject(Adafruit_ILI9341* tft, const boxObjectInfo &info, const boxObjectColor &color, const String& label);
   void draw(bool flag_drawErase) override;
   void changeText(const String& label);
+  void changeText(const char* label);   // 長さが変わらなければlabel_のbufferを再利用する
   bool isBoxObject() const override { return true; }  // 型確認メソッドをオーバーライド
 };
 
@@ -0,0 +1,120 @@
+// MCP25625 RX readout host benchmark: CPU SPI transfers per frame (user-002)
+// 模擬MCP25625 (READ STATUS / RX STATUS / READ RX BUFFER) をSPIClass::transfer()の裏に置き、
+// 同じフレーム列を3通りの受信ISRで読んで、CPUが1byteずつ転送したbyte数とDMAに任せたbyte数を数える
+//   legacy  : 初版のISR (checkReceive() + readMsgBufID() をRXバッファが空になるまで)
+//   byteloop: MCP_RX_DMA 0 のISR (RX STATUS 1回 + readMsgBatch())
+//   dma     : MCP_RX_DMA 1 のISR (RX STATUS 1回のみCPU、READ RX BUFFER 14byteはDMA + parseRxBuffer())
+// CPUのSPI転送は1byte毎に8MHzで1us (48MHzで48cycle) 以上待つので、その下限も出す
+#include "fake_mcp.h"
+#include "test_check.h"
+
+#define SPICYCLES       48      // 1byte @ 8MHz SPI = 1us = 48 cycles @ 48MHz
+#define BENCHFRAMES     20000
+
+// **************************************************************************************************************
+static uint32_t rng = 1;
+static uint32_t nextRand() {
+  rng = rng * 1103515245 + 12345;
+  return rng >> 8;
+}
+
+static canMessageSet trace[BENCHFRAMES];
+
+static void buildTrace() {
+  for (int f = 0; f < BENCHFRAMES; f++) {
+    canMessageSet &m = trace[f];
+    memset(&m, 0, sizeof(m));
+    m.ext = (nextRand() & 3) == 0;
+    m.id = m.ext ? nextRand() & 0x1FFFFFFF : nextRand() & 0x7FF;
+    m.len = nextRand() % 9;
+    for (int i = 0; i < m.len; i++) m.buf[i] = (uint8_t)nextRand();
+  }
+}
+
+static mcp25625_can CAN(PIN_MCP_CS);
+static canMessageSet received[BENCHFRAMES];
+static int receivedCount;
+
+static void store(const canMessageSet &m) {
+  if (receivedCount < BENCHFRAMES) received[receivedCount++] = m;
+}
+
+// 初版のISR
+static void isrLegacy() {
+  while (CAN.checkReceive() == CAN_MSGAVAIL) {
+    canMessageSet m;
+    memset(&m, 0, sizeof(m));
+    unsigned long id;
+    CAN.readMsgBufID(&id, &m.ext, &m.len, m.buf);
+    m.id = id;
+    store(m);
+  }
+}
+
+// MCP_RX_DMA 0
+static void isrByteLoop() {
+  canMessageSet batch[2];
+  byte n;
+  while ((n = CAN.readMsgBatch(batch, 2)) > 0) {
+    for (byte i = 0; i < n; i++) store(batch[i]);
+  }
+}
+
+// MCP_RX_DMA 1: ISRはRX STATUSとDMA開始だけ。INTがLowの間は完了後に再度ISRが入る
+static void isrDma() {
+  for (;;) {
+    byte filhit;
+    byte instruction = CAN.selectRxBuffer(CAN.readRxStatus(), &filhit);
+    if (instruction == 0) return;
+    uint8_t dst[MCP_RXBUF_RAWLEN + 1];
+    dmaActive = true;                             // startMcpRxDMA() -> DMAC
+    digitalWrite(PIN_MCP_CS, LOW);
+    dst[0] = SPI.transfer(instruction);
+    for (int i = 1; i <= MCP_RXBUF_RAWLEN; i++) dst[i] = SPI.transfer(0);
+    digitalWrite(PIN_MCP_CS, HIGH);
+    dmaActive = false;
+    canMessageSet m;                              // mcpsddma_callback()
+    memset(&m, 0, sizeof(m));
+    CAN.parseRxBuffer(&dst[1], &m);
+    store(m);
+  }
+}
+
+// 1回の割込で1-2フレーム (RXB0/RXB1) を受信済みの状態から読む
+static void runPath(const char *name, void (*isr)()) {
+  memset(&mcp, 0, sizeof(mcp));
+  cpuBytes = dmaBytes = 0;
+  receivedCount = 0;
+  uint32_t isrCount = 0;
+  rng = 7;
+  for (int f = 0; f < BENCHFRAMES;) {
+    int n = ((nextRand() & 3) == 0 && f + 1 < BENCHFRAMES) ? 2 : 1;
+    for (int i = 0; i < n; i++) mcpLoad(i, trace[f + i]);
+    f += n;
+    isr();
+    isrCount++;
+    CHECK(!mcp.full[0] && !mcp.full[1]);
+  }
+  CHECK_EQ(receivedCount, BENCHFRAMES);
+  for (int f = 0; f < receivedCount && f < BENCHFRAMES; f++) {
+    if (received[f].id != trace[f].id || received[f].ext != trace[f].ext || received[f].len != trace[f].len ||
+        memcmp(received[f].buf, trace[f].buf, trace[f].len) != 0) {
+      printf("%s: frame %d differs\n", name, f);
+      checkFailed++;
+      break;
+    }
+  }
+  double cpu = (double)cpuBytes / BENCHFRAMES, dma = (double)dmaBytes / BENCHFRAMES;
+  printf("    %-8s cpu_spi=%5.2f bytes/frame (>=%4.0f cycles)  dma=%5.2f bytes/frame  isr=%lu\n", name, cpu,
+         cpu * SPICYCLES, dma, (unsigned long)isrCount);
+}
+
+int main() {
+  hostPinHook = mcpPin;
+  buildTrace();
+  printf("  mcp rx readout (%d frames, DLC 0-8, 25%% ext, 1-2 frames per interrupt):\n", BENCHFRAMES);
+  runPath("legacy", isrLegacy);
+  runPath("byteloop", isrByteLoop);
+  runPath("dma", isrDma);
+  return TEST_RESULT("bench_mcprx");
+}
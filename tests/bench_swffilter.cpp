@@ -0,0 +1,225 @@
+// SWF filter stage host benchmark: frames/s before (user-007) vs after
+// legacy: 初版のapplySoftwareFilter() (フレーム毎に8 SWF分のgetSettingValue()とbyte毎のextractBits())
+// plan  : 現在のapplySoftwareFilter() (ID dispatch -> FL_swfplanのshift/mask抽出)
+// どちらも同じ8 SWF設定と同じフレーム列で、抽出値のchecksumが一致することを確認してから計る
+// hostの値なので絶対値はSAMD21と違う。比を見る
+#include "FL_swfplan.h"
+#include "test_check.h"
+#include <chrono>
+
+#define BENCHFRAMES     4096
+#define BENCHLOOPS      500
+
+struct benchFrame {
+  uint32_t id;
+  uint8_t buf[8];
+};
+static benchFrame frames[BENCHFRAMES];
+
+// **************************************************************************************************************
+// legacy (baseline FLCM1.ino / FLCM1_IO.cpp)
+// **************************************************************************************************************
+#define LEGACYSWFCOUNT  8
+enum eLegacyReg { L_SWFSW, L_SWFSU, L_SWFID, L_SWFSB, L_SWFSI, L_SWFEB, L_SWFEI };
+struct legacySoftwareFilter {
+  int32_t canID;
+  int8_t startByte, startBit, endByte, endBit;
+  bool onoff, sign;
+};
+static legacySoftwareFilter legacySwf[LEGACYSWFCOUNT];
+static uint8_t legacyLen[LEGACYSWFCOUNT];
+static int64_t legacyValue[LEGACYSWFCOUNT];
+static uint8_t legacyFiltered;
+
+// SettingsManagerは別のtranslation unitにあったのでinline展開させない
+__attribute__((noinline)) static int32_t legacyGetSettingValue(eLegacyReg regType, int regIndex) {
+  switch (regType) {
+    case L_SWFSW: return legacySwf[regIndex].onoff;
+    case L_SWFSU: return legacySwf[regIndex].sign;
+    case L_SWFID: return legacySwf[regIndex].canID;
+    case L_SWFSB: return legacySwf[regIndex].startByte;
+    case L_SWFSI: return legacySwf[regIndex].startBit;
+    case L_SWFEB: return legacySwf[regIndex].endByte;
+    case L_SWFEI: return legacySwf[regIndex].endBit;
+    default: return -1;
+  }
+}
+
+static void legacyExtractBits(const uint8_t* data, bool sign, uint8_t startByte, uint8_t startBit, uint8_t endByte,
+                              uint8_t endBit, int64_t &result) {
+  bool negative = false;
+  if (sign && ((data[startByte] >> startBit) & 0x1)) negative = true;
+  int64_t temp_res = 0;
+  for (uint8_t byteIndex = startByte; byteIndex <= endByte; ++byteIndex) {
+    if (byteIndex == startByte) {
+      uint8_t mask = (uint8_t)(((uint16_t)1 << (startBit + 1)) - 1);
+      if (negative) temp_res = (int8_t)(data[startByte] | ~mask);
+      else temp_res = data[startByte] & mask;
+      if (byteIndex == endByte) temp_res = temp_res >> endBit;
+    }
+    else if (byteIndex == endByte) {
+      temp_res = (int64_t)((uint64_t)temp_res << (8 - endBit)) | data[endByte] >> endBit;
+    }
+    else temp_res = (int64_t)((uint64_t)temp_res << 8) | data[byteIndex];
+  }
+  result = temp_res;
+}
+
+static void legacyApply(const benchFrame &msg) {
+  legacyFiltered = 0;
+  for (int i = 0; i < LEGACYSWFCOUNT; i++) {
+    if (legacyGetSettingValue(L_SWFSW, i) != false && msg.id == (uint32_t)legacyGetSettingValue(L_SWFID, i)
+        && legacyLen[i] != 0) {
+      legacyFiltered |= (1 << i);
+      bool sign = legacyGetSettingValue(L_SWFSU, i);
+      uint8_t startByte = legacyGetSettingValue(L_SWFSB, i);
+      uint8_t startBit = legacyGetSettingValue(L_SWFSI, i);
+      uint8_t endByte = legacyGetSettingValue(L_SWFEB, i);
+      uint8_t endBit = legacyGetSettingValue(L_SWFEI, i);
+      legacyExtractBits(msg.buf, sign, startByte, startBit, endByte, endBit, legacyValue[i]);
+    }
+  }
+}
+
+// **************************************************************************************************************
+// plan (FLCM1.ino compileSoftwareFilter()/applySoftwareFilter()と同じ構成)
+// **************************************************************************************************************
+#define PLANHASHSIZE    (2 * LEGACYSWFCOUNT)
+#define PLANHASHMASK    (PLANHASHSIZE - 1)
+static canSoftwareFilterPlan plans[LEGACYSWFCOUNT];
+static uint8_t planCount;
+static uint8_t hashIndex[PLANHASHSIZE];
+static uint32_t hashId[PLANHASHSIZE];
+static int64_t planValue[LEGACYSWFCOUNT];
+static uint8_t planFiltered;
+
+static inline uint8_t planHash(uint32_t id) {
+  return (uint8_t)((id * 2654435761UL) >> 24) & PLANHASHMASK;
+}
+
+static void planCompile() {
+  planCount = 0;
+  for (int i = 0; i < LEGACYSWFCOUNT; i++) {
+    SoftwareFilter swf;
+    memset(&swf, 0, sizeof(swf));
+    swf.canID = legacySwf[i].canID;
+    swf.onoff = legacySwf[i].onoff;
+    swf.sign = legacySwf[i].sign;
+    swf.byteOrder = SWFBO_MOTOROLA;
+    swf.startByte = legacySwf[i].startByte;
+    swf.startBit = legacySwf[i].startBit;
+    swf.endByte = legacySwf[i].endByte;
+    swf.endBit = legacySwf[i].endBit;
+    uint8_t len;
+    if (swf.onoff && compileSwfPlan(plans[planCount], swf, i, &len)) planCount++;
+  }
+  for (int i = 1; i < planCount; i++) {         // ID順
+    canSoftwareFilterPlan tmp = plans[i];
+    int j = i - 1;
+    for (; j >= 0 && plans[j].id > tmp.id; j--) plans[j + 1] = plans[j];
+    plans[j + 1] = tmp;
+  }
+  memset(hashIndex, 0, sizeof(hashIndex));
+  for (uint8_t i = 0; i < planCount; i++) {
+    if (i > 0 && plans[i - 1].id == plans[i].id) continue;
+    uint8_t h = planHash(plans[i].id);
+    while (hashIndex[h] != 0) h = (h + 1) & PLANHASHMASK;
+    hashId[h] = plans[i].id;
+    hashIndex[h] = i + 1;
+  }
+}
+
+static uint8_t planLookup(uint32_t id) {
+  for (uint8_t h = planHash(id), n = 0; n < PLANHASHSIZE; h = (h + 1) & PLANHASHMASK, n++) {
+    if (hashIndex[h] == 0) return 0;
+    if (hashId[h] == id) return hashIndex[h];
+  }
+  return 0;
+}
+
+static void planApply(const benchFrame &msg) {
+  planFiltered = 0;
+  uint8_t first = planLookup(msg.id);
+  if (first == 0) return;
+  uint64_t data[2];
+  data[SWFBO_INTEL] = loadMsgData64(msg.buf);
+  data[SWFBO_MOTOROLA] = __builtin_bswap64(data[SWFBO_INTEL]);
+  for (int i = first - 1; i < planCount && plans[i].id == msg.id; i++) {
+    const canSoftwareFilterPlan &plan = plans[i];
+    planFiltered |= 1 << plan.swfNum;
+    planValue[plan.swfNum] = extractSwfValue(plan, data);
+  }
+}
+
+// **************************************************************************************************************
+static uint32_t rng = 1;
+static uint32_t nextRand() {
+  rng = rng * 1103515245 + 12345;
+  return rng >> 8;
+}
+
+static void setupSwf(int n, uint32_t id, bool sign, int sb, int si, int eb, int ei) {
+  legacySwf[n].canID = id;
+  legacySwf[n].onoff = true;
+  legacySwf[n].sign = sign;
+  legacySwf[n].startByte = sb;
+  legacySwf[n].startBit = si;
+  legacySwf[n].endByte = eb;
+  legacySwf[n].endBit = ei;
+  legacyLen[n] = 1;                             // calcLen()の結果 (0以外なら有効)
+}
+
+static double runNs(void (*apply)(const benchFrame &), uint64_t *checksum) {
+  uint64_t sum = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int loop = 0; loop < BENCHLOOPS; loop++) {
+    for (int f = 0; f < BENCHFRAMES; f++) {
+      apply(frames[f]);
+      if (apply == legacyApply) sum += legacyFiltered + (uint64_t)legacyValue[f & 7];
+      else sum += planFiltered + (uint64_t)planValue[f & 7];
+    }
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  *checksum = sum;
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / ((double)BENCHLOOPS * BENCHFRAMES);
+}
+
+int main() {
+  // 4 IDに8 SWF (1byte, 2byte, 12bit signed, 4byte, 8byte)
+  setupSwf(0, 0x0C9, false, 0, 7, 0, 0);
+  setupSwf(1, 0x0C9, false, 2, 7, 3, 0);
+  setupSwf(2, 0x1F5, true, 1, 3, 2, 0);
+  setupSwf(3, 0x1F5, false, 4, 7, 7, 0);
+  setupSwf(4, 0x3E9, true, 0, 7, 7, 0);
+  setupSwf(5, 0x3E9, false, 6, 5, 6, 2);
+  setupSwf(6, 0x4C1, false, 0, 7, 1, 0);
+  setupSwf(7, 0x4C1, true, 5, 7, 7, 4);
+  planCompile();
+  CHECK_EQ(planCount, LEGACYSWFCOUNT);
+
+  // 半分は監視中のID、半分はその他のID
+  static const uint32_t watched[] = {0x0C9, 0x1F5, 0x3E9, 0x4C1};
+  for (int f = 0; f < BENCHFRAMES; f++) {
+    frames[f].id = (f & 1) ? watched[nextRand() & 3] : (nextRand() & 0x7FF);
+    for (int i = 0; i < 8; i++) frames[f].buf[i] = (uint8_t)nextRand();
+  }
+  // 同じ値を抽出すること
+  for (int f = 0; f < BENCHFRAMES; f++) {
+    legacyApply(frames[f]);
+    planApply(frames[f]);
+    CHECK_EQ(legacyFiltered, planFiltered);
+    for (int i = 0; i < LEGACYSWFCOUNT; i++) {
+      if ((planFiltered >> i) & 1) CHECK_EQ(legacyValue[i], planValue[i]);
+    }
+  }
+
+  uint64_t sumLegacy, sumPlan;
+  runNs(legacyApply, &sumLegacy);               // warm up
+  double nsLegacy = runNs(legacyApply, &sumLegacy);
+  double nsPlan = runNs(planApply, &sumPlan);
+  CHECK(sumLegacy == sumPlan);
+  printf("  swf filter (8 SWF, 4 IDs, 50%% watched frames, host):\n");
+  printf("    legacy: %7.1f ns/frame %10.0f frames/s\n", nsLegacy, 1e9 / nsLegacy);
+  printf("    plan:   %7.1f ns/frame %10.0f frames/s  x%.1f\n", nsPlan, 1e9 / nsPlan, nsLegacy / nsPlan);
+  return TEST_RESULT("bench_swffilter");
+}
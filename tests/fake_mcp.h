@@ -0,0 +1,101 @@
+// tests/ 共通の模擬MCP25625 (READ STATUS / RX STATUS / READ / READ RX BUFFER)
+// SPIClass::transfer()とCSのdigitalWrite()の裏に置く。mcpLoad()でRXバッファに受信させる
+// RX STATUS bit2-0は最後に受信したバッファのfilter hit (RXB1へのrolloverは6,7)
+#ifndef _FAKE_MCP_H_
+#define _FAKE_MCP_H_
+
+#include "mcp25625_can.h"
+
+#define PIN_MCP_CS      7
+
+struct fakeMcp {
+  uint8_t rxb[2][MCP_RXBUF_RAWLEN];   // SIDH,SIDL,EID8,EID0,DLC,D0-D7
+  uint8_t filhit[2];                  // RXF0-5
+  bool full[2];
+  uint8_t lastFilhit;                 // RX STATUS bit2-0
+  bool cs;                            // true: 選択中
+  uint8_t instruction;
+  uint8_t address;                    // READ
+  uint8_t count;                      // 選択後のbyte数
+};
+static fakeMcp mcp;
+static bool dmaActive = false;
+static uint32_t cpuBytes = 0, dmaBytes = 0;
+
+static void mcpPin(int pin, int value) {
+  if (pin != PIN_MCP_CS) return;
+  if (value == LOW) {
+    mcp.cs = true;
+    mcp.count = 0;
+  }
+  else if (mcp.cs) {
+    mcp.cs = false;
+    // READ RX BUFFERはCSを上げた時にRXnIFをclearする
+    if (mcp.instruction == MCP_READ_RX0 && mcp.count > 1) mcp.full[0] = false;
+    if (mcp.instruction == MCP_READ_RX1 && mcp.count > 1) mcp.full[1] = false;
+  }
+}
+
+static inline uint8_t mcpReadRegister(uint8_t address) {
+  if (address == MCP_RXB0CTRL) return mcp.filhit[0] & MCP_RXB_FILHIT0_M;
+  if (address == MCP_RXB1CTRL) return mcp.filhit[1] & MCP_RXB_FILHIT_M;
+  return 0;
+}
+
+SPIClass SPI;
+uint8_t SPIClass::transfer(uint8_t data) {
+  if (dmaActive) dmaBytes++;
+  else cpuBytes++;
+  if (!mcp.cs) return 0xFF;
+  uint8_t n = mcp.count++;
+  if (n == 0) {
+    mcp.instruction = data;
+    return 0xFF;
+  }
+  switch (mcp.instruction) {
+    case MCP_READ_STATUS: return (mcp.full[0] ? MCP_STAT_RX0IF : 0) | (mcp.full[1] ? MCP_STAT_RX0IF << 1 : 0);
+    case MCP_RX_STATUS:   return (mcp.full[0] ? MCP_RXSTAT_RXB0 : 0) | (mcp.full[1] ? MCP_RXSTAT_RXB1 : 0) |
+                                 mcp.lastFilhit;
+    case MCP_READ:
+      if (n == 1) {
+        mcp.address = data;
+        return 0xFF;
+      }
+      return mcpReadRegister(mcp.address++);
+    case MCP_READ_RX0:    return (n <= MCP_RXBUF_RAWLEN) ? mcp.rxb[0][n - 1] : 0xFF;
+    case MCP_READ_RX1:    return (n <= MCP_RXBUF_RAWLEN) ? mcp.rxb[1][n - 1] : 0xFF;
+    default:              return 0xFF;
+  }
+}
+
+// MCPのRXB nへ入れる (SIDH,SIDL,EID8,EID0,DLC,data) filhit: RXF0-5
+// RXF0/1はRXB0、RXB0が満杯ならRXB1へrollover (BUKT)。RXF2-5はRXB1へ直行する
+static void mcpLoad(int n, const canMessageSet &m, uint8_t filhit = 0) {
+  uint8_t *r = mcp.rxb[n];
+  memset(r, 0, MCP_RXBUF_RAWLEN);
+  if (m.ext) {
+    r[MCP_SIDH] = (uint8_t)(m.id >> 21);
+    r[MCP_SIDL] = (uint8_t)((((m.id >> 18) & 0x07) << 5) | MCP_TXB_EXIDE_M | ((m.id >> 16) & 0x03));
+    r[MCP_EID8] = (uint8_t)(m.id >> 8);
+    r[MCP_EID0] = (uint8_t)m.id;
+  }
+  else {
+    r[MCP_SIDH] = (uint8_t)(m.id >> 3);
+    r[MCP_SIDL] = (uint8_t)((m.id & 0x07) << 5);
+  }
+  r[4] = m.len;
+  memcpy(&r[5], m.buf, m.len);
+  mcp.full[n] = true;
+  mcp.filhit[n] = filhit;
+  mcp.lastFilhit = (n == 1 && filhit < 2) ? filhit + 6 : filhit;
+}
+
+// RXF0/1のフレームをBUKT rollover込みで受信する。両方満杯ならfalse (overrun)
+static inline bool mcpReceive(const canMessageSet &m, uint8_t filhit) {
+  int n = (filhit >= 2 || mcp.full[0]) ? 1 : 0;
+  if (mcp.full[n]) return false;
+  mcpLoad(n, m, filhit);
+  return true;
+}
+
+#endif
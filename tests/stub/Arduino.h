@@ -0,0 +1,43 @@
+// Host build stub of the Arduino core for tests/ (FL_xxx modules only)
+#ifndef _HOST_ARDUINO_H_
+#define _HOST_ARDUINO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+#define HIGH            1
+#define LOW             0
+#define INPUT           0
+#define OUTPUT          1
+
+// 割込禁止の入口でhostIrqHookを1回呼ぶ。ISRが割込禁止の直前に入った場合を再現する
+extern void (*hostIrqHook)();
+extern int hostIrqDisabled;
+inline void noInterrupts() {
+  if (hostIrqHook && hostIrqDisabled == 0) {
+    void (*hook)() = hostIrqHook;
+    hostIrqHook = NULL;
+    hook();
+  }
+  hostIrqDisabled++;
+}
+inline void interrupts() { hostIrqDisabled--; }
+
+unsigned long millis();
+unsigned long micros();
+inline void pinMode(int, int) {}
+// digitalWrite()はhostPinHookがあれば呼ぶ (SPIの模擬デバイスがCSを見る)
+extern void (*hostPinHook)(int pin, int value);
+inline void digitalWrite(int pin, int value) { if (hostPinHook) hostPinHook(pin, value); }
+// SWFOPCOUNT(kind, n) の計測先 (FL_swfplan.h) -DSWFOPCOUNTでビルドしたtestだけが使う
+extern uint32_t hostOpCount[8];
+inline void delay(unsigned long) {}
+inline void delayMicroseconds(unsigned int) {}
+
+#endif
@@ -0,0 +1,23 @@
+// Host build stub of SPI.h for tests/ (型だけ)
+#ifndef _HOST_SPI_H_
+#define _HOST_SPI_H_
+
+#include <Arduino.h>
+
+#define MSBFIRST        1
+#define SPI_MODE0       0
+class SPISettings {
+public:
+  SPISettings() {}
+  SPISettings(uint32_t, uint8_t, uint8_t) {}
+};
+class SPIClass {
+public:
+  void begin() {}
+  void beginTransaction(SPISettings) {}
+  void endTransaction() {}
+  uint8_t transfer(uint8_t data);         // testが定義する
+};
+extern SPIClass SPI;
+
+#endif
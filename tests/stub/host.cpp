@@ -0,0 +1,19 @@
+// Host build stub: Arduino coreの実体
+#include <Arduino.h>
+#include <chrono>
+
+void (*hostIrqHook)() = NULL;
+int hostIrqDisabled = 0;
+void (*hostPinHook)(int pin, int value) = NULL;
+uint32_t hostOpCount[8];
+
+static std::chrono::steady_clock::time_point hostStart = std::chrono::steady_clock::now();
+
+unsigned long micros() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - hostStart).count();
+}
+
+unsigned long millis() {
+  return micros() / 1000;
+}
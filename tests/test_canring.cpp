@@ -0,0 +1,334 @@
+// CanFrameRing host test
+// 1. drop-oldest / drop-newest の格納順とcounter
+// 2. pop()のコピー中にISRが最古を捨てた場合のtail再読出 (noInterrupts()の直前にISRを割り込ませる)
+// 3. 100% bus load (bit stuffingなしの最短フレーム, standard DLC0のburstを含む) のtraceを模擬MCP25625に流し、
+//    RXバッファのoverrunが0であること。ISRの時間はRX STATUS + 14bytes DMA + callback + critical CO判定の
+//    見積りから求める (比較として、ringなしでpostLine()の合間にだけMCPを読む旧構成のoverrun数も出す)
+#include "FL_canring.h"
+#include "FL_comparator.h"     // CRITWCETUS
+#include "test_check.h"
+
+static CanFrameRing ring;
+static uint32_t isrSeq = 0;
+
+// ISR相当: 1フレームをringに入れる。timestampに通し番号を入れて順序を確認する
+static void isrPush() {
+  canMessageSet *slot = ring.reserve();
+  slot->id = 0x100 + (isrSeq & 0xFF);
+  slot->ext = 0;
+  slot->len = 8;
+  memset(slot->buf, (uint8_t)isrSeq, sizeof(slot->buf));
+  slot->timestamp = isrSeq++;
+  ring.commit();
+}
+
+static void resetRing(eRingPolicy policy) {
+  ring.clear();
+  ring.setPolicy(policy);
+  ring.resetCounters();
+  isrSeq = 0;
+}
+
+static void testDropOldest() {
+  resetRing(RING_DROP_OLDEST);
+  for (int i = 0; i < CANRINGSIZE + 10; i++) isrPush();
+  CHECK_EQ(ring.count(), CANRINGSIZE);
+  CHECK_EQ(ring.getOverflowCount(), 10);
+  CHECK_EQ(ring.getPushedCount(), CANRINGSIZE + 10);
+  CHECK_EQ(ring.getHighWater(), CANRINGSIZE);
+  canMessageSet msg;
+  for (uint32_t seq = 10; seq < CANRINGSIZE + 10; seq++) {
+    CHECK(ring.pop(msg));
+    CHECK_EQ(msg.timestamp, seq);
+    CHECK_EQ(msg.buf[7], (uint8_t)seq);
+  }
+  CHECK(!ring.pop(msg));
+  CHECK(ring.isEmpty());
+}
+
+static void testDropNewest() {
+  resetRing(RING_DROP_NEWEST);
+  for (int i = 0; i < CANRINGSIZE + 6; i++) isrPush();
+  CHECK_EQ(ring.count(), CANRINGSIZE);
+  CHECK_EQ(ring.getOverflowCount(), 6);
+  CHECK_EQ(ring.getPushedCount(), CANRINGSIZE);
+  canMessageSet msg;
+  for (uint32_t seq = 0; seq < CANRINGSIZE; seq++) {
+    CHECK(ring.pop(msg));
+    CHECK_EQ(msg.timestamp, seq);
+  }
+  CHECK(!ring.pop(msg));
+  // 空きができれば次のフレームは格納される
+  isrPush();
+  CHECK(ring.pop(msg));
+  CHECK_EQ(msg.timestamp, CANRINGSIZE + 6);
+}
+
+// 満杯のringでpop()がslotをコピーした後、tailの確認前にISRが最古を捨てる
+static void testTailRetry() {
+  resetRing(RING_DROP_OLDEST);
+  for (int i = 0; i < CANRINGSIZE; i++) isrPush();
+  hostIrqHook = isrPush;
+  canMessageSet msg;
+  CHECK(ring.pop(msg));
+  CHECK(hostIrqHook == NULL);
+  CHECK_EQ(msg.timestamp, 1);               // 捨てられたseq 0ではなく次の最古
+  CHECK_EQ(ring.getOverflowCount(), 1);
+  CHECK_EQ(ring.count(), CANRINGSIZE - 1);
+  ring.clear();
+  CHECK(ring.isEmpty());
+}
+
+// pop()毎に0-3フレームのISRを割り込ませ、取り出す順序が単調増加で重複しないこと
+static uint32_t burstLeft = 0;
+static uint32_t rng = 12345;
+static uint32_t nextRand() {
+  rng = rng * 1103515245 + 12345;
+  return rng >> 16;
+}
+static void isrBurst() {
+  while (burstLeft > 0) {
+    burstLeft--;
+    isrPush();
+  }
+}
+
+static void testPreemptionStress() {
+  resetRing(RING_DROP_OLDEST);
+  for (int i = 0; i < CANRINGSIZE; i++) isrPush();
+  canMessageSet msg;
+  uint32_t last = 0, popped = 0;
+  bool first = true;
+  for (int n = 0; n < 100000; n++) {
+    burstLeft = nextRand() & 3;
+    hostIrqHook = isrBurst;
+    if (ring.pop(msg)) {
+      if (!first) CHECK(msg.timestamp > last);
+      last = msg.timestamp;
+      first = false;
+      popped++;
+    }
+    hostIrqHook = NULL;
+    isrBurst();
+  }
+  while (ring.pop(msg)) {
+    CHECK(msg.timestamp > last);
+    last = msg.timestamp;
+    popped++;
+  }
+  CHECK_EQ(popped + ring.getOverflowCount(), isrSeq);
+  CHECK_EQ(last, isrSeq - 1);               // 最新のフレームは必ず残る
+}
+
+// **************************************************************************************************************
+// 100% bus load simulation
+// **************************************************************************************************************
+#define SIMTIMEUS       2000000     // 2s
+#define SIMBURSTUS      500000      // 先頭0.5sはstandard DLC0だけを隙間なく流す (受信数が最大)
+#define SIMDISPUS       3000        // postLine() 1行の描画時間 (最短)
+#define SIMRXBCOUNT     2           // MCP25625 RXB0/RXB1
+#define SIMCRITCOS      4           // PIN_COCOUNT: 全フレームが全critical COのIDに一致する最悪値
+
+// 受信1フレームの処理時間 (MCP_RX_DMA 1) Cortex-M0+ 48MHz, SPI 8MHz (MCP25625_SPI_SETTINGS)
+// cycle数は見積り (実機の値ではない)。critical COの判定はFL_comparator.hのCRITWCETUS()
+#define SIMCPUMHZ       48
+#define SIMSPIMHZ       8
+#define SIMUS(cycles)   (((cycles) + SIMCPUMHZ - 1) / SIMCPUMHZ)
+#define SIMSPIUS(bytes) (((bytes) * 8 + SIMSPIMHZ - 1) / SIMSPIMHZ)
+// MCP25625_ISR: 割込の出入り + timebaseNow() + RX STATUS (2bytes, CS/transaction込み) + DMA開始
+#define SIMSTATUSUS     (SIMUS(400) + SIMSPIUS(2))
+// READ RX BUFFER 14bytes (instruction + SIDH..D7) のDMA。CSが上がるとRXバッファが空く
+#define SIMDMAUS        SIMSPIUS(14)
+// mcpsddma_callback: DMAC割込の出入り + parseRxBuffer + ringへのcopy/commit + endTransaction
+#define SIMCALLBACKUS   SIMUS(350)
+// evalCriticalComparators: CRITWCETUS + timebaseNow() 2回と統計
+#define SIMCRITUS(cos)  ((cos) ? CRITWCETUS(cos) + SIMUS(120) : SIMUS(20))
+#define SIMREADUS       (SIMSTATUSUS + SIMDMAUS)                  // ISR開始からRXバッファ解放まで
+#define SIMISRUS(cos)   (SIMREADUS + SIMCALLBACKUS + SIMCRITUS(cos))  // ISR開始から次のISRを受けられるまで
+// loop側の割込禁止区間の最悪値 (CAN割込の開始がこれだけ遅れる)
+// compileComparators(): critical COの状態引継ぎ (COOUTMAX^2回の比較) + criticalComparatorSetのcopy
+#define SIMMASKCOMPILEUS SIMUS(COOUTMAX * COOUTMAX * 60 + COOUTMAX * sizeof(criticalComparator) / 2 + 100)
+// 'w' (benchCriticalComparators): 1回分のrunCriticalComparators()を割込禁止で測る
+#define SIMMASKBENCHUS  (CRITWCETUS(SIMCRITCOS) + SIMUS(100))
+// loopのMCPアクセス (READ EFLG 3bytes) はmcpsdSPI.usingInterrupt()でCAN割込を止める
+#define SIMMASKEFLGUS   (SIMUS(300) + SIMSPIUS(3))
+#define SIMMAX(a, b)    ((a) > (b) ? (a) : (b))
+#define SIMMASKUS       SIMMAX(SIMMASKCOMPILEUS, SIMMAX(SIMMASKBENCHUS, SIMMASKEFLGUS))
+
+// 隙間なく並んだフレームの終了時刻の列。受信数が最大になるようbit stuffingなしの最短のフレーム長で並べる
+struct simFrame {
+  uint32_t endUs;
+  uint32_t id;
+  uint8_t ext;
+  uint8_t len;
+};
+
+static uint32_t simFrameBits(uint8_t ext, uint8_t len) {
+  uint32_t bits = (ext ? 54 : 34) + 8 * len;      // SOF..CRC
+  return bits + 10 + 3;                           // CRC delim/ACK/EOF + IFS (stuff bitなし)
+}
+
+static int buildTrace(simFrame *trace, int maxCount, uint32_t bitUs) {
+  uint32_t t = 0;
+  int n = 0;
+  rng = 1;
+  while (n < maxCount) {
+    uint8_t ext = (nextRand() & 3) == 0;
+    uint8_t len = nextRand() % 9;
+    if ((nextRand() & 7) == 0) len = 0;           // 最短フレームを多めに混ぜる
+    if (t < SIMBURSTUS) {
+      ext = 0;
+      len = 0;
+    }
+    t += simFrameBits(ext, len) * bitUs;
+    if (t > SIMTIMEUS) break;
+    trace[n].endUs = t;
+    trace[n].id = ext ? (nextRand() << 8) & 0x1FFFFFFF : nextRand() & 0x7FF;
+    trace[n].ext = ext;
+    trace[n].len = len;
+    n++;
+  }
+  return n;
+}
+
+// MCP25625のRXバッファ: 受信完了時に空きがなければoverrun
+struct simMcp {
+  int rxb[SIMRXBCOUNT];     // trace index (FIFO)
+  uint32_t arrive[SIMRXBCOUNT];
+  int count;
+  uint32_t overrun;
+};
+
+static bool mcpReceive(simMcp &mcp, int frame, uint32_t t) {
+  if (mcp.count == SIMRXBCOUNT) {
+    mcp.overrun++;
+    return false;
+  }
+  mcp.rxb[mcp.count] = frame;
+  mcp.arrive[mcp.count] = t;
+  mcp.count++;
+  return true;
+}
+
+static int mcpRelease(simMcp &mcp) {
+  int frame = mcp.rxb[0];
+  for (int i = 1; i < mcp.count; i++) {
+    mcp.rxb[i - 1] = mcp.rxb[i];
+    mcp.arrive[i - 1] = mcp.arrive[i];
+  }
+  mcp.count--;
+  return frame;
+}
+
+static simFrame trace[SIMTIMEUS / 47 + 1];       // 1Mbps
+
+// ring構成: ISRが受信毎にMCPを読んでringに入れ、loopは1行SIMDISPUSで描画しながらpopする
+// ISRはCAN割込のpendingからSIMMASKUS遅れて始まり、SIMREADUSでRXバッファを空け、
+// critical COの判定を終えるSIMISRUSまで次のフレームのISRは始まらない
+static uint32_t testBusLoadRing(int frames, uint32_t isrUs, bool fCheck) {
+  resetRing(RING_DROP_OLDEST);
+  simMcp mcp = {};
+  uint32_t readDone = 0, isrDone = 0;
+  bool reading = false;
+  uint32_t loopNext = 0, popped = 0, last = 0, pushed = 0;
+  bool first = true;
+  int next = 0;
+  for (uint32_t t = 0; t <= SIMTIMEUS + SIMDISPUS; t++) {
+    if (reading && t == readDone) {         // CSが上がってRXバッファが空く -> ringへ
+      int frame = mcpRelease(mcp);
+      canMessageSet *slot = ring.reserve();
+      slot->id = trace[frame].id;
+      slot->ext = trace[frame].ext;
+      slot->len = trace[frame].len;
+      slot->timestamp = frame;
+      ring.commit();
+      pushed++;
+      reading = false;
+    }
+    if (next < frames && trace[next].endUs == t) {
+      mcpReceive(mcp, next, t);
+      next++;
+    }
+    if (!reading && t >= isrDone && mcp.count > 0 && t >= mcp.arrive[0] + SIMMASKUS) {
+      reading = true;
+      readDone = t + SIMREADUS;
+      isrDone = t + isrUs;
+    }
+    if (t >= loopNext) {                    // loop: 1フレーム取り出して描画
+      canMessageSet msg;
+      if (ring.pop(msg)) {
+        if (!first) CHECK(msg.timestamp > last);
+        last = msg.timestamp;
+        first = false;
+        popped++;
+        loopNext = t + SIMDISPUS;
+      }
+    }
+  }
+  CHECK_EQ(next, frames);
+  if (fCheck) {
+    CHECK_EQ(mcp.overrun, 0);
+    CHECK_EQ(ring.getPushedCount(), frames);
+  }
+  CHECK_EQ(ring.getPushedCount(), pushed);
+  CHECK_EQ(popped + ring.getOverflowCount() + ring.count(), pushed);
+  printf("  ring:   frames=%d isr_us=%lu rx_overrun=%lu ring_overflow=%lu displayed=%lu high_water=%u\n",
+         frames, (unsigned long)isrUs, (unsigned long)mcp.overrun, (unsigned long)ring.getOverflowCount(),
+         (unsigned long)popped, ring.getHighWater());
+  return mcp.overrun;
+}
+
+// 旧構成: loopがpostLine()の合間にだけMCPを1フレーム読む
+static void testBusLoadLegacy(int frames) {
+  simMcp mcp = {};
+  uint32_t loopNext = 0;
+  int next = 0;
+  for (uint32_t t = 0; t <= SIMTIMEUS; t++) {
+    if (next < frames && trace[next].endUs == t) {
+      mcpReceive(mcp, next, t);
+      next++;
+    }
+    if (t >= loopNext && mcp.count > 0) {
+      mcpRelease(mcp);
+      loopNext = t + SIMISRUS(0) + SIMDISPUS;
+    }
+  }
+  CHECK(mcp.overrun > 0);
+  printf("  legacy: frames=%d rx_overrun=%lu\n", frames, (unsigned long)mcp.overrun);
+}
+
+// bitUs [us]: 2=500kbps 1=1Mbps
+static int buildLoadTrace(uint32_t bitUs) {
+  int frames = buildTrace(trace, sizeof(trace) / sizeof(trace[0]), bitUs);
+  CHECK(frames > 0);
+  CHECK(trace[frames - 1].endUs > SIMTIMEUS - simFrameBits(1, 8) * bitUs);  // bus idleなし
+  // DLC0 burstの受信数 [frames/s]: 500kbpsで約10.6k
+  int burst = 0;
+  while (burst < frames && trace[burst].endUs <= SIMBURSTUS) burst++;
+  uint32_t rate = (uint64_t)burst * 1000000 / SIMBURSTUS;
+  CHECK(rate >= 1000000 / (simFrameBits(0, 0) * bitUs) - 1);
+  printf("  trace:  %lukbps frames=%d burst_fps=%lu min_frame_us=%lu\n", (unsigned long)(1000 / bitUs), frames,
+         (unsigned long)rate, (unsigned long)(simFrameBits(0, 0) * bitUs));
+  return frames;
+}
+
+int main() {
+  testDropOldest();
+  testDropNewest();
+  testTailRetry();
+  testPreemptionStress();
+  printf("  path:   read_us=%d isr_us=%d (crit %d cos) isr_us=%d (no crit) mask_us=%d\n", (int)SIMREADUS,
+         (int)SIMISRUS(SIMCRITCOS), SIMCRITCOS, (int)SIMISRUS(0), (int)SIMMASKUS);
+  // 500kbps (CANSPEEDDEFAULT): 最悪のcritical CO判定込みでoverrunなし
+  int frames = buildLoadTrace(2);
+  CHECK(SIMISRUS(SIMCRITCOS) < simFrameBits(0, 0) * 2);
+  testBusLoadRing(frames, SIMISRUS(SIMCRITCOS), true);
+  testBusLoadLegacy(frames);
+  // 1Mbps: critical COなしならoverrunなし
+  // 全フレームが4 critical COに一致するとISRが最短フレームより長く、DLC0 burstを受けきれない (表示のみ)
+  frames = buildLoadTrace(1);
+  CHECK(SIMISRUS(0) < simFrameBits(0, 0));
+  testBusLoadRing(frames, SIMISRUS(0), true);
+  testBusLoadRing(frames, SIMISRUS(SIMCRITCOS), false);
+  return TEST_RESULT("test_canring");
+}
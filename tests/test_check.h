@@ -0,0 +1,17 @@
+// tests/ 共通の簡易assert
+#ifndef _TEST_CHECK_H_
+#define _TEST_CHECK_H_
+
+#include <stdio.h>
+
+static int checkFailed = 0;
+#define CHECK(cond) do { \
+    if (!(cond)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); checkFailed++; } \
+  } while (0)
+#define CHECK_EQ(a, b) do { \
+    long long va_ = (long long)(a), vb_ = (long long)(b); \
+    if (va_ != vb_) { printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, va_, vb_); checkFailed++; } \
+  } while (0)
+#define TEST_RESULT(name) (printf("%s: %s\n", name, checkFailed ? "FAILED" : "ok"), checkFailed ? 1 : 0)
+
+#endif
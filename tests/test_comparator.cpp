@@ -0,0 +1,331 @@
+// Comparator step / critical CO fast path test
+// 1. stepComparator(): hysteresis, on/off delay, COLM level/latch/toggle, COPOLのset/clr mask
+// 2. comparatorSameConfig(): 状態の違いは無視して設定の違いだけを見る, comparatorCopyState()
+// 3. runCriticalComparators(): ID/mux不一致は出力もlatencyも変えない
+// 4. 最悪の経路 (4 critical COが同じID, mux一致, Motorola 48bit signed, scaling, 毎フレーム出力反転) で
+//    1フレームの64bit演算数がCRITOPxxx * CO数 (+ bswap 1回) 以下であること
+// 5. ランダムなSWF設定/dataで、1 COあたりの演算数がどのscaling経路でもCRITOPxxx以下であること
+// 演算数はSWFOPCOUNT (-DSWFOPCOUNTでhostOpCount[]に積む) で数え、CRITWCETUS()の見積りを表示する
+#include "FL_comparator.h"
+#include "test_check.h"
+
+static uint32_t hostNow = 0;
+uint32_t timebaseNow() { return hostNow; }
+
+static volatile uint32_t outSetReg[COOUTMAX], outClrReg[COOUTMAX];   // CO毎のPORT OUTSET/OUTCLR
+
+static void clearOps() { memset(hostOpCount, 0, sizeof(hostOpCount)); }
+
+static void resetOut(comparatorOutputState &out) {
+  for (int i = 0; i < COOUTMAX; i++) {
+    out.state[i] = -1;
+    out.changeTime[i] = out.latency[i] = out.latencyMax[i] = 0;
+  }
+}
+
+static void initPlan(comparatorPlan &plan, uint8_t coNum, int64_t threshold, int64_t hys, uint8_t latchMode) {
+  memset(&plan, 0, sizeof(plan));
+  plan.threshold = threshold;
+  plan.thresholdOff = threshold - hys;
+  plan.latchMode = latchMode;
+  plan.pinMask = 1UL << (8 + coNum);
+  plan.coNum = coNum;
+}
+
+// valueを受信時刻tに判定して出力(COPOL適用前)を返す
+static bool step(comparatorPlan &plan, comparatorOutputState &out, int64_t value, uint32_t t) {
+  uint32_t set[COPORTMAX] = {0, 0}, clr[COPORTMAX] = {0, 0};
+  stepComparator(plan, comparatorCond(plan, value), t, set, clr, out);
+  CHECK_EQ(set[0] | clr[0], plan.pinMask);    // 毎回どちらか一方に必ず書く
+  CHECK_EQ(set[0] & clr[0], 0);
+  CHECK_EQ(set[0] == plan.pinMask, plan.out ^ (plan.polMask != 0));
+  return plan.out;
+}
+
+static void testLevelHysteresis() {
+  comparatorOutputState out;
+  resetOut(out);
+  comparatorPlan plan;
+  initPlan(plan, 1, 100, 10, COLM_LEVEL);
+  CHECK(!step(plan, out, 99, 0));
+  CHECK_EQ(out.state[1], 0);
+  CHECK(step(plan, out, 100, 1));
+  CHECK(step(plan, out, 91, 2));              // threshold - hys までは成立のまま
+  CHECK(step(plan, out, 90, 3));
+  CHECK(!step(plan, out, 89, 4));
+  CHECK(!step(plan, out, 99, 5));             // 解除後はthresholdまで不成立
+  plan.polMask = plan.pinMask;                // COPOL: 比較結果を反転してPORTに出す
+  CHECK(step(plan, out, 100, 6));
+  CHECK_EQ(out.state[1], 1);
+}
+
+static void testDelay() {
+  comparatorOutputState out;
+  resetOut(out);
+  comparatorPlan plan;
+  initPlan(plan, 0, 0, 0, COLM_LEVEL);
+  plan.onDelay = 1000;
+  plan.offDelay = 500;
+  CHECK(!step(plan, out, 1, 10000));
+  CHECK(plan.pending);
+  CHECK(!step(plan, out, 1, 10999));
+  CHECK(step(plan, out, 1, 11000));           // 最初に成立したフレームから1000us
+  CHECK(!plan.pending);
+  CHECK(step(plan, out, -1, 12000));
+  CHECK(step(plan, out, 1, 12400));           // 途中で戻ればoff delayはやり直し
+  CHECK(step(plan, out, -1, 12600));
+  CHECK(step(plan, out, -1, 13099));
+  CHECK(!step(plan, out, -1, 13100));
+  // timestampが一周しても差で判定する
+  CHECK(!step(plan, out, 1, 0xFFFFFF00));
+  CHECK(step(plan, out, 1, 0xFFFFFF00 + 1000));
+}
+
+static void testLatchToggle() {
+  comparatorOutputState out;
+  resetOut(out);
+  comparatorPlan latch, toggle;
+  initPlan(latch, 2, 0, 0, COLM_LATCH);
+  initPlan(toggle, 3, 0, 0, COLM_TOGGLE);
+  int64_t values[] = {-1, 1, 1, -1, 1, -1, -1, 1};
+  bool expToggle[] = {false, true, true, true, false, false, false, true};
+  for (int i = 0; i < 8; i++) {
+    CHECK_EQ(step(latch, out, values[i], i), i >= 1);
+    CHECK_EQ(step(toggle, out, values[i], i), expToggle[i]);
+  }
+}
+
+// planを作り直しても設定が同じなら状態を引き継ぎ、latchを保持したまま同じ値で出力が変わらない
+static void testKeepState() {
+  comparatorOutputState out;
+  resetOut(out);
+  comparatorPlan plan, rebuilt;
+  initPlan(plan, 0, 0, 0, COLM_LATCH);
+  plan.offDelay = 100;
+  CHECK(step(plan, out, 1, 0));
+  CHECK(step(plan, out, -1, 10));           // latch中, off delay計時中
+  CHECK(plan.pending);
+  initPlan(rebuilt, 0, 0, 0, COLM_LATCH);
+  rebuilt.offDelay = 100;
+  CHECK(comparatorSameConfig(rebuilt, plan));
+  comparatorCopyState(rebuilt, plan);
+  CHECK(rebuilt.out && rebuilt.pending && rebuilt.since == 10);
+  uint32_t set[COPORTMAX] = {0, 0}, clr[COPORTMAX] = {0, 0};
+  CHECK_EQ(stepComparator(rebuilt, comparatorCond(rebuilt, -1), 110, set, clr, out), 0);
+  CHECK(rebuilt.out);                       // latchは解除されない
+  CHECK(!rebuilt.pending);
+  rebuilt.port = 1;                         // port indexは比べない
+  CHECK(comparatorSameConfig(rebuilt, plan));
+  rebuilt.offDelay = 101;
+  CHECK(!comparatorSameConfig(rebuilt, plan));
+  rebuilt.offDelay = 100;
+  rebuilt.thresholdOff = -1;
+  CHECK(!comparatorSameConfig(rebuilt, plan));
+  rebuilt.thresholdOff = 0;
+  rebuilt.polMask = rebuilt.pinMask;
+  CHECK(!comparatorSameConfig(rebuilt, plan));
+  rebuilt.polMask = 0;
+  rebuilt.coNum = 1;
+  CHECK(!comparatorSameConfig(rebuilt, plan));
+}
+
+// **************************************************************************************************************
+// critical CO
+// **************************************************************************************************************
+// Motorola 48bit signed (byte2 bit7 - byte7 bit0), mux byte0 == 0x5A, factor 65535/3, offset -40
+static SoftwareFilter worstSwf() {
+  SoftwareFilter swf;
+  memset(&swf, 0, sizeof(swf));
+  swf.canID = 0x7FF;
+  swf.onoff = 1;
+  swf.sign = 1;
+  swf.byteOrder = SWFBO_MOTOROLA;
+  swf.startByte = 2;
+  swf.startBit = 7;
+  swf.endByte = 7;
+  swf.endBit = 0;
+  swf.factorMul = 65535;
+  swf.factorDiv = 3;
+  swf.offset = -40;
+  swf.muxEndByte = 0;
+  swf.muxEndBit = 0;
+  swf.muxLen = 8;
+  swf.muxValue = 0x5A;
+  return swf;
+}
+
+static void initCrit(criticalComparator &crit, const SoftwareFilter &swf, uint8_t coNum) {
+  uint8_t len;
+  CHECK(compileSwfPlan(crit.swf, swf, coNum, &len));
+  initPlan(crit.co, coNum, 0, 0, COLM_LEVEL);
+  crit.outSet = &outSetReg[coNum];
+  crit.outClr = &outClrReg[coNum];
+}
+
+// 2^47 - 1 (m=0) と -2^47 (m=1)
+static void worstMsg(canMessageSet &msg, int m) {
+  memset(&msg, 0, sizeof(msg));
+  msg.id = 0x7FF;
+  msg.len = 8;
+  msg.buf[0] = 0x5A;
+  msg.buf[2] = m ? 0x80 : 0x7F;
+  for (int b = 3; b < 8; b++) msg.buf[b] = m ? 0x00 : 0xFF;
+}
+
+static void testCriticalMismatch() {
+  comparatorOutputState out;
+  resetOut(out);
+  criticalComparator crit;
+  initCrit(crit, worstSwf(), 0);
+  canMessageSet msg;
+  worstMsg(msg, 0);
+  msg.id = 0x7FE;
+  clearOps();
+  CHECK(!runCriticalComparators(&crit, 1, msg, out));
+  CHECK_EQ(hostOpCount[SWFOP_CO], 0);
+  msg.id = 0x7FF;
+  msg.buf[0] = 0x5B;                          // mux不一致: IDは一致するが判定しない
+  CHECK(runCriticalComparators(&crit, 1, msg, out));
+  CHECK_EQ(out.state[0], -1);
+  CHECK_EQ(hostOpCount[SWFOP_MUL64], 0);
+}
+
+static void testCriticalKeepState() {
+  criticalComparator a, b;
+  initCrit(a, worstSwf(), 0);
+  initCrit(b, worstSwf(), 0);
+  CHECK(criticalComparatorSameConfig(a, b));
+  b.co.out = true;                            // 状態は比べない
+  CHECK(criticalComparatorSameConfig(a, b));
+  SoftwareFilter swf = worstSwf();
+  swf.offset = -41;                           // SWFのscalingが変われば状態を引き継がない
+  initCrit(b, swf, 0);
+  CHECK(!criticalComparatorSameConfig(a, b));
+  swf = worstSwf();
+  swf.muxValue = 0x5B;
+  initCrit(b, swf, 0);
+  CHECK(!criticalComparatorSameConfig(a, b));
+  initCrit(b, worstSwf(), 1);                 // 別のCO
+  CHECK(!criticalComparatorSameConfig(a, b));
+}
+
+static void testCriticalWorstCase() {
+  comparatorOutputState out;
+  resetOut(out);
+  criticalComparator crits[COOUTMAX];
+  SoftwareFilter swf = worstSwf();
+  for (int i = 0; i < COOUTMAX; i++) initCrit(crits[i], swf, i);
+  CHECK(crits[0].swf.scaled);
+  CHECK(crits[0].swf.scaleShift <= 32);       // overflow判定付き乗算の経路
+  CHECK(crits[0].swf.signShift == 16);
+  canMessageSet msg[2];
+  worstMsg(msg[0], 0);
+  worstMsg(msg[1], 1);
+  uint32_t worst[SWFOPKINDS] = {0};
+  for (int n = 0; n < 1000; n++) {
+    canMessageSet &m = msg[n & 1];
+    m.timestamp = hostNow;
+    hostNow += 7;
+    for (int i = 0; i < COOUTMAX; i++) outSetReg[i] = outClrReg[i] = 0;
+    clearOps();
+    CHECK(runCriticalComparators(crits, COOUTMAX, m, out));
+    for (int k = 0; k < SWFOPKINDS; k++) {
+      if (hostOpCount[k] > worst[k]) worst[k] = hostOpCount[k];
+    }
+    // 全COの出力が毎フレーム反転し、latencyを記録する
+    bool high = (n & 1) == 0;
+    for (int i = 0; i < COOUTMAX; i++) {
+      CHECK_EQ(outSetReg[i], high ? crits[i].co.pinMask : 0);
+      CHECK_EQ(outClrReg[i], high ? 0 : crits[i].co.pinMask);
+      CHECK_EQ(out.state[i], high);
+      CHECK_EQ(out.changeTime[i], m.timestamp);
+      CHECK_EQ(out.latency[i], 7);
+    }
+  }
+  CHECK_EQ(worst[SWFOP_CO], COOUTMAX);
+  CHECK(worst[SWFOP_MUL64] <= COOUTMAX * CRITOPMUL64);
+  CHECK(worst[SWFOP_SHIFT64] <= COOUTMAX * CRITOPSHIFT64);
+  CHECK(worst[SWFOP_ALU64] <= COOUTMAX * CRITOPALU64 + 1);
+  uint32_t cycles = worst[SWFOP_MUL64] * CRITCYCMUL64 + worst[SWFOP_SHIFT64] * CRITCYCSHIFT64 +
+                    worst[SWFOP_ALU64] * CRITCYCALU64 + worst[SWFOP_CO] * CRITCYCCO;
+  CHECK(cycles <= CRITWCETCYCLES(COOUTMAX));
+  printf("  worst: cos=%d mul64=%lu shift64=%lu alu64=%lu -> %lu cycles (bound %lu cycles, %lu us at %d MHz)\n",
+         COOUTMAX, (unsigned long)worst[SWFOP_MUL64], (unsigned long)worst[SWFOP_SHIFT64],
+         (unsigned long)worst[SWFOP_ALU64], (unsigned long)cycles, (unsigned long)CRITWCETCYCLES(COOUTMAX),
+         (unsigned long)CRITWCETUS(COOUTMAX), CRITCPUMHZ);
+}
+
+// どのSWF設定/dataでも1 COあたりの演算数はCRITOPxxx以下
+static uint64_t rng = 88172645463325252ULL;
+static uint64_t nextRand() {
+  rng ^= rng << 13;
+  rng ^= rng >> 7;
+  rng ^= rng << 17;
+  return rng;
+}
+
+static void testOpBound() {
+  comparatorOutputState out;
+  resetOut(out);
+  uint32_t checked = 0;
+  for (int n = 0; n < 200000; n++) {
+    SoftwareFilter swf;
+    memset(&swf, 0, sizeof(swf));
+    swf.canID = 0x123;
+    swf.onoff = 1;
+    swf.sign = nextRand() & 1;
+    swf.byteOrder = nextRand() & 1;
+    swf.startByte = nextRand() & 7;
+    swf.startBit = nextRand() & 7;
+    swf.endByte = nextRand() & 7;
+    swf.endBit = nextRand() & 7;
+    swf.factorMul = (nextRand() & 3) ? (uint16_t)nextRand() : 1;
+    swf.factorDiv = (nextRand() & 3) ? (uint16_t)nextRand() : 1;
+    if (swf.factorDiv == 0) swf.factorDiv = 1;
+    swf.offset = (int32_t)nextRand();
+    if (nextRand() & 1) {
+      swf.muxEndByte = nextRand() & 7;
+      swf.muxEndBit = nextRand() & 7;
+      swf.muxLen = 1 + nextRand() % SWFMUXLENMAX;
+    }
+    criticalComparator crit;
+    uint8_t len;
+    if (!compileSwfPlan(crit.swf, swf, 0, &len)) continue;
+    initPlan(crit.co, 0, (int64_t)nextRand(), nextRand() & 0xFFFF, nextRand() % COLMCOUNT);
+    crit.outSet = &outSetReg[0];
+    crit.outClr = &outClrReg[0];
+    crit.swf.muxValue = 0;                    // 下のdataでmuxを一致させる
+    canMessageSet msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.id = 0x123;
+    msg.len = 8;
+    uint64_t data = nextRand();
+    if (crit.swf.muxMask != 0) {              // mux fieldを0にして必ず抽出まで通す
+      uint64_t bits = (uint64_t)crit.swf.muxMask << crit.swf.muxShift;
+      if (crit.swf.intel) data &= ~bits;
+      else data &= ~__builtin_bswap64(bits);
+    }
+    memcpy(msg.buf, &data, sizeof(data));
+    clearOps();
+    CHECK(runCriticalComparators(&crit, 1, msg, out));
+    CHECK_EQ(hostOpCount[SWFOP_CO], 1);
+    CHECK(hostOpCount[SWFOP_MUL64] <= CRITOPMUL64);
+    CHECK(hostOpCount[SWFOP_SHIFT64] <= CRITOPSHIFT64);
+    CHECK(hostOpCount[SWFOP_ALU64] <= CRITOPALU64 + 1);
+    checked++;
+  }
+  CHECK(checked > 10000);
+  printf("  random: plans=%lu\n", (unsigned long)checked);
+}
+
+int main() {
+  testLevelHysteresis();
+  testDelay();
+  testLatchToggle();
+  testKeepState();
+  testCriticalMismatch();
+  testCriticalKeepState();
+  testCriticalWorstCase();
+  testOpBound();
+  return TEST_RESULT("test_comparator");
+}
@@ -0,0 +1,234 @@
+// CanIdTable host test
+// 1. 満杯で新しいIDを受信したら、lastTimeが最も古いentryを追い出すこと
+//    hash slotが表の末尾から先頭へ折り返す同じhashのkeyで埋め、removeSlot()のback shiftを折り返しで通す
+// 2. 追い出す度に、残った全てのkeyが表引きで見つかり、entryとslotの数が合うこと
+// 3. DLC < 8 では変化byteの比較をDLCまでに限ること、DLCが変わればIDCHG_NEW
+// 4. 受信周期のmin/max/EWMA (timestampの折り返しを含む)
+#include "FL_idtable.h"
+#include "test_check.h"
+
+// FL_idtable.cppのhashOf()と同じ
+static uint16_t slotOf(uint32_t key) {
+  return (uint16_t)((key * 2654435761UL) >> 20) & IDHASHMASK;
+}
+
+static canMessageSet frameOf(uint32_t key, uint8_t len, uint8_t fill, uint32_t timestamp) {
+  canMessageSet m;
+  memset(&m, 0, sizeof(m));
+  m.id = key & ~IDKEY_EXT;
+  m.ext = (key & IDKEY_EXT) ? 1 : 0;
+  m.len = len;
+  memset(m.buf, fill, sizeof(m.buf));
+  m.timestamp = timestamp;
+  return m;
+}
+
+// 参照model: 表にあるはずのkeyとそのlastTime
+static uint32_t modelKey[IDTABLESIZE];
+static uint32_t modelTime[IDTABLESIZE];
+static uint16_t modelUsed;
+
+static int modelFind(uint32_t key) {
+  for (uint16_t i = 0; i < modelUsed; i++) if (modelKey[i] == key) return i;
+  return -1;
+}
+
+static int modelOldest(uint32_t now) {
+  int oldest = 0;
+  for (uint16_t i = 1; i < modelUsed; i++) {
+    if (now - modelTime[i] > now - modelTime[oldest]) oldest = i;
+  }
+  return oldest;
+}
+
+// 表の写しに同じdataで全keyを流し、どれも新規扱いにならないこと (slotを失ったkeyはIDCHG_NEWになる)
+// entryの集合がmodelと一致すること
+static void checkAllFound(const CanIdTable &table, uint32_t now) {
+  static CanIdTable copy;
+  copy = table;
+  CHECK_EQ(copy.getUsed(), modelUsed);
+  for (uint16_t n = 0; n < copy.getUsed(); n++) {
+    const canIdEntry &e = copy.getEntry(n);
+    int i = modelFind(e.key);
+    CHECK(i >= 0);
+    if (i >= 0) CHECK_EQ(e.lastTime, modelTime[i]);
+  }
+  uint32_t evicted = copy.getEvictedCount();
+  for (uint16_t i = 0; i < modelUsed; i++) {
+    const canIdEntry *e = nullptr;
+    for (uint16_t n = 0; n < copy.getUsed(); n++) if (copy.getEntry(n).key == modelKey[i]) e = &copy.getEntry(n);
+    if (e == nullptr) continue;         // 上でCHECK済み
+    canMessageSet m = frameOf(modelKey[i], e->dlc, e->data[0], now);
+    uint16_t changed = copy.update(m);
+    if (changed != 0) printf("  key %08lX slot %u: changed=%03X\n", (unsigned long)modelKey[i], slotOf(modelKey[i]), changed);
+    CHECK_EQ(changed, 0);
+  }
+  CHECK_EQ(copy.getUsed(), modelUsed);
+  CHECK_EQ(copy.getEvictedCount(), evicted);
+}
+
+// keyを受信してmodelも更新する。追い出しがあればmodelの最古と一致すること
+static void receive(CanIdTable &table, uint32_t key, uint32_t now) {
+  int i = modelFind(key);
+  uint32_t evicted = table.getEvictedCount();
+  int oldest = (i < 0 && modelUsed == IDTABLESIZE) ? modelOldest(now) : -1;
+  uint8_t oldestEntry = 0;
+  if (oldest >= 0) {
+    for (uint16_t n = 0; n < table.getUsed(); n++) if (table.getEntry(n).key == modelKey[oldest]) oldestEntry = n;
+  }
+  uint16_t changed = table.update(frameOf(key, 8, 0x5A, now));
+  if (i >= 0) {
+    CHECK_EQ(changed, 0);
+    modelTime[i] = now;
+    CHECK_EQ(table.getEvictedCount(), evicted);
+    return;
+  }
+  CHECK_EQ(changed, IDCHG_NEW);
+  if (oldest < 0) {
+    modelKey[modelUsed] = key;
+    modelTime[modelUsed++] = now;
+    CHECK_EQ(table.getEvictedCount(), evicted);
+    return;
+  }
+  // 最古のentryを再利用する
+  CHECK_EQ(table.getEvictedCount(), evicted + 1);
+  CHECK_EQ(table.getEntry(oldestEntry).key, key);
+  modelKey[oldest] = key;
+  modelTime[oldest] = now;
+  checkAllFound(table, now);
+}
+
+// 表の末尾 (IDHASHSIZE-2, -1) と先頭 (0, 1) にhashするkeyを集める
+static uint16_t collectKeys(uint32_t *keys, uint16_t max) {
+  uint16_t n = 0;
+  for (uint32_t id = 0; n < max && id < 0x20000000; id++) {
+    uint32_t key = (id < 0x800 && (id & 1)) ? id : (id | IDKEY_EXT);
+    uint16_t s = slotOf(key);
+    if (s >= IDHASHSIZE - 2 || s <= 1) keys[n++] = key;
+  }
+  return n;
+}
+
+static uint32_t rng = 2463534242UL;
+static uint32_t nextRand() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+static void testEviction() {
+  static CanIdTable table;
+  static uint32_t keys[4 * IDTABLESIZE];
+  uint16_t keyCount = collectKeys(keys, 4 * IDTABLESIZE);
+  CHECK_EQ(keyCount, 4 * IDTABLESIZE);
+  bool wrapHigh = false, wrapLow = false;
+  for (uint16_t i = 0; i < keyCount; i++) {
+    if (slotOf(keys[i]) == IDHASHSIZE - 1) wrapHigh = true;
+    if (slotOf(keys[i]) == 0) wrapLow = true;
+  }
+  CHECK(wrapHigh && wrapLow);
+
+  // 1. 先頭IDTABLESIZE個で満杯にし、残りを順に受信: 毎回最初の受信が最も古いkeyが出る
+  table.clear();
+  modelUsed = 0;
+  uint32_t now = 0xFFFF0000UL;          // 途中でtimestampが折り返す
+  for (uint16_t i = 0; i < IDTABLESIZE; i++) receive(table, keys[i], now += 1000);
+  CHECK_EQ(table.getUsed(), IDTABLESIZE);
+  checkAllFound(table, now);
+  for (uint16_t i = IDTABLESIZE; i < keyCount; i++) {
+    receive(table, keys[i], now += 1000);
+    CHECK_EQ(modelFind(keys[i - IDTABLESIZE]), -1);
+  }
+  CHECK_EQ(table.getEvictedCount(), keyCount - IDTABLESIZE);
+
+  // 2. 登録済みkeyの再受信を混ぜて最古の順を入れ替える
+  table.clear();
+  modelUsed = 0;
+  uint32_t evictions = 0;
+  for (uint32_t n = 0; n < 20000; n++) {
+    uint32_t key = keys[nextRand() % keyCount];
+    bool full = modelUsed == IDTABLESIZE;
+    bool known = modelFind(key) >= 0;
+    receive(table, key, now += 1 + nextRand() % 5000);
+    if (full && !known) evictions++;
+  }
+  CHECK_EQ(table.getEvictedCount(), evictions);
+  CHECK(evictions > 1000);
+  printf("  keys=%u evictions=%lu\n", keyCount, (unsigned long)evictions);
+}
+
+static void testChangedBytes() {
+  static CanIdTable table;
+  table.clear();
+  uint32_t key = 0x123;
+  canMessageSet m = frameOf(key, 3, 0, 1000);
+  uint8_t a[8] = {1, 2, 3, 9, 9, 9, 9, 9};
+  memcpy(m.buf, a, 8);
+  CHECK_EQ(table.update(m), IDCHG_NEW);
+  // DLC以降のbyteは変わっても数えない
+  uint8_t b[8] = {1, 5, 3, 7, 7, 7, 7, 7};
+  memcpy(m.buf, b, 8);
+  CHECK_EQ(table.update(m), 0x02);
+  uint8_t c[8] = {0, 5, 4, 0, 0, 0, 0, 0};
+  memcpy(m.buf, c, 8);
+  CHECK_EQ(table.update(m), 0x05);
+  // DLCが変わったら新規扱い
+  m.len = 4;
+  CHECK_EQ(table.update(m), IDCHG_NEW);
+  m.buf[3] = 1;
+  CHECK_EQ(table.update(m), 0x08);
+  m.len = 7;
+  CHECK_EQ(table.update(m), IDCHG_NEW);
+  m.buf[7] = 0x77;
+  CHECK_EQ(table.update(m), 0);
+  m.buf[6] = 0x66;
+  m.buf[7] = 0x00;
+  CHECK_EQ(table.update(m), 0x40);
+  // DLC 0はdataを比べない
+  m.len = 0;
+  CHECK_EQ(table.update(m), IDCHG_NEW);
+  memset(m.buf, 0xFF, 8);
+  CHECK_EQ(table.update(m), 0);
+  // DLC 8は最上位byteまで比べる
+  m.len = 8;
+  CHECK_EQ(table.update(m), IDCHG_NEW);
+  m.buf[7] = 0;
+  m.buf[0] = 0;
+  CHECK_EQ(table.update(m), 0x81);
+  // standardとextendedの同じIDは別のentry
+  m.ext = 1;
+  CHECK_EQ(table.update(m), IDCHG_NEW);
+  CHECK_EQ(table.getUsed(), 2);
+}
+
+static void testPeriod() {
+  static CanIdTable table;
+  table.clear();
+  uint32_t key = 0x1ABCDEF0 | IDKEY_EXT;
+  static const struct { uint32_t timestamp, ewma, min, max; } step[] = {
+    {0xFFFFF348UL, 0, 0, 0},            // 1回目は未計測
+    {0xFFFFF730UL, 1000, 1000, 1000},
+    {0xFFFFFF00UL, 1125, 1000, 2000},   // 1000 + (2000 - 1000) / 8
+    {0x000000F4UL, 1046, 500, 2000},    // 折り返しを跨いだ周期 500: 1125 + (-625 >> 3)
+    {0x000000F4UL, 915, 0, 2000},       // 同じ時刻 (周期0)
+    {0x00100000UL, 131842, 0, 1048332},
+  };
+  for (size_t i = 0; i < sizeof(step) / sizeof(step[0]); i++) {
+    table.update(frameOf(key, 2, 0x11, step[i].timestamp));
+    const canIdEntry &e = table.getEntry(0);
+    CHECK_EQ(e.count, i + 1);
+    CHECK_EQ(e.lastTime, step[i].timestamp);
+    CHECK_EQ(e.ewmaPeriod, step[i].ewma);
+    CHECK_EQ(e.minPeriod, step[i].min);
+    CHECK_EQ(e.maxPeriod, step[i].max);
+  }
+  CHECK_EQ(table.getUsed(), 1);
+}
+
+int main() {
+  testEviction();
+  testChangedBytes();
+  testPeriod();
+  return TEST_RESULT("test_idtable");
+}
@@ -0,0 +1,159 @@
+// LineFormatter host test
+// 1. put/putHex/putDec/putFixed の出力 (丸めて0になる負の値に符号を付けない)
+// 2. formatMsg1line()/formatMsg1line_filtered()の出力 ("0x"付きID、強調byteの文字位置)
+// 3. 受信frame毎の処理 (ID表更新/bus load積算/1行整形/表示待ち行列) でheapを一度も使わないこと
+//    (operator new/mallocを数える)
+#include "FL_linefmt.h"
+#include "FL_msgfmt.h"
+#include "FL_linequeue.h"
+#include "FL_idtable.h"
+#include "FL_busload.h"
+#include "test_check.h"
+#include <new>
+#include <math.h>
+
+// **************************************************************************************************************
+// heap allocation counter (glibc)
+// **************************************************************************************************************
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void *__libc_realloc(void *p, size_t size);
+extern "C" void __libc_free(void *p);
+
+static volatile unsigned long allocCount = 0;
+
+extern "C" void *malloc(size_t size) { allocCount++; return __libc_malloc(size); }
+extern "C" void *calloc(size_t n, size_t size) { allocCount++; return __libc_calloc(n, size); }
+extern "C" void *realloc(void *p, size_t size) { allocCount++; return __libc_realloc(p, size); }
+extern "C" void free(void *p) { __libc_free(p); }
+void *operator new(size_t size) { allocCount++; return __libc_malloc(size ? size : 1); }
+void *operator new[](size_t size) { allocCount++; return __libc_malloc(size ? size : 1); }
+void operator delete(void *p) noexcept { __libc_free(p); }
+void operator delete[](void *p) noexcept { __libc_free(p); }
+void operator delete(void *p, size_t) noexcept { __libc_free(p); }
+void operator delete[](void *p, size_t) noexcept { __libc_free(p); }
+
+#define CHECK_STR(f, s) do { \
+    if (strcmp((f).c_str(), s) != 0) { printf("%s:%d: \"%s\" != \"%s\"\n", __FILE__, __LINE__, (f).c_str(), s); checkFailed++; } \
+  } while (0)
+
+static void testFormat() {
+  LineFormatter f;
+  CHECK_STR(f, "");
+  f.putHex(0x1A5, 0);
+  f.put(' ');
+  f.putHex(0x7, 3);
+  f.put(' ');
+  f.putHex(0, 0);
+  CHECK_STR(f, "1A5 007 0");
+  f.clear();
+  f.putDec((uint32_t)4294967295UL);
+  f.put(' ');
+  f.putDec((int32_t)INT32_MIN);
+  f.put(' ');
+  f.putDec((uint32_t)42, 5, '0');
+  CHECK_STR(f, "4294967295 -2147483648 00042");
+
+  static const struct { double value; uint8_t decimals; const char *str; } fixed[] = {
+    {0.0, 3, "0.000"}, {-0.0, 3, "0.000"}, {-0.0004, 3, "0.000"}, {-0.0005, 3, "-0.001"},
+    {0.0004, 3, "0.000"}, {-0.4, 0, "0"}, {-0.6, 0, "-1"}, {1.25, 1, "1.3"}, {-12.345, 2, "-12.35"},
+    {99.996, 2, "100.00"}, {-0.004, 2, "0.00"}, {4294967294.0, 0, "4294967294"},
+    {5e9, 2, "ovf"}, {-5e9, 2, "-ovf"}, {NAN, 2, "nan"},
+  };
+  for (size_t i = 0; i < sizeof(fixed) / sizeof(fixed[0]); i++) {
+    f.clear();
+    f.putFixed(fixed[i].value, fixed[i].decimals);
+    CHECK_STR(f, fixed[i].str);
+  }
+
+  // LINEFMTSIZEを超えた文字は捨てる
+  f.clear();
+  for (int i = 0; i < LINEFMTSIZE + 10; i++) f.put('x');
+  CHECK_EQ(f.length(), LINEFMTSIZE);
+  f.put("yy");
+  f.putHex(0xFFFFFFFF, 8);
+  CHECK_EQ(f.length(), LINEFMTSIZE);
+  CHECK_EQ(strlen(f.c_str()), LINEFMTSIZE);
+}
+
+// formatMsg1line()/formatMsg1line_filtered()の出力
+static void testMsgFormat() {
+  LineFormatter line;
+  canMessageSet msg = {0x1A5, 0, 3, 0, {0x00, 0x0F, 0xAB}, 12345678};
+  CHECK_EQ(formatMsg1line(msg, line, 0, false), 0);
+  CHECK_STR(line, "000001A5 Msg: 0 F AB ");
+  // buf[0]とbuf[2]を強調: "12.345 000001A5 Msg: " = 21文字
+  uint64_t hl = formatMsg1line(msg, line, 0x05, true);
+  CHECK_STR(line, "12.345 000001A5 Msg: 0 F AB ");
+  CHECK_EQ(hl, ((uint64_t)1 << 21) | ((uint64_t)3 << 25));
+  msg.len = 0;
+  CHECK_EQ(formatMsg1line(msg, line, 0xFF, false), 0);
+  CHECK_STR(line, "000001A5 Msg: ");
+
+  formatMsg1line_filtered(msg, line, 10, -1234, 2, true, false);
+  CHECK_STR(line, "0x000001A5 SWFA: -1234");
+  formatMsg1line_filtered(msg, line, 1, -1, 2, false, false);
+  CHECK_STR(line, "0x000001A5 SWF1: FFFF");
+  formatMsg1line_filtered(msg, line, 1, 0x1FF, 1, false, false);
+  CHECK_STR(line, "0x000001A5 SWF1: FF");
+  formatMsg1line_filtered(msg, line, 1, 0x12345678, 8, false, false);
+  CHECK_STR(line, "0x000001A5 SWF1: 12345678");
+  formatMsg1line_filtered(msg, line, 1, (int64_t)0x100000000LL + 0xAB, 8, false, false);
+  CHECK_STR(line, "0x000001A5 SWF1: 1000000AB");
+  formatMsg1line_filtered(msg, line, 2, (int64_t)1 << 40, 8, true, true);   // int32を超える物理値は16進
+  CHECK_STR(line, "12.345 0x000001A5 SWF2: 10000000000");
+}
+
+// processRxFrames()の受信frame毎の処理: ID表/bus load/1行整形/表示待ち行列
+static uint32_t formatFrameLoop(uint32_t frames) {
+  static CanIdTable idTable;
+  static BusLoadMeter busLoad;
+  static DisplayLineQueue lineQueue;
+  LineFormatter line;
+  uint32_t chars = 0;
+  busLoad.setBitrate(500000);
+  for (uint32_t n = 0; n < frames; n++) {
+    canMessageSet msg;
+    msg.id = (n & 4) ? 0x10000000 + (n & 0x3FF) * 0x1235 : 0x100 + (n & 0x3FF);
+    msg.ext = (n >> 2) & 1;
+    msg.len = n % 9;
+    msg.filhit = 0;
+    for (int i = 0; i < 8; i++) msg.buf[i] = (uint8_t)(n * 31 + i * 7);
+    msg.timestamp = n * 237;
+    uint16_t changed = idTable.update(msg);
+    busLoad.addFrame(msg);
+    uint64_t hlChars = 0;
+    if (n & 1) {
+      hlChars = formatMsg1line(msg, line, changed & ~IDCHG_NEW, (n & 2) != 0);
+    }
+    else {
+      formatMsg1line_filtered(msg, line, n & 0x3F, (int64_t)n * 2654435761LL - 0x7000000000LL, n % 9, (n & 8) != 0, true);
+    }
+    lineQueue.push(line.c_str(), line.length(), 0xFFFF, hlChars);
+    if (n % 3 == 0) {               // 描画が追いつかず時々満杯になる
+      const queuedLine *q = lineQueue.peek();
+      if (q != nullptr) lineQueue.pop();
+    }
+    if (n % 1000 == 999) busLoad.update(msg.timestamp, 0);
+    chars += line.length();
+  }
+  CHECK(lineQueue.getDropCount() > 0);
+  CHECK(busLoad.getLoadPermille() > 0);
+  return chars;
+}
+
+int main() {
+  testFormat();
+  testMsgFormat();
+  unsigned long before = allocCount;
+  int *probe = new int(1);                      // counterが効いていること
+  CHECK_EQ(allocCount - before, 1);
+  delete probe;
+  before = allocCount;
+  uint32_t chars = formatFrameLoop(100000);
+  unsigned long allocs = allocCount - before;
+  CHECK(chars > 0);
+  CHECK_EQ(allocs, 0);
+  printf("  frames=100000 chars=%lu heap_allocs=%lu\n", (unsigned long)chars, allocs);
+  return TEST_RESULT("test_linefmt");
+}
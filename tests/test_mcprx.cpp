@@ -0,0 +1,173 @@
+// MCP25625 RX order host test (模擬MCP25625はfake_mcp.h)
+// 1. RXF2-5のRXB1直行を含む受信列で、RX STATUS毎に読む順序 (MCP_RX_DMA 1) が受信順であること
+// 2. ランダムな受信/ISRの順序で、受信順と違う順に読むのは
+//    「前のRX STATUSの後に両方のRXバッファが埋まり、RXB1 (直行) の方が先」の場合だけであること
+//    RXF0/1だけ (BUKT rollover) なら常に受信順であること
+// 3. readMsgBatch() (MCP_RX_DMA 0) も同じ
+// 4. 読んだフレームのfilter hitが正しいこと (模擬MCPのRX STATUS bit2-0は最後に受信したバッファのもの)
+#include "fake_mcp.h"
+#include "test_check.h"
+
+static mcp25625_can CAN(PIN_MCP_CS);
+static uint32_t arriveSeq = 0;
+static uint32_t bufSeq[2];          // RXBnのフレームの受信番号
+static bool bufSeen[2];             // RXBnの受信後にRX STATUSを読んだ
+
+static uint32_t seqOf(const canMessageSet &m) {
+  uint32_t seq;
+  memcpy(&seq, &m.buf[1], 4);
+  return seq;
+}
+
+static bool arrive(uint8_t filhit) {
+  canMessageSet m;
+  memset(&m, 0, sizeof(m));
+  m.id = arriveSeq & 0x7FF;
+  m.len = 5;
+  m.buf[0] = filhit;
+  memcpy(&m.buf[1], &arriveSeq, 4);
+  int n = (filhit >= 2 || mcp.full[0]) ? 1 : 0;
+  if (!mcpReceive(m, filhit)) return false;
+  bufSeq[n] = arriveSeq++;
+  bufSeen[n] = false;
+  return true;
+}
+
+// RX STATUSを読む直前: 受信順が分からない場合か
+static bool ambiguous() {
+  return mcp.full[0] && mcp.full[1] && !bufSeen[0] && !bufSeen[1] && bufSeq[1] < bufSeq[0];
+}
+
+static uint32_t oldest() {
+  if (mcp.full[0] && mcp.full[1]) return bufSeq[0] < bufSeq[1] ? bufSeq[0] : bufSeq[1];
+  return mcp.full[0] ? bufSeq[0] : bufSeq[1];
+}
+
+// MCP_RX_DMA 1: RX STATUS 1回でRXバッファ1個を読む。戻り値 false:空
+static bool readOne(uint32_t *seq, uint8_t *filhit, bool *fAmbiguous) {
+  *fAmbiguous = ambiguous();
+  uint32_t expect = oldest();
+  byte instruction = CAN.selectRxBuffer(CAN.readRxStatus(), filhit);
+  bufSeen[0] = bufSeen[1] = true;
+  if (instruction == 0) return false;
+  uint8_t dst[MCP_RXBUF_RAWLEN + 1];
+  digitalWrite(PIN_MCP_CS, LOW);
+  dst[0] = SPI.transfer(instruction);
+  for (int i = 1; i <= MCP_RXBUF_RAWLEN; i++) dst[i] = SPI.transfer(0);
+  digitalWrite(PIN_MCP_CS, HIGH);
+  canMessageSet m;
+  CAN.parseRxBuffer(&dst[1], &m);
+  *seq = seqOf(m);
+  CHECK_EQ(*seq, (instruction == MCP_READ_RX0) ? bufSeq[0] : bufSeq[1]);
+  CHECK_EQ(*filhit, m.buf[0]);
+  if (!*fAmbiguous) CHECK_EQ(*seq, expect);
+  return true;
+}
+
+static void resetMcp() {
+  memset(&mcp, 0, sizeof(mcp));
+  CAN.selectRxBuffer(0, NULL);                // 空のRX STATUSで順序の状態を初期化
+  arriveSeq = 0;
+}
+
+// RXB1に直行したフレームが残っている間にRXB0が埋まれば、RXB1の方が古い
+static void testDirectHit() {
+  resetMcp();
+  uint32_t seq;
+  uint8_t filhit;
+  bool fAmb;
+  CHECK(arrive(0));                           // #0 RXF0 -> RXB0
+  CHECK(arrive(2));                           // #1 RXF2 -> RXB1
+  CHECK(readOne(&seq, &filhit, &fAmb));       // 両方埋まった: RXB0が先
+  CHECK_EQ(seq, 0);
+  CHECK(arrive(1));                           // #2 RXF1 -> RXB0
+  CHECK(readOne(&seq, &filhit, &fAmb));       // RXB1は前のRX STATUSから残っている
+  CHECK_EQ(seq, 1);
+  CHECK(arrive(5));                           // #3 RXF5 -> RXB1
+  CHECK(readOne(&seq, &filhit, &fAmb));
+  CHECK_EQ(seq, 2);
+  CHECK(arrive(0));                           // #4 RXF0 -> RXB0
+  CHECK(readOne(&seq, &filhit, &fAmb));
+  CHECK_EQ(seq, 3);
+  CHECK_EQ(filhit, 5);
+  CHECK(readOne(&seq, &filhit, &fAmb));
+  CHECK_EQ(seq, 4);
+  CHECK(!readOne(&seq, &filhit, &fAmb));
+  // rollover: RXB0が満杯の間のRXF0/1はRXB1へ
+  CHECK(arrive(1));                           // #5 RXB0
+  CHECK(arrive(0));                           // #6 RXB1 (rollover)
+  CHECK(!arrive(0));                          // overrun
+  CHECK(readOne(&seq, &filhit, &fAmb));
+  CHECK_EQ(seq, 5);
+  CHECK(readOne(&seq, &filhit, &fAmb));
+  CHECK_EQ(seq, 6);
+  CHECK_EQ(filhit, 0);
+}
+
+static uint32_t rng = 1;
+static uint32_t nextRand() {
+  rng = rng * 1103515245 + 12345;
+  return rng >> 8;
+}
+
+// 受信とISRをランダムに並べる。direct: RXF2-5も使う batch: readMsgBatch() (RX STATUS 1回で2個まで)
+// 受信順が分からずに新しい方を先に読んだ場合、残った古い方は遅れて読まれる (それ以外は受信順)
+static void testRandom(bool direct, bool batch) {
+  resetMcp();
+  rng = direct ? 3 : 5;
+  uint32_t next = 0, readCount = 0, ambiguousCount = 0, outOfOrder = 0;
+  bool late[2] = {false, false};              // RXBnの古いフレームが後回しになった
+  for (int n = 0; n < 200000; n++) {
+    if (nextRand() % 3 != 0) {
+      arrive(direct ? nextRand() % 6 : nextRand() % 2);
+      continue;
+    }
+    bool fAmb = ambiguous();
+    if (fAmb) ambiguousCount++;
+    uint32_t seq[2];
+    int got = 0;
+    if (batch) {
+      canMessageSet out[2];
+      got = CAN.readMsgBatch(out, 2);
+      bufSeen[0] = bufSeen[1] = true;
+      for (int i = 0; i < got; i++) seq[i] = seqOf(out[i]);
+    }
+    else {
+      uint8_t filhit;
+      bool f;
+      if (readOne(&seq[0], &filhit, &f)) got = 1;
+    }
+    for (int i = 0; i < got; i++) {
+      readCount++;
+      int b = (seq[i] == bufSeq[0]) ? 0 : 1;
+      if (seq[i] >= next) {
+        if (seq[i] > next) {                  // 古いフレームを飛ばした
+          outOfOrder++;
+          CHECK(fAmb);
+          late[1 - b] = true;
+        }
+        next = seq[i] + 1;
+      }
+      else {
+        CHECK(late[b]);                       // 飛ばされた古い方だけが遅れる
+        late[b] = false;
+      }
+    }
+  }
+  if (!direct) CHECK_EQ(ambiguousCount, 0);
+  if (!direct) CHECK_EQ(outOfOrder, 0);
+  CHECK(readCount > 50000);
+  printf("  %s %s: read=%lu ambiguous=%lu out_of_order=%lu\n", direct ? "rxf0-5" : "rxf0-1",
+         batch ? "batch" : "dma  ", (unsigned long)readCount, (unsigned long)ambiguousCount,
+         (unsigned long)outOfOrder);
+}
+
+int main() {
+  hostPinHook = mcpPin;
+  testDirectHit();
+  testRandom(false, false);
+  testRandom(true, false);
+  testRandom(false, true);
+  testRandom(true, true);
+  return TEST_RESULT("test_mcprx");
+}
@@ -0,0 +1,120 @@
+// RuleProgram host test
+// 1. 文法: 入れ子の上限 (RULENESTMAX), Snnは10進のみ, Snnのないruleはエラー, エラー位置
+// 2. eval()の結果を式をそのまま計算した値と比べる
+// 3. isSameCode(): 空白の違いは同じ、定数/比較/SWF番号の違いは別
+#include "FL_rulevm.h"
+#include "test_check.h"
+
+#define SWFN    64
+
+static int compileRule(const char *text) {
+  RuleProgram rule;
+  return rule.compile(text, SWFN);
+}
+
+// "(" * n + "S1>1" + ")" * n
+static int compileNested(char open, int n) {
+  char text[64];
+  int len = 0;
+  for (int i = 0; i < n; i++) text[len++] = open;
+  len += sprintf(&text[len], "S1>1");
+  if (open == '(') {
+    for (int i = 0; i < n; i++) text[len++] = ')';
+  }
+  text[len] = '\0';
+  return compileRule(text);
+}
+
+static void testGrammar() {
+  CHECK_EQ(compileRule(""), 0);
+  CHECK_EQ(compileRule("  "), 0);
+  CHECK_EQ(compileRule("S1 > 3000"), 0);
+  CHECK_EQ(compileRule("s63>=-1 && S0 != 0x7FFFFFFF || !(S2 < -2147483648)"), 0);
+
+  // RULENESTMAX個までの ( と ! はOK、比較式自体は数えない
+  CHECK_EQ(compileNested('(', RULENESTMAX), 0);
+  CHECK_EQ(compileNested('(', RULENESTMAX + 1), RULENESTMAX + 1);
+  CHECK_EQ(compileNested('!', RULENESTMAX), 0);
+  CHECK_EQ(compileNested('!', RULENESTMAX + 1), RULENESTMAX + 1);
+  CHECK_EQ(compileRule("((((((((S1>1))))))))"), 0);
+  CHECK_EQ(compileRule("!(!(!(!(S1>1))))"), 0);
+  // 並んだ括弧は入れ子ではない
+  CHECK_EQ(compileRule("(((S1>1))) & (((S2>1))) & (((S3>1))) & (((S4>1)))"), 0);
+
+  // Snnは10進のみ
+  CHECK_EQ(compileRule("S0x3 > 1"), 3);
+  CHECK_EQ(compileRule("S-1 > 1"), 2);
+  CHECK_EQ(compileRule("S > 1"), 3);
+  CHECK_EQ(compileRule("S64 > 1"), 3);
+  CHECK_EQ(compileRule("S063 > 1"), 0);
+  CHECK_EQ(compileRule("S1 > 0x10"), 0);              // 定数は16進可
+
+  // Snnを含まないrule
+  CHECK_EQ(compileRule("1 > 0"), 1);
+  CHECK_EQ(compileRule("(1 == 1) | !(2 < 3)"), 1);
+
+  // その他のエラー位置 (1文字目から)
+  CHECK_EQ(compileRule("S1 >"), 5);
+  CHECK_EQ(compileRule("S1 > 1 )"), 8);
+  CHECK_EQ(compileRule("(S1 > 1"), 8);
+  CHECK_EQ(compileRule("S1 = 1"), 4);
+  CHECK_EQ(compileRule("S1 > 2147483648"), 16);
+
+  RuleProgram rule;
+  CHECK_EQ(rule.compile("S1>1 & S5<2 | S63==0", SWFN), 0);
+  CHECK(rule.isValid());
+  CHECK(rule.getInputs() == (((uint64_t)1 << 1) | ((uint64_t)1 << 5) | ((uint64_t)1 << 63)));
+  CHECK_EQ(rule.compile("S10 > 1", 10), 3);          // swfCount外
+  CHECK(!rule.isValid());
+  CHECK(rule.getInputs() == 0);
+}
+
+static void testEval() {
+  int64_t v[SWFN] = {};
+  RuleProgram rule;
+  CHECK_EQ(rule.compile("(S1 > 3000 & S2 == 5) | S3 > 105", SWFN), 0);
+  for (int64_t s1 = 2999; s1 <= 3001; s1++) {
+    for (int64_t s2 = 4; s2 <= 6; s2++) {
+      for (int64_t s3 = 104; s3 <= 106; s3++) {
+        v[1] = s1;
+        v[2] = s2;
+        v[3] = s3;
+        CHECK_EQ(rule.eval(v), (s1 > 3000 && s2 == 5) || s3 > 105);
+      }
+    }
+  }
+  CHECK_EQ(rule.compile("!(S0 < -100000) && S0 <= 0x7FFFFFFF", SWFN), 0);
+  static const int64_t values[] = {INT64_MIN, -100001, -100000, 0, INT32_MAX, (int64_t)INT32_MAX + 1, INT64_MAX};
+  for (int64_t x : values) {
+    v[0] = x;
+    CHECK_EQ(rule.eval(v), !(x < -100000) && x <= INT32_MAX);
+  }
+  CHECK_EQ(compileNested('!', RULENESTMAX), 0);
+  CHECK_EQ(rule.compile("!!!!!!!!S1>1", SWFN), 0);
+  v[1] = 2;
+  CHECK(rule.eval(v));
+  CHECK_EQ(rule.compile("!!!!!!!S1>1", SWFN), 0);
+  CHECK(!rule.eval(v));
+}
+
+static void testSameCode() {
+  RuleProgram a, b;
+  CHECK(a.isSameCode(b));                   // どちらもruleなし
+  CHECK_EQ(a.compile("S1 > 3000 & S2 == 5", SWFN), 0);
+  CHECK(!a.isSameCode(b));
+  CHECK_EQ(b.compile("S1>3000&&S2==5", SWFN), 0);
+  CHECK(a.isSameCode(b));
+  CHECK_EQ(b.compile("S1 > 3001 & S2 == 5", SWFN), 0);
+  CHECK(!a.isSameCode(b));
+  CHECK_EQ(b.compile("S1 >= 3000 & S2 == 5", SWFN), 0);
+  CHECK(!a.isSameCode(b));
+  CHECK_EQ(b.compile("S1 > 3000 & S3 == 5", SWFN), 0);
+  CHECK(!a.isSameCode(b));
+}
+
+int main() {
+  testGrammar();
+  testEval();
+  testSameCode();
+  return TEST_RESULT("test_rulevm");
+}
@@ -0,0 +1,129 @@
+// SWF extraction exhaustive differential test
+// 全Start/End位置 x Motorola/Intel x signed/unsigned x 複数のpayloadについて、
+// compileSwfPlan() + extractSwfValue() を1bitずつ辿る参照実装と比べる
+#include "FL_swfplan.h"
+#include "test_check.h"
+
+// 参照実装: msg dataのbyte/bitを (byte, bit7..0) で辿る
+// Motorola: bit0の次(下位)は次のbyteのbit7, Intel: bit0の次(下位)は前のbyteのbit7
+// 戻り値 bit長 0:位置エラー
+static int refExtract(const uint8_t *buf, bool intel, int startByte, int startBit,
+                      int endByte, int endBit, bool sign, int64_t *value) {
+  uint64_t v = 0;
+  int byte = startByte, bit = startBit, len = 0;
+  for (;;) {
+    if (byte < 0 || byte > 7) return 0;
+    v = (v << 1) | ((buf[byte] >> bit) & 1);
+    len++;
+    if (byte == endByte && bit == endBit) break;
+    if (--bit < 0) {
+      bit = 7;
+      byte += intel ? -1 : 1;
+    }
+  }
+  if (sign && len < 64 && (v >> (len - 1)) & 1) v |= ~(uint64_t)0 << len;
+  *value = (int64_t)v;
+  return len;
+}
+
+static uint32_t rng = 1;
+static uint8_t nextByte() {
+  rng = rng * 1103515245 + 12345;
+  return (uint8_t)(rng >> 16);
+}
+
+#define PAYLOADCOUNT    12
+
+int main() {
+  uint8_t payload[PAYLOADCOUNT][8];
+  memset(payload[0], 0x00, 8);
+  memset(payload[1], 0xFF, 8);
+  memset(payload[2], 0xAA, 8);
+  memset(payload[3], 0x55, 8);
+  for (int i = 0; i < 8; i++) payload[4][i] = (uint8_t)(1 << i);
+  for (int i = 0; i < 8; i++) payload[5][i] = (uint8_t)(0x80 >> i);
+  for (int p = 6; p < PAYLOADCOUNT; p++) {
+    for (int i = 0; i < 8; i++) payload[p][i] = nextByte();
+  }
+
+  uint32_t cases = 0, valid = 0;
+  for (int intel = 0; intel <= 1; intel++) {
+    for (int sign = 0; sign <= 1; sign++) {
+      for (int start = 0; start < 64; start++) {
+        for (int end = 0; end < 64; end++) {
+          SoftwareFilter swf;
+          memset(&swf, 0, sizeof(swf));
+          swf.canID = 0x123;
+          swf.onoff = 1;
+          swf.sign = sign;
+          swf.byteOrder = intel ? SWFBO_INTEL : SWFBO_MOTOROLA;
+          swf.startByte = start >> 3;
+          swf.startBit = start & 7;
+          swf.endByte = end >> 3;
+          swf.endBit = end & 7;
+          canSoftwareFilterPlan plan;
+          uint8_t valueLen = 0;
+          bool ok = compileSwfPlan(plan, swf, 5, &valueLen);
+          int64_t ref;
+          int refLen = refExtract(payload[0], intel, start >> 3, start & 7, end >> 3, end & 7, sign, &ref);
+          CHECK_EQ(ok, refLen != 0);
+          cases++;
+          if (!ok || refLen == 0) continue;
+          valid++;
+          uint8_t byteLen, bitLen;
+          CHECK(swfFieldLen(swf, &byteLen, &bitLen));
+          CHECK_EQ(bitLen, refLen);
+          CHECK(byteLen * 8 >= bitLen && (byteLen == 1 || byteLen == 2 || byteLen == 4 || byteLen == 8));
+          CHECK_EQ(valueLen, byteLen);
+          CHECK_EQ(plan.scaled, 0);
+          CHECK_EQ(plan.id, 0x123);
+          CHECK_EQ(plan.swfNum, 5);
+          for (int p = 0; p < PAYLOADCOUNT; p++) {
+            uint64_t data[2];
+            data[SWFBO_INTEL] = loadMsgData64(payload[p]);
+            data[SWFBO_MOTOROLA] = __builtin_bswap64(data[SWFBO_INTEL]);
+            refExtract(payload[p], intel, start >> 3, start & 7, end >> 3, end & 7, sign, &ref);
+            int64_t got = extractSwfValue(plan, data);
+            if (got != ref) {
+              printf("intel=%d sign=%d start=%d end=%d payload=%d: got %llx ref %llx\n", intel, sign, start, end, p,
+                     (unsigned long long)got, (unsigned long long)ref);
+              checkFailed++;
+            }
+          }
+        }
+      }
+    }
+  }
+  // 有効な組合せ: 各byte orderで msb >= lsb になる 64*65/2 通り x signed/unsigned
+  CHECK_EQ(valid, 2 * 2 * 64 * 65 / 2);
+
+  // multiplexor: SWFと同じbyte orderで切り出す。64bitを超える位置はエラー
+  SoftwareFilter swf;
+  memset(&swf, 0, sizeof(swf));
+  swf.byteOrder = SWFBO_MOTOROLA;
+  swf.startByte = 1;
+  swf.startBit = 7;
+  swf.endByte = 1;
+  swf.endBit = 0;
+  swf.muxLen = 8;
+  swf.muxEndByte = 0;
+  swf.muxEndBit = 0;
+  swf.muxValue = 0x1A5;
+  canSoftwareFilterPlan plan;
+  uint8_t valueLen;
+  CHECK(compileSwfPlan(plan, swf, 0, &valueLen));
+  CHECK_EQ(plan.muxMask, 0xFF);
+  CHECK_EQ(plan.muxValue, 0xA5);
+  uint8_t buf[8] = {0xA5, 0x3C, 0, 0, 0, 0, 0, 0};
+  uint64_t data[2];
+  data[SWFBO_INTEL] = loadMsgData64(buf);
+  data[SWFBO_MOTOROLA] = __builtin_bswap64(data[SWFBO_INTEL]);
+  CHECK_EQ((data[plan.intel] >> plan.muxShift) & plan.muxMask, 0xA5);
+  CHECK_EQ(extractSwfValue(plan, data), 0x3C);
+  swf.muxEndByte = 0;
+  swf.muxEndBit = 7;                        // Motorola bit63から8bit -> 64bitを超える
+  CHECK(!compileSwfPlan(plan, swf, 0, &valueLen));
+
+  printf("  cases=%lu valid=%lu payloads=%d\n", (unsigned long)cases, (unsigned long)valid, PAYLOADCOUNT);
+  return TEST_RESULT("test_swfextract");
+}
@@ -0,0 +1,101 @@
+// SWF fixed-point scaling error bound test
+// compileSwfScale() + scaleSwfValue() を raw * factorMul / factorDiv + offset の正確な値と比べる
+// 参照値は__int128の有理数で持ち、doubleでは丸められる64bit rawでも誤差を正しく測る
+// 誤差の上限: 1/2 (四捨五入) + |raw| / 2^(scaleShift+1) (scaleMulの丸め)
+// scaleMul >= 2^29 なので、丸めを除いたraw * factorの相対誤差は約2^-30 (1e-9) 以下
+// int64を超える値はINT64_MIN/INT64_MAXに飽和すること
+#include "FL_swfplan.h"
+#include "test_check.h"
+
+typedef __int128 i128;
+
+static uint64_t rng = 88172645463325252ULL;
+static uint64_t nextRand() {
+  rng ^= rng << 13;
+  rng ^= rng >> 7;
+  rng ^= rng << 17;
+  return rng;
+}
+
+static i128 absi(i128 v) { return v < 0 ? -v : v; }
+
+static uint32_t checked = 0, saturated = 0;
+static long double maxErr = 0, maxErrRel = 0;
+
+static void checkScale(int64_t raw, uint16_t mul, uint16_t div, int32_t offset) {
+  SoftwareFilter swf;
+  memset(&swf, 0, sizeof(swf));
+  swf.factorMul = mul;
+  swf.factorDiv = div;
+  swf.offset = offset;
+  canSoftwareFilterPlan plan;
+  compileSwfScale(plan, swf);
+  if (!plan.scaled) {
+    CHECK(div == 0 || (mul == div && offset == 0));
+    return;
+  }
+  CHECK(plan.scaleShift <= 62);
+  CHECK(plan.scaleMul >= 0 && plan.scaleMul < (1 << 30));
+  CHECK(mul == 0 || plan.scaleMul >= (1 << 29));            // factorの相対誤差 <= 2^-30
+  int64_t got = scaleSwfValue(raw, plan);
+  // exact = exactNum / div
+  i128 exactNum = (i128)raw * mul + (i128)offset * div;
+  i128 lo = (i128)INT64_MIN * div, hi = (i128)INT64_MAX * div;
+  i128 clamped = exactNum < lo ? lo : (exactNum > hi ? hi : exactNum);
+  if (exactNum != clamped) saturated++;
+  // |got - exact| * div * 2^(sh+1) <= div * (2^sh + |raw|)
+  i128 diff = absi((i128)got * div - clamped) << (plan.scaleShift + 1);
+  i128 bound = (i128)div * (((i128)1 << plan.scaleShift) + absi(raw));
+  if (diff > bound) {
+    printf("raw=%lld mul=%u div=%u offset=%d: got %lld exact %.3Lf\n", (long long)raw, mul, div, offset,
+           (long long)got, (long double)exactNum / div);
+    checkFailed++;
+  }
+  long double err = (long double)absi((i128)got * div - clamped) / div;
+  if (err > maxErr) maxErr = err;
+  // factorの誤差はraw * factorに比例する (offsetとの相殺や飽和は除く)
+  long double ref = (long double)absi((i128)raw * mul) / div;
+  if (exactNum == clamped && ref >= 1 && err > 0.5 && (err - 0.5) / ref > maxErrRel) maxErrRel = (err - 0.5) / ref;
+  checked++;
+}
+
+int main() {
+  static const uint16_t muls[] = {0, 1, 2, 3, 7, 10, 100, 999, 4095, 32768, 65534, 65535};
+  static const uint16_t divs[] = {0, 1, 2, 3, 7, 10, 100, 1000, 32768, 65534, 65535};
+  static const int32_t offsets[] = {0, 1, -1, -40, 1000, INT32_MAX, INT32_MIN};
+  static const int64_t edges[] = {
+    0, 1, -1, 2, -2, 127, -128, 255, 65535, -32768, INT32_MAX, INT32_MIN, (int64_t)UINT32_MAX,
+    (int64_t)1 << 32, -((int64_t)1 << 32), ((int64_t)1 << 32) - 1, ((int64_t)1 << 47), -((int64_t)1 << 47),
+    ((int64_t)1 << 62), -((int64_t)1 << 62), INT64_MAX, INT64_MIN, INT64_MAX - 1, INT64_MIN + 1,
+    INT64_MAX / 65535, INT64_MIN / 65535, INT64_MAX / 3, INT64_MIN / 3
+  };
+  for (uint16_t mul : muls) {
+    for (uint16_t div : divs) {
+      for (int32_t offset : offsets) {
+        for (int64_t raw : edges) checkScale(raw, mul, div, offset);
+        for (int n = 0; n < 300; n++) {
+          uint64_t r = nextRand();
+          switch (n % 3) {
+            case 0: checkScale((int64_t)r, mul, div, offset); break;                 // 64bit
+            case 1: checkScale((int32_t)r, mul, div, offset); break;                 // 32bit signed
+            default: checkScale((int64_t)(r & 0xFFFF), mul, div, offset); break;     // 16bit unsigned
+          }
+        }
+      }
+    }
+  }
+  // 2^32を跨ぐrawは上下32bitの分割の境目
+  for (int64_t raw = ((int64_t)1 << 32) - 1000; raw < ((int64_t)1 << 32) + 1000; raw++) checkScale(raw, 7, 3, -5);
+  for (int64_t raw = -((int64_t)1 << 32) - 1000; raw < -((int64_t)1 << 32) + 1000; raw++) checkScale(raw, 7, 3, -5);
+  // 飽和の境目 (mul/div > 1 で INT64_MAX/MIN 付近)
+  for (int n = -3000; n < 3000; n++) {
+    checkScale(INT64_MAX / 3 + n, 3, 1, 0);
+    checkScale(INT64_MIN / 3 + n, 3, 1, 0);
+    checkScale(INT64_MAX / 65535 * 2 + n * 65536LL, 65535, 2, 7);
+  }
+
+  CHECK(maxErrRel < 1.0 / ((1 << 30) - 1));    // 0.5 / (2^29 - 0.5)
+  printf("  checked=%lu saturated=%lu max_abs_err=%.3Lf max_factor_rel_err=%.3Le\n", (unsigned long)checked,
+         (unsigned long)saturated, maxErr, maxErrRel);
+  return TEST_RESULT("test_swfscale");
+}
@@ -0,0 +1,118 @@
+// SignalStats host test
+// update()の整数積算から求めたmean/varianceを、long doubleの2-pass計算の参照値と比べる
+// int64の全範囲 (差が65bit、二乗和が128bitを超える) でもvarianceが有効で正しいこと
+#include "FL_swfstats.h"
+#include "test_check.h"
+#include <math.h>
+
+static uint64_t rng = 88172645463325252ULL;
+static uint64_t nextRand() {
+  rng ^= rng << 13;
+  rng ^= rng >> 7;
+  rng ^= rng << 17;
+  return rng;
+}
+
+#define SAMPLEMAX       200000
+static int64_t samples[SAMPLEMAX];
+
+// 参照値: 平均を求めてから偏差の二乗和を取る (long doubleはint64を正確に表せる)
+struct refStats {
+  long double mean, var;
+  int64_t min, max;
+};
+
+static refStats refCalc(uint32_t n) {
+  refStats r = {0, 0, samples[0], samples[0]};
+  long double sum = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    sum += samples[i];
+    if (samples[i] < r.min) r.min = samples[i];
+    if (samples[i] > r.max) r.max = samples[i];
+  }
+  r.mean = sum / n;
+  long double m2 = 0;
+  for (uint32_t i = 0; i < n; i++) m2 += ((long double)samples[i] - r.mean) * ((long double)samples[i] - r.mean);
+  r.var = (n < 2) ? 0 : m2 / (n - 1);
+  return r;
+}
+
+static long double relErr(long double got, long double ref) {
+  long double e = fabsl(got - ref);
+  return (ref == 0) ? e : e / fabsl(ref);
+}
+
+static long double maxMeanErr = 0, maxVarErr = 0;
+
+// gen(i)の列をn個入れて比べる。meanの誤差はmax(|mean|, 標準偏差)に対する相対値で見る
+static void runCase(const char *name, uint32_t n, int64_t (*gen)(uint32_t)) {
+  if (n > SAMPLEMAX) n = SAMPLEMAX;
+  SignalStats st;
+  for (uint32_t i = 0; i < n; i++) {
+    samples[i] = gen(i);
+    st.update(samples[i], i * 100);             // 100us間隔 -> 10000 samples/s
+  }
+  refStats ref = refCalc(n);
+  CHECK_EQ(st.getCount(), n);
+  CHECK_EQ(st.getMin(), ref.min);
+  CHECK_EQ(st.getMax(), ref.max);
+  long double refVar = ref.var;
+  long double scale = fabsl(ref.mean);
+  if (sqrtl(refVar) > scale) scale = sqrtl(refVar);
+  long double meanErr = (scale == 0) ? fabsl(st.getMean() - ref.mean) : fabsl(st.getMean() - ref.mean) / scale;
+  long double varErr = relErr(st.getVariance(), refVar);
+  if (meanErr > 1e-12 || varErr > 1e-12) {
+    printf("%s: mean %.17Lg ref %.17Lg, var %.17Lg ref %.17Lg\n", name, (long double)st.getMean(), ref.mean,
+           (long double)st.getVariance(), refVar);
+    checkFailed++;
+  }
+  if (meanErr > maxMeanErr) maxMeanErr = meanErr;
+  if (varErr > maxVarErr) maxVarErr = varErr;
+  if (n >= 2) CHECK(fabs(st.getRate() - 10000.0) < 1e-6);
+}
+
+static int64_t genAlt2e9(uint32_t i) { return (i & 1) ? 2000000000LL : 0; }
+static int64_t genAltExtreme(uint32_t i) { return (i & 1) ? INT64_MAX : INT64_MIN; }
+static int64_t genAltExtremeRev(uint32_t i) { return (i & 1) ? INT64_MIN : INT64_MAX; }
+static int64_t genMaxThenMin(uint32_t i) { return (i == 0) ? INT64_MAX : INT64_MIN + (int64_t)(i % 7); }
+static int64_t genRand64(uint32_t) { return (int64_t)nextRand(); }
+static int64_t genRand40(uint32_t) { return (int64_t)nextRand() >> 24; }
+static int64_t genRand16(uint32_t) { return (int64_t)(nextRand() & 0xFFFF); }
+static int64_t genRpm(uint32_t i) { return 800 + (int64_t)(i % 6000) + (int64_t)(nextRand() & 0x3F); }
+static int64_t genOffset(uint32_t) { return 4000000000000LL + (int64_t)(nextRand() % 1000) - 500; }
+static int64_t genConst(uint32_t) { return -12345; }
+
+int main() {
+  // count < 2
+  SignalStats st;
+  CHECK_EQ(st.getCount(), 0);
+  CHECK(st.getMean() == 0 && st.getVariance() == 0 && st.getRate() == 0);
+  st.update(-7, 1000);
+  CHECK(st.getMean() == -7 && st.getVariance() == 0 && st.getRate() == 0);
+
+  runCase("alt 0/2e9", 100001, genAlt2e9);
+  runCase("alt int64 min/max", 100000, genAltExtreme);
+  runCase("alt int64 max/min", 99999, genAltExtremeRev);
+  runCase("max then min", 50000, genMaxThenMin);
+  runCase("random 64bit", 200000, genRand64);
+  runCase("random 40bit", 200000, genRand40);
+  runCase("random 16bit", 200000, genRand16);
+  runCase("rpm", 200000, genRpm);
+  runCase("large offset", 200000, genOffset);
+  runCase("const", 1000, genConst);
+
+  // timebaseの一周を跨いでもrateは正しい
+  SignalStats wrap;
+  for (uint32_t i = 0; i < 1000; i++) wrap.update(i, 0xFFFF0000UL + i * 1000);
+  CHECK(fabs(wrap.getRate() - 1000.0) < 1e-9);
+
+  // reset()で積算が消える
+  wrap.reset();
+  wrap.update(INT64_MIN, 0);
+  wrap.update(INT64_MAX, 10);
+  CHECK_EQ(wrap.getCount(), 2);
+  CHECK(relErr(wrap.getVariance(), ldexpl(1, 127)) < 1e-12);   // (2^64 - 1)^2 / 2
+
+  printf("  max_mean_rel_err=%.3Le max_var_rel_err=%.3Le\n", maxMeanErr, maxVarErr);
+  return TEST_RESULT("test_swfstats");
+}